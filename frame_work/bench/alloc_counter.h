@@ -0,0 +1,11 @@
+#pragma once
+
+#include <cstdint>
+
+namespace bench {
+
+// Number of global operator new calls so far; linking alloc_counter.cpp replaces
+// the global allocation functions with counting versions.
+std::uint64_t allocation_count();
+
+}  // namespace bench
@@ -0,0 +1,27 @@
+#include "bench_result.h"
+
+#include <algorithm>
+#include <iostream>
+
+namespace bench {
+
+void set_percentiles(Result& r, std::vector<std::int64_t>& samples) {
+  if (samples.empty()) {
+    return;
+  }
+  std::sort(samples.begin(), samples.end());
+  auto pick = [&](double frac) { return static_cast<double>(samples[static_cast<std::size_t>(frac * (samples.size() - 1))]); };
+  r.p50_ns = pick(0.50);
+  r.p99_ns = pick(0.99);
+  r.p999_ns = pick(0.999);
+}
+
+void print_result(const Result& r, std::string_view op, std::string_view checksum_label) {
+  std::cout << r.name << "\n";
+  std::cout << "  ns/" << op << ": " << r.ns_per_op << "\n";
+  std::cout << "  p50/p99/p99.9 (ns): " << r.p50_ns << " / " << r.p99_ns << " / " << r.p999_ns << "\n";
+  std::cout << "  allocations: " << r.allocs << "\n";
+  std::cout << "  " << checksum_label << ": " << r.checksum << "\n\n";
+}
+
+}  // namespace bench
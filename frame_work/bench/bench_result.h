@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace bench {
+
+// What one run_bench reports: mean time per operation and allocations from a timed
+// pass, percentiles from a second pass timing each operation on its own, and a value
+// the timed pass computed, which keeps it from being optimised away and lets runs of
+// different implementations be compared.
+struct Result {
+  std::string name;
+  double ns_per_op = 0.0;
+  double p50_ns = 0.0;
+  double p99_ns = 0.0;
+  double p999_ns = 0.0;
+  std::uint64_t allocs = 0;
+  std::uint64_t checksum = 0;
+};
+
+// Sorts samples (ns per operation) and fills r's percentiles from them.
+void set_percentiles(Result& r, std::vector<std::int64_t>& samples);
+
+// Prints r as a block, "ns/<op>" for the mean and checksum_label for the checksum.
+void print_result(const Result& r, std::string_view op, std::string_view checksum_label = "checksum");
+
+}  // namespace bench
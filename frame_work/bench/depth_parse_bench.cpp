@@ -0,0 +1,194 @@
+// Parses Binance depthUpdate frames with DepthParser and with a stand-in for the old
+// handle_message path: copy the frame into a std::string, convert each price with
+// std::stod(std::string(...)) and collect levels into two fresh vectors per message.
+// (The old path also built a boost::json DOM, which this stand-in leaves out, so the
+// gap shown here understates the real one.)
+//
+//   depth_parse_bench [frames.txt] [messages]
+//
+// frames.txt holds one raw frame per line; without it Binance-shaped frames with 1-20
+// levels per side are synthesised. Both parsers must produce identical doubles.
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "alloc_counter.h"
+#include "bench_result.h"
+#include "depth_parser.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+volatile std::uint64_t g_sink = 0;
+
+std::vector<std::string> synthesise(std::size_t count) {
+  std::mt19937_64 rng(11);
+  std::uniform_int_distribution<int> n_levels(1, 20);
+  std::uniform_int_distribution<std::int64_t> px_ticks(5'990'000, 6'010'000);
+  std::uniform_int_distribution<std::int64_t> qty_units(0, 500'000'000);
+  std::vector<std::string> out;
+  out.reserve(count);
+  std::int64_t id = 40'000'000'000;
+  char buf[64];
+  for (std::size_t i = 0; i < count; ++i) {
+    std::string f = "{\"e\":\"depthUpdate\",\"E\":" + std::to_string(1700000000000 + i) + ",\"s\":\"BTCUSDT\",\"U\":" +
+                    std::to_string(id + 1) + ",\"u\":";
+    id += 1 + static_cast<std::int64_t>(i % 7);
+    f += std::to_string(id);
+    for (const char* side : {",\"b\":[", ",\"a\":["}) {
+      f += side;
+      for (int n = n_levels(rng); n > 0; --n) {
+        const auto px = px_ticks(rng);
+        const auto qty = qty_units(rng);
+        std::snprintf(buf, sizeof(buf), "[\"%lld.%02lld000000\",\"%lld.%08lld\"]", static_cast<long long>(px / 100),
+                      static_cast<long long>(px % 100), static_cast<long long>(qty / 100'000'000),
+                      static_cast<long long>(qty % 100'000'000));
+        f += buf;
+        if (n > 1) {
+          f += ',';
+        }
+      }
+      f += ']';
+    }
+    f += '}';
+    out.push_back(std::move(f));
+  }
+  return out;
+}
+
+std::uint64_t fold(double px, double qty) {
+  std::uint64_t a, b;
+  std::memcpy(&a, &px, 8);
+  std::memcpy(&b, &qty, 8);
+  return a * 31 + b;
+}
+
+// The old path without the DOM: scans "[\"px\",\"qty\"]" pairs out of a copied string.
+struct LegacyParser {
+  std::uint64_t parse(std::string_view frame) {
+    const std::string payload(frame);
+    std::vector<hft::PriceLevel> bids;
+    std::vector<hft::PriceLevel> asks;
+    for (const char* key : {"\"b\":[", "\"a\":["}) {
+      auto& out = key[1] == 'b' ? bids : asks;
+      auto pos = payload.find(key);
+      if (pos == std::string::npos) {
+        continue;
+      }
+      pos += 5;
+      while (payload[pos] == '[') {
+        const auto p0 = pos + 2;
+        const auto p1 = payload.find('"', p0);
+        const auto q0 = p1 + 3;
+        const auto q1 = payload.find('"', q0);
+        out.push_back({std::stod(std::string(payload.substr(p0, p1 - p0))),
+                       std::stod(std::string(payload.substr(q0, q1 - q0)))});
+        pos = q1 + 2;
+        if (payload[pos] == ',') {
+          ++pos;
+        }
+      }
+    }
+    std::uint64_t sum = 0;
+    for (const auto& l : bids) {
+      sum += fold(l.price, l.qty);
+    }
+    for (const auto& l : asks) {
+      sum += fold(l.price, l.qty);
+    }
+    return sum;
+  }
+};
+
+struct FastParser {
+  std::uint64_t parse(std::string_view frame) {
+    hft::DepthUpdate u;
+    if (!parser.parse_update(frame, u)) {
+      return 0;
+    }
+    std::uint64_t sum = 0;
+    for (const auto& l : u.bids) {
+      sum += fold(l.price, l.qty);
+    }
+    for (const auto& l : u.asks) {
+      sum += fold(l.price, l.qty);
+    }
+    return sum;
+  }
+
+  hft::DepthParser parser;
+};
+
+template <typename Parser>
+bench::Result run_bench(const std::string& name, const std::vector<std::string>& frames) {
+  bench::Result r{name};
+  {
+    Parser parser;
+    std::uint64_t checksum = 0;
+    const auto allocs_before = bench::allocation_count();
+    const auto start = Clock::now();
+    for (const auto& f : frames) {
+      checksum += parser.parse(f);
+    }
+    const auto end = Clock::now();
+    r.allocs = bench::allocation_count() - allocs_before;
+    r.ns_per_op = std::chrono::duration<double, std::nano>(end - start).count() / static_cast<double>(frames.size());
+    r.checksum = checksum;
+    g_sink = checksum;
+  }
+
+  Parser parser;
+  std::vector<std::int64_t> samples;
+  samples.reserve(frames.size());
+  for (const auto& f : frames) {
+    const auto t0 = Clock::now();
+    g_sink = g_sink + parser.parse(f);
+    samples.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - t0).count());
+  }
+  bench::set_percentiles(r, samples);
+  return r;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  std::size_t count = 200'000;
+  std::vector<std::string> frames;
+  if (argc > 1 && std::string(argv[1]) != "-") {
+    std::ifstream in(argv[1]);
+    std::string line;
+    while (std::getline(in, line)) {
+      if (!line.empty()) {
+        frames.push_back(line);
+      }
+    }
+  } else {
+    if (argc > 2) {
+      count = std::stoull(argv[2]);
+    }
+    frames = synthesise(count);
+  }
+  if (frames.empty()) {
+    std::cerr << "no frames to parse\n";
+    return 1;
+  }
+  std::cout << "frames: " << frames.size() << "\n\n";
+
+  const auto legacy = run_bench<LegacyParser>("string copy + std::stod", frames);
+  const auto fast = run_bench<FastParser>("DepthParser", frames);
+  bench::print_result(legacy, "msg");
+  bench::print_result(fast, "msg");
+  std::cout << "speedup: " << legacy.ns_per_op / fast.ns_per_op << "x\n";
+  if (legacy.checksum != fast.checksum) {
+    std::cout << "WARNING: parsed values diverged\n";
+  }
+  return 0;
+}
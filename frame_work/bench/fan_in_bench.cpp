@@ -0,0 +1,150 @@
+// OmsRisk fan-in: round-robin polling over one SpscQueue per strategy shard (the old
+// loop) vs a single MpscQueue, at 2, 8 and 32 shards.
+//
+//   fan_in_bench [messages]
+//
+// sparse:   one decision at a time arrives on a random shard and the consumer drains
+//           until it has it; measures the consumer's cost of finding work.
+// threaded: one producer thread per shard streams decisions stamped from a shared
+//           counter; reports throughput and how many arrive behind a later stamp.
+// Blocked producers yield, so the numbers stay meaningful with fewer cores than threads.
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "types.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+constexpr std::size_t kDrainBatch = 32;  // the old OmsRisk per-queue batch
+volatile std::int64_t g_sink = 0;
+
+class PollingFanIn {
+ public:
+  explicit PollingFanIn(std::size_t shards) {
+    for (std::size_t i = 0; i < shards; ++i) {
+      queues_.push_back(std::make_unique<hft::StrategyQueue>());
+    }
+  }
+
+  bool push(std::size_t shard, const hft::StrategyDecision& d) { return queues_[shard]->push(d); }
+
+  template <typename Fn>
+  std::size_t drain(Fn&& fn) {
+    std::size_t n = 0;
+    for (auto& q : queues_) {
+      n += q->consume(fn, kDrainBatch);
+    }
+    return n;
+  }
+
+ private:
+  std::vector<std::unique_ptr<hft::StrategyQueue>> queues_;
+};
+
+class MpscFanIn {
+ public:
+  explicit MpscFanIn(std::size_t) : queue_(std::make_unique<hft::DecisionQueue>()) {}
+
+  bool push(std::size_t, const hft::StrategyDecision& d) { return queue_->push(d); }
+
+  template <typename Fn>
+  std::size_t drain(Fn&& fn) {
+    return queue_->consume(fn, 64);
+  }
+
+ private:
+  std::unique_ptr<hft::DecisionQueue> queue_;
+};
+
+template <typename FanIn>
+double bench_sparse(std::size_t shards, std::size_t messages) {
+  FanIn fan_in(shards);
+  std::mt19937_64 rng{42};
+  std::uniform_int_distribution<std::size_t> pick(0, shards - 1);
+  const auto start = Clock::now();
+  for (std::size_t i = 0; i < messages; ++i) {
+    const auto seq = static_cast<std::int64_t>(i);
+    fan_in.push(pick(rng), hft::StrategyDecision{0, true, 100.0, 1.0, seq});
+    while (fan_in.drain([](const hft::StrategyDecision& d) { g_sink = g_sink + d.seq; }) == 0) {
+    }
+  }
+  const auto end = Clock::now();
+  return std::chrono::duration<double, std::nano>(end - start).count() / static_cast<double>(messages);
+}
+
+struct ThreadedResult {
+  double mmsg_per_sec;
+  double out_of_order_pct;
+};
+
+template <typename FanIn>
+ThreadedResult bench_threaded(std::size_t shards, std::size_t messages) {
+  FanIn fan_in(shards);
+  std::atomic<std::int64_t> stamp{0};
+  const std::size_t per_shard = messages / shards;
+  const std::size_t total = per_shard * shards;
+
+  std::vector<std::thread> producers;
+  const auto start = Clock::now();
+  for (std::size_t s = 0; s < shards; ++s) {
+    producers.emplace_back([&, s] {
+      for (std::size_t i = 0; i < per_shard; ++i) {
+        hft::StrategyDecision d{0, true, 100.0, 1.0, stamp.fetch_add(1, std::memory_order_relaxed)};
+        while (!fan_in.push(s, d)) {
+          std::this_thread::yield();
+        }
+      }
+    });
+  }
+  std::size_t received = 0;
+  std::size_t out_of_order = 0;
+  std::int64_t newest = -1;
+  while (received < total) {
+    const auto n = fan_in.drain([&](const hft::StrategyDecision& d) {
+      out_of_order += d.seq < newest;
+      newest = std::max(newest, d.seq);
+    });
+    if (n == 0) {
+      std::this_thread::yield();
+    }
+    received += n;
+  }
+  const auto end = Clock::now();
+  for (auto& t : producers) {
+    t.join();
+  }
+  const double secs = std::chrono::duration<double>(end - start).count();
+  return {static_cast<double>(total) / secs / 1e6, 100.0 * static_cast<double>(out_of_order) / static_cast<double>(total)};
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  std::size_t messages = 1'000'000;
+  if (argc > 1) {
+    messages = std::stoull(argv[1]);
+  }
+  std::cout << std::fixed << std::setprecision(1);
+  std::cout << "shards  queue    sparse ns/msg  threaded Mmsg/s  out-of-order %\n";
+  for (const std::size_t shards : {2, 8, 32}) {
+    const auto poll_sparse = bench_sparse<PollingFanIn>(shards, messages);
+    const auto poll_thr = bench_threaded<PollingFanIn>(shards, messages);
+    const auto mpsc_sparse = bench_sparse<MpscFanIn>(shards, messages);
+    const auto mpsc_thr = bench_threaded<MpscFanIn>(shards, messages);
+    std::cout << std::setw(6) << shards << "  polling  " << std::setw(13) << poll_sparse << "  " << std::setw(15)
+              << poll_thr.mmsg_per_sec << "  " << std::setw(14) << poll_thr.out_of_order_pct << "\n";
+    std::cout << std::setw(6) << shards << "  mpsc     " << std::setw(13) << mpsc_sparse << "  " << std::setw(15)
+              << mpsc_thr.mmsg_per_sec << "  " << std::setw(14) << mpsc_thr.out_of_order_pct << "\n";
+  }
+  return 0;
+}
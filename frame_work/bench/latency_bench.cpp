@@ -0,0 +1,112 @@
+// Cost of tick-to-trade tracing: one stage stamp (steady_clock vs tsc_now) and one
+// order's worth of TickToTrade::record, plus how far the histogram's percentiles sit
+// from exact ones on the same samples.
+//
+//   latency_bench [iterations]
+//
+// Samples are log-normal around ~2us with a long tail, roughly the shape of a real
+// tick-to-trade distribution, so the coarse upper buckets get exercised too.
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "alloc_counter.h"
+#include "latency.h"
+#include "tsc.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct BenchmarkResult {
+  std::string name;
+  double ns_per_op = 0.0;
+  std::uint64_t allocs = 0;
+};
+
+volatile std::uint64_t g_sink = 0;
+
+template <typename Fn>
+BenchmarkResult run_bench(const std::string& name, std::size_t iterations, Fn&& fn) {
+  BenchmarkResult r{name};
+  const auto allocs_before = bench::allocation_count();
+  const auto start = Clock::now();
+  for (std::size_t i = 0; i < iterations; ++i) {
+    fn(i);
+  }
+  const auto end = Clock::now();
+  r.allocs = bench::allocation_count() - allocs_before;
+  r.ns_per_op = std::chrono::duration<double, std::nano>(end - start).count() / static_cast<double>(iterations);
+  return r;
+}
+
+void print_result(const BenchmarkResult& r) {
+  std::cout << r.name << "\n";
+  std::cout << "  ns/op: " << r.ns_per_op << "\n";
+  std::cout << "  allocations: " << r.allocs << "\n\n";
+}
+
+std::vector<hft::TraceStamps> synthesise(std::size_t count) {
+  std::mt19937_64 rng(11);
+  std::lognormal_distribution<double> hop(std::log(400.0), 0.8);
+  std::vector<hft::TraceStamps> out;
+  out.reserve(count);
+  std::uint64_t base = 1'000'000;
+  for (std::size_t i = 0; i < count; ++i) {
+    hft::TraceStamps t{base};
+    double at = hop(rng);
+    t.strat_in = static_cast<std::uint32_t>(at);
+    t.strat_out = static_cast<std::uint32_t>(at += hop(rng) / 10.0);
+    t.oms_in = static_cast<std::uint32_t>(at += hop(rng));
+    t.oms_out = static_cast<std::uint32_t>(at += hop(rng) / 10.0);
+    out.push_back(t);
+    base += 1000;
+  }
+  return out;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  std::size_t count = 2'000'000;
+  if (argc > 1) {
+    count = std::stoull(argv[1]);
+  }
+  if (count == 0) {
+    std::cerr << "iterations must be positive\n";
+    return 1;
+  }
+  std::cout << "iterations: " << count << " ticks/ns: " << hft::tsc_ticks_per_ns() << "\n\n";
+
+  print_result(run_bench("steady_clock::now", count, [](std::size_t) {
+    g_sink = g_sink + static_cast<std::uint64_t>(Clock::now().time_since_epoch().count());
+  }));
+  print_result(run_bench("tsc_now", count, [](std::size_t) { g_sink = g_sink + hft::tsc_now(); }));
+
+  const auto stamps = synthesise(count);
+  auto trace = std::make_unique<hft::TickToTrade>();
+  print_result(run_bench("TickToTrade::record (6 hops)", count, [&](std::size_t i) {
+    trace->record(stamps[i], stamps[i].feed_recv + stamps[i].oms_out + 300);
+  }));
+
+  // Accuracy of the end-to-end hop against an exact sort of the same values.
+  std::vector<std::uint64_t> exact;
+  exact.reserve(count);
+  for (const auto& t : stamps) {
+    exact.push_back(t.oms_out + 300);
+  }
+  std::sort(exact.begin(), exact.end());
+  const auto& h = trace->hop(hft::Hop::TickToTrade);
+  std::cout << "tick-to-trade percentiles (ticks): exact / histogram\n";
+  for (const double q : {0.50, 0.99, 0.999}) {
+    const auto want = exact[static_cast<std::size_t>(std::ceil(q * static_cast<double>(count))) - 1];
+    std::cout << "  p" << q * 100 << ": " << want << " / " << h.percentile(q) << "\n";
+  }
+  return 0;
+}
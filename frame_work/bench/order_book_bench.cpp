@@ -0,0 +1,166 @@
+// Replays depth deltas through the ladder OrderBook and the reference MapOrderBook.
+//
+//   order_book_bench [deltas.csv] [messages]
+//
+// deltas.csv holds one level per line as `update_id,side,price,qty` (side is b/a);
+// consecutive lines with the same update_id form one depth message. Without a file a
+// Binance-shaped random walk of `messages` updates is synthesised.
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "alloc_counter.h"
+#include "bench_result.h"
+#include "order_book.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct DepthMessage {
+  std::int64_t update_id{};
+  std::vector<hft::PriceLevel> bids;
+  std::vector<hft::PriceLevel> asks;
+};
+
+volatile std::uint64_t g_sink = 0;
+
+std::vector<DepthMessage> load_csv(const std::string& path) {
+  std::vector<DepthMessage> out;
+  std::ifstream in(path);
+  std::string line;
+  while (std::getline(in, line)) {
+    if (line.empty() || line[0] == '#') {
+      continue;
+    }
+    std::istringstream ss(line);
+    std::string id, side, px, qty;
+    if (!std::getline(ss, id, ',') || !std::getline(ss, side, ',') || !std::getline(ss, px, ',') ||
+        !std::getline(ss, qty, ',')) {
+      continue;
+    }
+    const std::int64_t update_id = std::stoll(id);
+    if (out.empty() || out.back().update_id != update_id) {
+      out.push_back(DepthMessage{update_id, {}, {}});
+    }
+    auto& levels = side == "b" ? out.back().bids : out.back().asks;
+    levels.push_back({std::stod(px), std::stod(qty)});
+  }
+  return out;
+}
+
+// Random walk around 60000.00 with 0.01 ticks: each message touches a few levels near
+// the touch, ~30% of them deletions, and clears levels the touch moved through.
+std::vector<DepthMessage> synthesise(std::size_t count) {
+  constexpr double kTick = 0.01;
+  std::mt19937_64 rng(2024);
+  std::uniform_int_distribution<int> step(-3, 3);
+  std::uniform_int_distribution<int> depth(0, 200);
+  std::uniform_int_distribution<int> n_levels(1, 10);
+  std::uniform_real_distribution<double> qty(0.001, 5.0);
+  std::bernoulli_distribution remove(0.3);
+
+  std::vector<DepthMessage> out;
+  out.reserve(count);
+  std::int64_t mid = 6'000'000;
+  for (std::size_t i = 0; i < count; ++i) {
+    DepthMessage msg{static_cast<std::int64_t>(i + 1), {}, {}};
+    const std::int64_t next_mid = mid + step(rng);
+    for (std::int64_t t = mid; t <= next_mid; ++t) {
+      msg.asks.push_back({static_cast<double>(t + 1) * kTick, 0.0});
+    }
+    for (std::int64_t t = next_mid; t <= mid; ++t) {
+      msg.bids.push_back({static_cast<double>(t - 1) * kTick, 0.0});
+    }
+    mid = next_mid;
+    msg.bids.push_back({static_cast<double>(mid - 1) * kTick, qty(rng)});
+    msg.asks.push_back({static_cast<double>(mid + 1) * kTick, qty(rng)});
+    for (int n = n_levels(rng); n > 0; --n) {
+      msg.bids.push_back({static_cast<double>(mid - 1 - depth(rng)) * kTick, remove(rng) ? 0.0 : qty(rng)});
+      msg.asks.push_back({static_cast<double>(mid + 1 + depth(rng)) * kTick, remove(rng) ? 0.0 : qty(rng)});
+    }
+    out.push_back(std::move(msg));
+  }
+  return out;
+}
+
+std::uint64_t fold(const std::optional<hft::BestBidAsk>& b) {
+  if (!b) {
+    return 0;
+  }
+  return static_cast<std::uint64_t>(std::llround(b->bid * 100.0)) * 31 +
+         static_cast<std::uint64_t>(std::llround(b->ask * 100.0));
+}
+
+template <typename Book>
+bench::Result run_bench(const std::string& name, const std::vector<DepthMessage>& msgs) {
+  bench::Result r{name};
+  {
+    Book book;
+    std::uint64_t checksum = 0;
+    const auto allocs_before = bench::allocation_count();
+    const auto start = Clock::now();
+    for (const auto& m : msgs) {
+      book.apply_deltas(m.bids, m.asks, m.update_id);
+      checksum += fold(book.best());
+    }
+    const auto end = Clock::now();
+    r.allocs = bench::allocation_count() - allocs_before;
+    r.ns_per_op = std::chrono::duration<double, std::nano>(end - start).count() / static_cast<double>(msgs.size());
+    r.checksum = checksum;
+    g_sink = checksum;
+  }
+
+  Book book;
+  std::vector<std::int64_t> samples;
+  samples.reserve(msgs.size());
+  for (const auto& m : msgs) {
+    const auto t0 = Clock::now();
+    book.apply_deltas(m.bids, m.asks, m.update_id);
+    g_sink = g_sink + fold(book.best());
+    samples.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - t0).count());
+  }
+  bench::set_percentiles(r, samples);
+  return r;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  std::size_t count = 1'000'000;
+  std::vector<DepthMessage> msgs;
+  if (argc > 1 && std::string(argv[1]) != "-") {
+    msgs = load_csv(argv[1]);
+  } else {
+    if (argc > 2) {
+      count = std::stoull(argv[2]);
+    }
+    msgs = synthesise(count);
+  }
+  if (msgs.empty()) {
+    std::cerr << "no depth messages to replay\n";
+    return 1;
+  }
+
+  std::size_t levels = 0;
+  for (const auto& m : msgs) {
+    levels += m.bids.size() + m.asks.size();
+  }
+  std::cout << "messages: " << msgs.size() << " levels: " << levels << "\n\n";
+
+  const auto map_result = run_bench<hft::MapOrderBook>("std::map book", msgs);
+  const auto ladder_result = run_bench<hft::OrderBook>("ladder book", msgs);
+  bench::print_result(map_result, "msg");
+  bench::print_result(ladder_result, "msg");
+  std::cout << "speedup: " << map_result.ns_per_op / ladder_result.ns_per_op << "x\n";
+  if (map_result.checksum != ladder_result.checksum) {
+    std::cout << "WARNING: best bid/ask diverged between books\n";
+  }
+  return 0;
+}
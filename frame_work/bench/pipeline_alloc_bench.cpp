@@ -0,0 +1,162 @@
+// Counts heap allocations per event along feed -> strategy -> OMS -> trade -> logger,
+// comparing the old std::string messages with the fixed-size interned-ID messages.
+//
+//   pipeline_alloc_bench [events]
+//
+// Each stage pushes into and pops from a real SpscQueue on one thread, so the numbers
+// isolate message construction, queue copies and the trade log line.
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "alloc_counter.h"
+#include "binlog.h"
+#include "types.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+namespace legacy {
+
+struct LogEvent {
+  std::string source;
+  std::string message;
+  std::chrono::steady_clock::time_point ts;
+};
+
+struct MarketEvent {
+  std::string symbol;
+  double bid{};
+  double ask{};
+  double size{};
+  std::int64_t seq{};
+};
+
+struct StrategyDecision {
+  std::string symbol;
+  bool buy{};
+  double price{};
+  double qty{};
+  std::int64_t seq{};
+};
+
+struct OrderCommand {
+  std::string symbol;
+  bool buy{};
+  double price{};
+  double qty{};
+  std::int64_t seq{};
+};
+
+std::string fmt(double v) {
+  std::ostringstream oss;
+  oss << std::fixed << std::setprecision(2) << v;
+  return oss.str();
+}
+
+}  // namespace legacy
+
+struct BenchmarkResult {
+  std::string name;
+  std::size_t events = 0;
+  std::uint64_t allocs = 0;
+  double ns_per_event = 0.0;
+};
+
+volatile std::uint64_t g_sink = 0;
+
+const std::vector<std::string> kSymbols = {"BTCUSDT", "ETHUSDT", "XRPUSDT", "SOLUSDT", "1000SHIBUSDT"};
+
+BenchmarkResult bench_legacy(std::size_t events) {
+  auto market_q = std::make_unique<hft::SpscQueue<legacy::MarketEvent, 1024>>();
+  auto strat_q = std::make_unique<hft::SpscQueue<legacy::StrategyDecision, 1024>>();
+  auto order_q = std::make_unique<hft::SpscQueue<legacy::OrderCommand, 1024>>();
+  auto log_q = std::make_unique<hft::SpscQueue<legacy::LogEvent, 1024>>();
+  legacy::MarketEvent evt;
+  legacy::StrategyDecision d;
+  legacy::OrderCommand cmd;
+  legacy::LogEvent log_evt;
+
+  const auto allocs_before = bench::allocation_count();
+  const auto start = Clock::now();
+  for (std::size_t i = 0; i < events; ++i) {
+    const auto& sym = kSymbols[i % kSymbols.size()];
+    const auto seq = static_cast<std::int64_t>(i);
+    market_q->push(legacy::MarketEvent{sym, 100.0, 100.4, 0.5, seq});
+    market_q->pop(evt);
+    strat_q->push(legacy::StrategyDecision{evt.symbol, (evt.seq % 2) == 0, 100.15, evt.size * 0.8, evt.seq});
+    strat_q->pop(d);
+    order_q->push(legacy::OrderCommand{d.symbol, d.buy, d.price, d.qty, d.seq});
+    order_q->pop(cmd);
+    log_q->push(legacy::LogEvent{"trade",
+                                 "send " + cmd.symbol + " " + (cmd.buy ? "BUY" : "SELL") + " qty=" +
+                                     legacy::fmt(cmd.qty) + " px=" + legacy::fmt(cmd.price) +
+                                     " seq=" + std::to_string(cmd.seq),
+                                 Clock::now()});
+    log_q->pop(log_evt);
+    g_sink = g_sink + log_evt.message.size();
+  }
+  const auto end = Clock::now();
+  return {"std::string messages", events, bench::allocation_count() - allocs_before,
+          std::chrono::duration<double, std::nano>(end - start).count() / static_cast<double>(events)};
+}
+
+BenchmarkResult bench_interned(std::size_t events) {
+  hft::SymbolRegistry symbols;
+  for (const auto& sym : kSymbols) {
+    symbols.intern(sym);
+  }
+  auto market_q = std::make_unique<hft::MarketQueue>();
+  auto strat_q = std::make_unique<hft::StrategyQueue>();
+  auto order_q = std::make_unique<hft::OrderQueue>();
+  auto log_q = std::make_unique<hft::LogQueue>();
+  hft::MarketEvent evt;
+  hft::StrategyDecision d;
+  hft::OrderCommand cmd;
+  hft::LogEvent log_evt;
+
+  const auto allocs_before = bench::allocation_count();
+  const auto start = Clock::now();
+  for (std::size_t i = 0; i < events; ++i) {
+    const auto sym = static_cast<hft::SymbolId>(i % symbols.size());
+    const auto seq = static_cast<std::int64_t>(i);
+    market_q->push(hft::MarketEvent{sym, 100.0, 100.4, 0.5, seq});
+    market_q->pop(evt);
+    strat_q->push(hft::StrategyDecision{evt.symbol, (evt.seq % 2) == 0, 100.15, evt.size * 0.8, evt.seq});
+    strat_q->pop(d);
+    order_q->push(hft::OrderCommand{d.symbol, d.buy, d.price, d.qty, d.seq});
+    order_q->pop(cmd);
+    HFT_LOG(*log_q, "send %s %s qty=%.2f px=%.2f seq=%lld", symbols.name(cmd.symbol), cmd.buy ? "BUY" : "SELL",
+            cmd.qty, cmd.price, cmd.seq);
+    log_q->pop(log_evt);
+    g_sink = g_sink + log_evt.len;
+  }
+  const auto end = Clock::now();
+  return {"interned fixed-size messages", events, bench::allocation_count() - allocs_before,
+          std::chrono::duration<double, std::nano>(end - start).count() / static_cast<double>(events)};
+}
+
+void print_result(const BenchmarkResult& r) {
+  std::cout << r.name << "\n";
+  std::cout << "  events: " << r.events << "\n";
+  std::cout << "  allocations: " << r.allocs << "\n";
+  std::cout << "  allocations/event: " << static_cast<double>(r.allocs) / static_cast<double>(r.events) << "\n";
+  std::cout << "  ns/event: " << r.ns_per_event << "\n\n";
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  std::size_t events = 1'000'000;
+  if (argc > 1) {
+    events = std::stoull(argv[1]);
+  }
+  print_result(bench_legacy(events));
+  print_result(bench_interned(events));
+  return 0;
+}
@@ -0,0 +1,136 @@
+// Per-order cost of the OmsRisk pre-trade checks: the old qty-only check vs RiskEngine.
+//
+//   risk_bench [symbols] [orders]
+//
+// Decisions hit uniformly random symbols (1000 by default) so the limits table is
+// touched the way a wide universe touches it, not from a single hot cache line.
+// About 1% are oversized and 1% priced outside the band; every 8th accepted order is
+// filled and every 8th cancelled so exposure keeps moving. Position and notional caps
+// are set out of reach and the clock advances 1us per order, well inside the rate
+// limits, so nearly every rejection is one of the planted ones.
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "alloc_counter.h"
+#include "bench_result.h"
+#include "risk.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+volatile std::size_t g_sink = 0;
+
+struct Order {
+  hft::StrategyDecision d;
+  double ref_mid;
+};
+
+std::vector<Order> synthesise(std::size_t symbols, std::size_t count) {
+  std::mt19937_64 rng(7);
+  std::uniform_int_distribution<std::size_t> pick_symbol(0, symbols - 1);
+  std::uniform_real_distribution<double> qty(0.01, 2.0);
+  std::uniform_real_distribution<double> offset(-0.5, 0.5);
+  std::uniform_int_distribution<int> roll(0, 99);
+  std::bernoulli_distribution buy(0.5);
+
+  std::vector<Order> out;
+  out.reserve(count);
+  for (std::size_t i = 0; i < count; ++i) {
+    const auto sym = static_cast<hft::SymbolId>(pick_symbol(rng));
+    const double mid = 100.0 + static_cast<double>(sym);
+    hft::StrategyDecision d{sym, buy(rng), mid + offset(rng), qty(rng), static_cast<std::int64_t>(i)};
+    const int r = roll(rng);
+    if (r == 0) {
+      d.qty = 50.0;
+    } else if (r == 1) {
+      d.price = mid * 1.2;
+    }
+    out.push_back({d, mid});
+  }
+  return out;
+}
+
+// The check OmsRisk used to run.
+struct QtyOnly {
+  explicit QtyOnly(std::size_t) {}
+  bool check(const Order& o, std::int64_t) { return o.d.qty <= 1.5; }
+};
+
+struct Engine {
+  explicit Engine(std::size_t symbols)
+      : risk(symbols, hft::RiskLimits{10.0, 1e6, 1e9, 5000.0, 100.0, 500.0}, hft::GlobalRiskLimits{1e12, 1e7, 1000.0}) {}
+
+  bool check(const Order& o, std::int64_t now_ns) {
+    if (risk.check(o.d, o.ref_mid, now_ns) != hft::RiskResult::Pass) {
+      return false;
+    }
+    if (++accepted % 8 == 0) {
+      risk.on_fill(o.d.symbol, o.d.buy, o.d.qty, o.d.price);
+    } else if (accepted % 8 == 1) {
+      risk.on_cancel(o.d.symbol, o.d.buy, o.d.qty, o.d.price);
+    }
+    return true;
+  }
+
+  hft::RiskEngine risk;
+  std::size_t accepted = 0;
+};
+
+template <typename Checker>
+bench::Result run_bench(const std::string& name, std::size_t symbols, const std::vector<Order>& orders) {
+  bench::Result r{name};
+  {
+    Checker checker(symbols);
+    std::size_t rejects = 0;
+    const auto allocs_before = bench::allocation_count();
+    const auto start = Clock::now();
+    for (std::size_t i = 0; i < orders.size(); ++i) {
+      rejects += !checker.check(orders[i], static_cast<std::int64_t>(i) * 1000);
+    }
+    const auto end = Clock::now();
+    r.allocs = bench::allocation_count() - allocs_before;
+    r.ns_per_op = std::chrono::duration<double, std::nano>(end - start).count() / static_cast<double>(orders.size());
+    r.checksum = rejects;
+    g_sink = rejects;
+  }
+
+  // Per-order samples include the clock reads, so they sit above ns/order.
+  Checker checker(symbols);
+  std::vector<std::int64_t> samples;
+  samples.reserve(orders.size());
+  for (std::size_t i = 0; i < orders.size(); ++i) {
+    const auto t0 = Clock::now();
+    g_sink = g_sink + checker.check(orders[i], static_cast<std::int64_t>(i) * 1000);
+    samples.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - t0).count());
+  }
+  bench::set_percentiles(r, samples);
+  return r;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  std::size_t symbols = 1000;
+  std::size_t count = 2'000'000;
+  if (argc > 1) {
+    symbols = std::stoull(argv[1]);
+  }
+  if (argc > 2) {
+    count = std::stoull(argv[2]);
+  }
+  if (symbols == 0 || symbols > 0xffff) {
+    std::cerr << "symbols must be in 1..65535\n";
+    return 1;
+  }
+  const auto orders = synthesise(symbols, count);
+  std::cout << "symbols: " << symbols << " orders: " << orders.size() << "\n\n";
+
+  bench::print_result(run_bench<QtyOnly>("qty-only check", symbols, orders), "order", "rejects");
+  bench::print_result(run_bench<Engine>("RiskEngine", symbols, orders), "order", "rejects");
+  return 0;
+}
@@ -0,0 +1,240 @@
+// SpscQueue throughput and latency, old per-item path vs the new APIs, for payloads of
+// one to four cache lines.
+//
+//   spsc_queue_bench [items]
+//
+// Throughput streams `items` payloads producer -> consumer on two threads. Latency is a
+// ping-pong over two queues and reports half the round trip. Blocked sides yield, so
+// the numbers stay meaningful on machines with fewer cores than threads.
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "spsc_queue.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+constexpr std::size_t kCapacity = 1024;
+constexpr std::size_t kBatch = 32;
+
+// The queue as it was before claim/commit, batching and index caching.
+template <typename T, std::size_t CapacityPow2>
+class LegacySpscQueue {
+ public:
+  bool push(const T& item) {
+    const std::size_t head = head_.load(std::memory_order_relaxed);
+    const std::size_t next = (head + 1) & mask_;
+    if (next == tail_.load(std::memory_order_acquire)) {
+      return false;
+    }
+    buffer_[head] = item;
+    head_.store(next, std::memory_order_release);
+    return true;
+  }
+
+  bool pop(T& out) {
+    const std::size_t tail = tail_.load(std::memory_order_relaxed);
+    if (tail == head_.load(std::memory_order_acquire)) {
+      return false;
+    }
+    out = buffer_[tail];
+    tail_.store((tail + 1) & mask_, std::memory_order_release);
+    return true;
+  }
+
+ private:
+  alignas(64) std::atomic<std::size_t> head_{0};
+  alignas(64) std::atomic<std::size_t> tail_{0};
+  static constexpr std::size_t mask_ = CapacityPow2 - 1;
+  T buffer_[CapacityPow2];
+};
+
+template <std::size_t Lines>
+struct alignas(64) Payload {
+  std::uint64_t seq{};
+  std::uint64_t words[Lines * 8 - 1]{};
+};
+
+struct BenchmarkResult {
+  std::string name;
+  double mops = 0.0;
+  double p50_ns = 0.0;
+  double p99_ns = 0.0;
+  bool has_latency = false;
+};
+
+volatile std::uint64_t g_sink = 0;
+
+enum class Mode { Legacy, PushPop, Emplace, ClaimCommit, Batch };
+
+const char* mode_name(Mode m) {
+  switch (m) {
+    case Mode::Legacy: return "legacy push/pop";
+    case Mode::PushPop: return "push/pop";
+    case Mode::Emplace: return "try_emplace/consume";
+    case Mode::ClaimCommit: return "claim/commit";
+    case Mode::Batch: return "push_batch/pop_batch";
+  }
+  return "?";
+}
+
+template <typename P, Mode M>
+double throughput(std::size_t items) {
+  using Queue = std::conditional_t<M == Mode::Legacy, LegacySpscQueue<P, kCapacity>, hft::SpscQueue<P, kCapacity>>;
+  auto q = std::make_unique<Queue>();
+  const auto start = Clock::now();
+
+  std::thread consumer([&]() {
+    std::uint64_t sum = 0;
+    std::size_t received = 0;
+    std::vector<P> batch(kBatch);
+    P item;
+    while (received < items) {
+      std::size_t n = 0;
+      if constexpr (M == Mode::Legacy || M == Mode::PushPop || M == Mode::ClaimCommit) {
+        if (q->pop(item)) {
+          sum += item.seq;
+          n = 1;
+        }
+      } else if constexpr (M == Mode::Emplace) {
+        n = q->consume([&](const P& p) { sum += p.seq; }, kBatch);
+      } else {
+        n = q->pop_batch(batch.data(), kBatch);
+        for (std::size_t i = 0; i < n; ++i) {
+          sum += batch[i].seq;
+        }
+      }
+      if (n == 0) {
+        std::this_thread::yield();
+      }
+      received += n;
+    }
+    g_sink = sum;
+  });
+
+  std::vector<P> batch(kBatch);
+  for (std::size_t sent = 0; sent < items;) {
+    bool ok = false;
+    if constexpr (M == Mode::Legacy || M == Mode::PushPop) {
+      P p;
+      p.seq = sent;
+      ok = q->push(p);
+      sent += ok;
+    } else if constexpr (M == Mode::Emplace) {
+      ok = q->try_emplace(P{sent});
+      sent += ok;
+    } else if constexpr (M == Mode::ClaimCommit) {
+      if (P* slot = q->try_claim()) {
+        slot->seq = sent;
+        q->commit();
+        ok = true;
+        ++sent;
+      }
+    } else {
+      const std::size_t want = std::min(kBatch, items - sent);
+      for (std::size_t i = 0; i < want; ++i) {
+        batch[i].seq = sent + i;
+      }
+      const std::size_t n = q->push_batch(batch.data(), want);
+      sent += n;
+      ok = n != 0;
+    }
+    if (!ok) {
+      std::this_thread::yield();
+    }
+  }
+  consumer.join();
+  const double secs = std::chrono::duration<double>(Clock::now() - start).count();
+  return static_cast<double>(items) / secs / 1e6;
+}
+
+template <typename P, Mode M>
+std::vector<std::int64_t> ping_pong(std::size_t rounds) {
+  using Queue = std::conditional_t<M == Mode::Legacy, LegacySpscQueue<P, kCapacity>, hft::SpscQueue<P, kCapacity>>;
+  auto ping = std::make_unique<Queue>();
+  auto pong = std::make_unique<Queue>();
+
+  std::thread echo([&]() {
+    P item;
+    for (std::size_t i = 0; i < rounds; ++i) {
+      while (!ping->pop(item)) {
+        std::this_thread::yield();
+      }
+      while (!pong->push(item)) {
+        std::this_thread::yield();
+      }
+    }
+  });
+
+  std::vector<std::int64_t> samples;
+  samples.reserve(rounds);
+  P item;
+  for (std::size_t i = 0; i < rounds; ++i) {
+    item.seq = i;
+    const auto t0 = Clock::now();
+    while (!ping->push(item)) {
+      std::this_thread::yield();
+    }
+    while (!pong->pop(item)) {
+      std::this_thread::yield();
+    }
+    samples.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - t0).count() / 2);
+  }
+  echo.join();
+  std::sort(samples.begin(), samples.end());
+  return samples;
+}
+
+template <typename P, Mode M>
+BenchmarkResult run_one(std::size_t items) {
+  BenchmarkResult r{mode_name(M)};
+  r.mops = throughput<P, M>(items);
+  if constexpr (M == Mode::Legacy || M == Mode::PushPop) {
+    const auto samples = ping_pong<P, M>(std::max<std::size_t>(items / 100, 1000));
+    r.p50_ns = static_cast<double>(samples[samples.size() / 2]);
+    r.p99_ns = static_cast<double>(samples[static_cast<std::size_t>(0.99 * static_cast<double>(samples.size() - 1))]);
+    r.has_latency = true;
+  }
+  return r;
+}
+
+void print_result(const BenchmarkResult& r) {
+  std::cout << "  " << r.name << ": " << r.mops << " Mitems/s";
+  if (r.has_latency) {
+    std::cout << ", one-way p50/p99 (ns): " << r.p50_ns << " / " << r.p99_ns;
+  }
+  std::cout << "\n";
+}
+
+template <std::size_t Lines>
+void run_payload(std::size_t items) {
+  std::cout << "payload " << sizeof(Payload<Lines>) << " bytes (" << Lines << " cache line" << (Lines > 1 ? "s" : "")
+            << ")\n";
+  print_result(run_one<Payload<Lines>, Mode::Legacy>(items));
+  print_result(run_one<Payload<Lines>, Mode::PushPop>(items));
+  print_result(run_one<Payload<Lines>, Mode::Emplace>(items));
+  print_result(run_one<Payload<Lines>, Mode::ClaimCommit>(items));
+  print_result(run_one<Payload<Lines>, Mode::Batch>(items));
+  std::cout << "\n";
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  std::size_t items = 5'000'000;
+  if (argc > 1) {
+    items = std::stoull(argv[1]);
+  }
+  run_payload<1>(items);
+  run_payload<2>(items);
+  run_payload<3>(items);
+  run_payload<4>(items);
+  return 0;
+}
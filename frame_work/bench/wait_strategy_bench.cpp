@@ -0,0 +1,150 @@
+// One-hop latency through an SpscQueue for each consumer WaitStrategy, next to the old
+// fixed 50us sleep, with a log2 latency histogram and the consumer's CPU usage.
+//
+//   wait_strategy_bench [messages] [gap_us]
+//
+// The producer sends a timestamped message every gap_us (sparse traffic is where the
+// idle policy matters); the consumer records receive time minus send time.
+#include <time.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "spsc_queue.h"
+#include "wait_strategy.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Stamp {
+  std::int64_t sent_ns{};
+};
+
+using Queue = hft::SpscQueue<Stamp, 1024>;
+
+std::int64_t now_ns() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count();
+}
+
+double thread_cpu_ms() {
+  timespec ts{};
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+  return static_cast<double>(ts.tv_sec) * 1e3 + static_cast<double>(ts.tv_nsec) / 1e6;
+}
+
+struct Result {
+  std::string name;
+  std::array<std::uint64_t, 40> hist{};  // bucket i holds [2^i, 2^(i+1)) ns
+  std::vector<std::int64_t> samples;
+  double cpu_ms = 0.0;
+  double wall_ms = 0.0;
+};
+
+// Empty `wait` means the pre-WaitStrategy behaviour: sleep 50us whenever idle.
+Result run(const std::string& name, std::optional<hft::WaitConfig> wait, std::size_t messages,
+           std::chrono::microseconds gap) {
+  auto q = std::make_unique<Queue>();
+  std::unique_ptr<hft::WaitStrategy> strategy;
+  if (wait) {
+    strategy = std::make_unique<hft::WaitStrategy>(*wait);
+    q->set_doorbell(strategy->doorbell());
+  }
+
+  Result r;
+  r.name = name;
+  r.samples.reserve(messages);
+  const auto start = Clock::now();
+  std::thread consumer([&]() {
+    const double cpu0 = thread_cpu_ms();
+    Stamp s;
+    for (std::size_t received = 0; received < messages;) {
+      if (!q->pop(s)) {
+        if (strategy) {
+          strategy->idle([&] { return !q->empty(); });
+        } else {
+          std::this_thread::sleep_for(std::chrono::microseconds(50));
+        }
+        continue;
+      }
+      if (strategy) {
+        strategy->reset();
+      }
+      const std::int64_t lat = std::max<std::int64_t>(now_ns() - s.sent_ns, 1);
+      ++r.hist[std::min<std::size_t>(std::bit_width(static_cast<std::uint64_t>(lat)) - 1, r.hist.size() - 1)];
+      r.samples.push_back(lat);
+      ++received;
+    }
+    r.cpu_ms = thread_cpu_ms() - cpu0;
+  });
+
+  for (std::size_t i = 0; i < messages; ++i) {
+    std::this_thread::sleep_for(gap);
+    while (!q->push(Stamp{now_ns()})) {
+      std::this_thread::yield();
+    }
+  }
+  consumer.join();
+  r.wall_ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+  std::sort(r.samples.begin(), r.samples.end());
+  return r;
+}
+
+std::string bucket_label(std::size_t i) {
+  const std::uint64_t lo = std::uint64_t{1} << i;
+  if (lo >= 1'000'000) {
+    return std::to_string(lo / 1'000'000) + "ms";
+  }
+  if (lo >= 1'000) {
+    return std::to_string(lo / 1'000) + "us";
+  }
+  return std::to_string(lo) + "ns";
+}
+
+void print_result(const Result& r) {
+  auto pick = [&](double frac) { return r.samples[static_cast<std::size_t>(frac * static_cast<double>(r.samples.size() - 1))]; };
+  std::cout << r.name << "\n";
+  std::cout << "  p50/p99/p99.9 (ns): " << pick(0.50) << " / " << pick(0.99) << " / " << pick(0.999) << "\n";
+  std::cout << "  consumer cpu: " << std::fixed << std::setprecision(1) << 100.0 * r.cpu_ms / r.wall_ms << "%\n"
+            << std::defaultfloat;
+  const auto peak = *std::max_element(r.hist.begin(), r.hist.end());
+  for (std::size_t i = 0; i < r.hist.size(); ++i) {
+    if (r.hist[i] == 0) {
+      continue;
+    }
+    const auto bar = static_cast<std::size_t>(40 * r.hist[i] / peak);
+    std::cout << "  >=" << std::setw(6) << bucket_label(i) << " " << std::setw(8) << r.hist[i] << " "
+              << std::string(std::max<std::size_t>(bar, 1), '#') << "\n";
+  }
+  std::cout << "\n";
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  std::size_t messages = 20'000;
+  std::chrono::microseconds gap{20};
+  if (argc > 1) {
+    messages = std::stoull(argv[1]);
+  }
+  if (argc > 2) {
+    gap = std::chrono::microseconds(std::stoll(argv[2]));
+  }
+  std::cout << "messages: " << messages << " gap: " << gap.count() << "us\n\n";
+  print_result(run("sleep 50us (old)", std::nullopt, messages, gap));
+  print_result(run("busy spin", hft::WaitConfig{hft::WaitKind::BusySpin}, messages, gap));
+  print_result(run("spin then yield", hft::WaitConfig{hft::WaitKind::SpinYield}, messages, gap));
+  print_result(run("spin then park", hft::WaitConfig{hft::WaitKind::SpinPark}, messages, gap));
+  return 0;
+}
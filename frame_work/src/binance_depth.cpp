@@ -6,70 +6,105 @@
 #include <boost/asio/ssl/error.hpp>
 #include <boost/asio/ssl/stream.hpp>
 #include <boost/beast/core.hpp>
+#include <boost/beast/http.hpp>
 #include <boost/beast/ssl.hpp>
 #include <boost/beast/websocket.hpp>
-#include <boost/json.hpp>
 #include <chrono>
+#include <stdexcept>
 #include <string_view>
 #include <thread>
 
+#include "binlog.h"
+
 namespace hft {
 
 namespace {
 namespace beast = boost::beast;
+namespace http = beast::http;
 namespace websocket = beast::websocket;
 namespace ssl = boost::asio::ssl;
 using tcp = boost::asio::ip::tcp;
-}  // namespace
 
+template <typename Stream>
+http::response<http::string_body> get(Stream& stream, const std::string& host, const std::string& target) {
+  http::request<http::empty_body> req{http::verb::get, target, 11};
+  req.set(http::field::host, host);
+  http::write(stream, req);
+  beast::flat_buffer buffer;
+  http::response<http::string_body> res;
+  http::read(stream, buffer, res);
+  return res;
+}
+
+}  // namespace
 
-// snapshot and rest? sync?
+bool BinanceEndpoint::parse_plain(const std::string& host_port) {
+  const auto colon = host_port.rfind(':');
+  if (colon == std::string::npos || colon == 0 || colon + 1 == host_port.size()) {
+    return false;
+  }
+  ws_host = rest_host = host_port.substr(0, colon);
+  ws_port = rest_port = host_port.substr(colon + 1);
+  tls = false;
+  return true;
+}
 
 BinanceDepthConnector::BinanceDepthConnector(std::atomic<bool>& running,
-                                             std::string symbol,
+                                             SymbolId symbol,
+                                             const SymbolRegistry& symbols,
                                              std::shared_ptr<MarketQueue> outbound,
-                                             std::shared_ptr<LogQueue> log_queue)
+                                             std::shared_ptr<LogQueue> log_queue,
+                                             BinanceEndpoint endpoint)
     : running_(running),
-      symbol_(std::move(symbol)),
-      outbound_(std::move(outbound)),
-      log_queue_(std::move(log_queue)) {
+      symbol_id_(symbol),
+      symbol_(symbols.name(symbol)),
+      rest_symbol_(symbols.name(symbol)),
+      log_queue_(log_queue),
+      endpoint_(std::move(endpoint)),
+      depth_(running, symbol, std::move(outbound), std::move(log_queue)) {
   std::transform(symbol_.begin(), symbol_.end(), symbol_.begin(), ::tolower);
 }
 
 void BinanceDepthConnector::run() {
 #ifdef ENABLE_BINANCE
-  try {
-    const std::string host = "stream.binance.com";
-    const std::string port = "9443";
-    const std::string target = "/ws/" + symbol_ + "@depth5@100ms";
-
-    boost::asio::io_context ioc;
-    ssl::context ctx{ssl::context::tls_client};
-    ctx.set_default_verify_paths();
-    ctx.set_verify_mode(ssl::verify_peer);
-
-    tcp::resolver resolver{ioc};
-    auto const results = resolver.resolve(host, port);
-
-    websocket::stream<ssl::stream<tcp::socket>> ws{ioc, ctx};
-    beast::get_lowest_layer(ws).connect(results);
-    ws.next_layer().handshake(ssl::stream_base::client);
-    ws.set_option(websocket::stream_base::timeout::suggested(beast::role_type::client));
-    ws.handshake(host, target);
-    log("connected to " + target);
-
-    beast::flat_buffer buffer;
-    while (running_.load(std::memory_order_acquire)) {
-      buffer.clear();
-      ws.read(buffer);
-      const std::string payload = beast::buffers_to_string(buffer.data());
-      handle_message(payload);
+  const std::string target = "/ws/" + symbol_ + "@depth@100ms";
+  while (running_.load(std::memory_order_acquire)) {
+    try {
+      boost::asio::io_context ioc;
+      tcp::resolver resolver{ioc};
+      auto const results = resolver.resolve(endpoint_.ws_host, endpoint_.ws_port);
+      if (endpoint_.tls) {
+        ssl::context ctx{ssl::context::tls_client};
+        ctx.set_default_verify_paths();
+        ctx.set_verify_mode(ssl::verify_peer);
+        websocket::stream<beast::ssl_stream<beast::tcp_stream>> ws{ioc, ctx};
+        if (!SSL_set_tlsext_host_name(ws.next_layer().native_handle(), endpoint_.ws_host.c_str())) {
+          throw beast::system_error(static_cast<int>(::ERR_get_error()), boost::asio::error::get_ssl_category());
+        }
+        beast::get_lowest_layer(ws).connect(results);
+        beast::get_lowest_layer(ws).expires_never();
+        ws.next_layer().handshake(ssl::stream_base::client);
+        ws.set_option(websocket::stream_base::timeout::suggested(beast::role_type::client));
+        ws.handshake(endpoint_.ws_host, target);
+        log("connected to " + target);
+        stream(ws);
+      } else {
+        websocket::stream<beast::tcp_stream> ws{ioc};
+        beast::get_lowest_layer(ws).connect(results);
+        beast::get_lowest_layer(ws).expires_never();
+        ws.set_option(websocket::stream_base::timeout::suggested(beast::role_type::client));
+        ws.handshake(endpoint_.ws_host + ":" + endpoint_.ws_port, target);
+        log("connected to " + target + " (plain)");
+        stream(ws);
+      }
+    } catch (const std::exception& ex) {
+      log(std::string("binance error: ") + ex.what());
+    }
+    // Every connection bootstraps from a fresh snapshot.
+    depth_.reset();
+    for (int i = 0; i < 10 && running_.load(std::memory_order_acquire); ++i) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(100));
     }
-
-    beast::error_code ec;
-    ws.close(websocket::close_code::normal, ec);
-  } catch (const std::exception& ex) {
-    log(std::string("binance error: ") + ex.what());
   }
 #else
   log("Binance support is disabled at compile time");
@@ -79,46 +114,90 @@ void BinanceDepthConnector::run() {
 #endif
 }
 
-void BinanceDepthConnector::handle_message(const std::string& payload) {
-  try {
-    auto jv = boost::json::parse(payload);
-    const auto& obj = jv.as_object();
-    const auto& bids = obj.at("b").as_array();
-    const auto& asks = obj.at("a").as_array();
-    const auto update_id = obj.at("u").as_int64();
-
-    std::vector<PriceLevel> bid_lvls;
-    std::vector<PriceLevel> ask_lvls;
-    bid_lvls.reserve(bids.size());
-    ask_lvls.reserve(asks.size());
-
-    for (const auto& entry : bids) {
-      const auto& arr = entry.as_array();
-      const double px = std::stod(std::string(arr.at(0).as_string().c_str()));
-      const double qty = std::stod(std::string(arr.at(1).as_string().c_str()));
-      bid_lvls.push_back({px, qty});
+template <typename Ws>
+void BinanceDepthConnector::stream(Ws& ws) {
+  beast::flat_buffer buffer;
+  while (running_.load(std::memory_order_acquire)) {
+    buffer.clear();
+    ws.read(buffer);
+    // flat_buffer keeps the frame contiguous, so it is parsed where it landed.
+    const std::string_view frame(static_cast<const char*>(buffer.data().data()), buffer.size());
+    if (capture_ != nullptr) {
+      capture_->write(CaptureKind::DepthDiff, symbol_id_, capture_now_ns(), frame.data(), frame.size());
     }
-    for (const auto& entry : asks) {
-      const auto& arr = entry.as_array();
-      const double px = std::stod(std::string(arr.at(0).as_string().c_str()));
-      const double qty = std::stod(std::string(arr.at(1).as_string().c_str()));
-      ask_lvls.push_back({px, qty});
+    depth_.on_diff(frame);
+    // Diffs keep arriving on the socket while the snapshot loads; the next passes
+    // read and replay or buffer them.
+    if (depth_.needs_snapshot()) {
+      maybe_load_snapshot();
     }
+  }
+  beast::error_code ec;
+  ws.close(websocket::close_code::normal, ec);
+}
 
-    book_.apply_deltas(bid_lvls, ask_lvls, update_id);
-    if (const auto best = book_.best()) {
-      MarketEvent evt{symbol_, best->bid, best->ask, std::min(best->bid_qty, best->ask_qty), best->update_id};
-      if (!outbound_->push(evt)) {
-        log("drop market evt seq=" + std::to_string(best->update_id));
-      }
-    }
+void BinanceDepthConnector::maybe_load_snapshot() {
+  const auto now = std::chrono::steady_clock::now();
+  if (now < next_snapshot_) {
+    return;
+  }
+  if (load_snapshot()) {
+    snapshot_backoff_ = kSnapshotMinInterval;
+  } else {
+    snapshot_backoff_ = std::min(snapshot_backoff_ * 2, kSnapshotMaxInterval);
+    log("next snapshot in " + std::to_string(snapshot_backoff_.count()) + "ms");
+  }
+  next_snapshot_ = now + snapshot_backoff_;
+}
+
+bool BinanceDepthConnector::load_snapshot() {
+  std::string body;
+  try {
+    body = fetch_snapshot();
   } catch (const std::exception& ex) {
-    log(std::string("parse error: ") + ex.what());
+    log(std::string("snapshot error: ") + ex.what());
+    return false;
+  }
+  if (capture_ != nullptr) {
+    capture_->write(CaptureKind::DepthSnapshot, symbol_id_, capture_now_ns(), body.data(), body.size());
+  }
+  return depth_.on_snapshot(body);
+}
+
+std::string BinanceDepthConnector::fetch_snapshot() {
+  const std::string target = "/api/v3/depth?symbol=" + rest_symbol_ + "&limit=" + std::to_string(kSnapshotDepth);
+  boost::asio::io_context ioc;
+  tcp::resolver resolver{ioc};
+  auto const results = resolver.resolve(endpoint_.rest_host, endpoint_.rest_port);
+  http::response<http::string_body> res;
+  if (endpoint_.tls) {
+    ssl::context ctx{ssl::context::tls_client};
+    ctx.set_default_verify_paths();
+    ctx.set_verify_mode(ssl::verify_peer);
+    beast::ssl_stream<beast::tcp_stream> stream{ioc, ctx};
+    if (!SSL_set_tlsext_host_name(stream.native_handle(), endpoint_.rest_host.c_str())) {
+      throw beast::system_error(static_cast<int>(::ERR_get_error()), boost::asio::error::get_ssl_category());
+    }
+    beast::get_lowest_layer(stream).connect(results);
+    stream.handshake(ssl::stream_base::client);
+    res = get(stream, endpoint_.rest_host, target);
+    beast::error_code ec;
+    stream.shutdown(ec);
+  } else {
+    beast::tcp_stream stream{ioc};
+    stream.connect(results);
+    res = get(stream, endpoint_.rest_host, target);
+    beast::error_code ec;
+    stream.socket().shutdown(tcp::socket::shutdown_both, ec);
+  }
+  if (res.result() != http::status::ok) {
+    throw std::runtime_error("snapshot HTTP " + std::to_string(res.result_int()));
   }
+  return std::move(res.body());
 }
 
 void BinanceDepthConnector::log(const std::string& msg) {
-  log_queue_->push(LogEvent{"binance", msg, std::chrono::steady_clock::now()});
+  HFT_LOG(*log_queue_, "%s", msg);
 }
 
 }  // namespace hft
@@ -1,33 +1,73 @@
 #pragma once
 
 #include <atomic>
+#include <chrono>
 #include <memory>
 #include <string>
-#include <vector>
+#include <string_view>
 
-#include "order_book.h"
+#include "capture.h"
+#include "depth_feed.h"
 #include "types.h"
 
 namespace hft {
 
+// Where the diff stream and the REST snapshot come from. The defaults are Binance
+// spot over TLS; tools/depth_standin serves both in plain text on one local port.
+struct BinanceEndpoint {
+  std::string ws_host = "stream.binance.com";
+  std::string ws_port = "9443";
+  std::string rest_host = "api.binance.com";
+  std::string rest_port = "443";
+  bool tls = true;
+
+  // "HOST:PORT": plain WebSocket and HTTP, both on that port.
+  bool parse_plain(const std::string& host_port);
+};
+
+// Maintains a full-depth book from <symbol>@depth@100ms, bootstrapped from the REST
+// snapshot and kept in sequence by DepthSync. A sequence gap triggers a new snapshot
+// on the open stream; a dropped connection reconnects and starts over. Snapshot
+// requests are at least kSnapshotMinInterval apart, and each one that fails or comes
+// back stale doubles the wait before the next, up to kSnapshotMaxInterval. With a capture
+// attached, every diff frame and snapshot body is recorded as received.
 class BinanceDepthConnector {
  public:
   BinanceDepthConnector(std::atomic<bool>& running,
-                        std::string symbol,
+                        SymbolId symbol,
+                        const SymbolRegistry& symbols,
                         std::shared_ptr<MarketQueue> outbound,
-                        std::shared_ptr<LogQueue> log_queue);
+                        std::shared_ptr<LogQueue> log_queue,
+                        BinanceEndpoint endpoint = {});
 
+  // Set before run(); the writer must outlive the connector thread.
+  void set_capture(CaptureWriter* capture) { capture_ = capture; }
   void run();
+  // Events published for sym; read after run() returns.
+  std::int64_t event_count(SymbolId sym) const { return sym == symbol_id_ ? depth_.event_count() : 0; }
 
  private:
+  static constexpr int kSnapshotDepth = 1000;
+  static constexpr std::chrono::milliseconds kSnapshotMinInterval{250};
+  static constexpr std::chrono::milliseconds kSnapshotMaxInterval{30000};
+
   void log(const std::string& msg);
-  void handle_message(const std::string& payload);
+  template <typename Ws>
+  void stream(Ws& ws);
+  void maybe_load_snapshot();
+  bool load_snapshot();
+  std::string fetch_snapshot();
 
   std::atomic<bool>& running_;
-  std::string symbol_;
-  std::shared_ptr<MarketQueue> outbound_;
+  SymbolId symbol_id_;
+  std::string symbol_;       // lower-case stream name
+  std::string rest_symbol_;  // upper-case REST parameter
   std::shared_ptr<LogQueue> log_queue_;
-  OrderBook book_;
+  BinanceEndpoint endpoint_;
+  DepthFeed depth_;
+  CaptureWriter* capture_{nullptr};
+  std::chrono::steady_clock::time_point next_snapshot_{};
+  std::chrono::milliseconds snapshot_backoff_{kSnapshotMinInterval};
 };
 
 }  // namespace hft
@@ -0,0 +1,218 @@
+#include "binlog.h"
+
+#include <array>
+#include <atomic>
+#include <cstdio>
+#include <iostream>
+#include <mutex>
+
+namespace hft {
+
+namespace {
+
+std::mutex g_format_mutex;
+std::size_t g_format_count = 0;
+std::array<LogFormat, kMaxLogFormats> g_formats;
+std::array<std::atomic<const LogFormat*>, kMaxLogFormats> g_format_index{};
+
+bool is_int_conv(char c) { return c == 'd' || c == 'i' || c == 'c'; }
+bool is_uint_conv(char c) { return c == 'u' || c == 'o' || c == 'x' || c == 'X'; }
+bool is_float_conv(char c) {
+  return c == 'f' || c == 'F' || c == 'e' || c == 'E' || c == 'g' || c == 'G' || c == 'a' || c == 'A';
+}
+
+// Cursor over an encoded payload, typed by the call site's signature.
+class ArgReader {
+ public:
+  ArgReader(std::span<const LogArgType> types, const std::uint8_t* p, std::size_t len)
+      : types_(types), p_(p), end_(p + len) {}
+
+  bool next(LogArgType& type, std::int64_t& i, std::uint64_t& u, double& d, std::string_view& s) {
+    if (idx_ >= types_.size()) {
+      return false;
+    }
+    type = types_[idx_++];
+    if (type == LogArgType::Str) {
+      if (p_ >= end_) {
+        return false;
+      }
+      const std::size_t prefix = *p_++;
+      const std::size_t n = std::min(prefix, static_cast<std::size_t>(end_ - p_));
+      s = std::string_view(reinterpret_cast<const char*>(p_), n);
+      p_ += n;
+      return true;
+    }
+    if (end_ - p_ < 8) {
+      return false;
+    }
+    if (type == LogArgType::F64) {
+      std::memcpy(&d, p_, 8);
+      i = static_cast<std::int64_t>(d);
+      u = static_cast<std::uint64_t>(i);
+    } else if (type == LogArgType::I64) {
+      std::memcpy(&i, p_, 8);
+      u = static_cast<std::uint64_t>(i);
+      d = static_cast<double>(i);
+    } else {
+      std::memcpy(&u, p_, 8);
+      i = static_cast<std::int64_t>(u);
+      d = static_cast<double>(u);
+    }
+    p_ += 8;
+    return true;
+  }
+
+ private:
+  std::span<const LogArgType> types_;
+  std::size_t idx_ = 0;
+  const std::uint8_t* p_;
+  const std::uint8_t* end_;
+};
+
+}  // namespace
+
+std::uint16_t register_log_format(const char* fmt, std::span<const LogArgType> types) {
+  std::lock_guard<std::mutex> lock(g_format_mutex);
+  if (g_format_count == kMaxLogFormats) {
+    std::cerr << "binlog: format table full, dropping '" << fmt << "'\n";
+    return 0;
+  }
+  const auto id = static_cast<std::uint16_t>(g_format_count++);
+  LogFormat& f = g_formats[id];
+  f.fmt = fmt;
+  f.nargs = static_cast<std::uint8_t>(types.size());
+  std::copy(types.begin(), types.end(), f.types);
+  g_format_index[id].store(&f, std::memory_order_release);
+  return id;
+}
+
+const LogFormat* find_log_format(std::uint16_t id) {
+  return id < kMaxLogFormats ? g_format_index[id].load(std::memory_order_acquire) : nullptr;
+}
+
+// Walks the printf format; each conversion is re-issued to snprintf on its own with the
+// length modifier replaced to match how the argument was stored.
+std::size_t render_log_text(const char* fmt, std::span<const LogArgType> types, const std::uint8_t* payload,
+                            std::size_t len, char* out, std::size_t cap) {
+  if (cap == 0) {
+    return 0;
+  }
+  ArgReader args(types, payload, len);
+  std::size_t n = 0;
+  auto put = [&](const char* s, std::size_t k) {
+    k = std::min(k, cap - 1 - n);
+    std::memcpy(out + n, s, k);
+    n += k;
+  };
+  auto put_printf = [&](const char* spec, auto... v) {
+    const int k = std::snprintf(out + n, cap - n, spec, v...);
+    if (k > 0) {
+      n += std::min<std::size_t>(static_cast<std::size_t>(k), cap - 1 - n);
+    }
+  };
+
+  for (const char* c = fmt; *c != '\0' && n + 1 < cap;) {
+    if (*c != '%') {
+      const char* lit = c;
+      while (*c != '\0' && *c != '%') {
+        ++c;
+      }
+      put(lit, static_cast<std::size_t>(c - lit));
+      continue;
+    }
+    if (c[1] == '%') {
+      put("%", 1);
+      c += 2;
+      continue;
+    }
+
+    // %[flags][width][.precision][length]conv; '*' width/precision consume an argument.
+    char spec[32];
+    std::size_t sl = 0;
+    int stars[2];
+    int nstars = 0;
+    spec[sl++] = *c++;
+    bool ok = true;
+    while (*c != '\0' && std::strchr("-+ #0123456789.*", *c) != nullptr) {
+      if (*c == '*') {
+        LogArgType t;
+        std::int64_t i = 0;
+        std::uint64_t u = 0;
+        double d = 0;
+        std::string_view s;
+        ok = nstars < 2 && args.next(t, i, u, d, s);
+        stars[nstars < 2 ? nstars++ : 1] = static_cast<int>(i);
+      }
+      if (sl < sizeof(spec) - 4) {
+        spec[sl++] = *c;
+      }
+      ++c;
+    }
+    while (*c != '\0' && std::strchr("hlLqjzt", *c) != nullptr) {
+      ++c;
+    }
+    const char conv = *c;
+    if (conv == '\0') {
+      break;
+    }
+    ++c;
+
+    LogArgType t{};
+    std::int64_t i = 0;
+    std::uint64_t u = 0;
+    double d = 0;
+    std::string_view s;
+    if (!ok || !args.next(t, i, u, d, s)) {
+      put("<?>", 3);
+      continue;
+    }
+    auto emit = [&](auto v) {
+      if (nstars == 0) {
+        put_printf(spec, v);
+      } else if (nstars == 1) {
+        put_printf(spec, stars[0], v);
+      } else {
+        put_printf(spec, stars[0], stars[1], v);
+      }
+    };
+    if (is_int_conv(conv) || is_uint_conv(conv)) {
+      if (conv != 'c') {
+        spec[sl++] = 'l';
+        spec[sl++] = 'l';
+      }
+      spec[sl++] = conv;
+      spec[sl] = '\0';
+      if (conv == 'c') {
+        emit(static_cast<int>(i));
+      } else if (is_int_conv(conv)) {
+        emit(static_cast<long long>(i));
+      } else {
+        emit(static_cast<unsigned long long>(u));
+      }
+    } else if (is_float_conv(conv)) {
+      spec[sl++] = conv;
+      spec[sl] = '\0';
+      emit(d);
+    } else if (conv == 's' && t == LogArgType::Str) {
+      char str[256];
+      std::memcpy(str, s.data(), s.size());
+      str[s.size()] = '\0';
+      spec[sl++] = 's';
+      spec[sl] = '\0';
+      emit(static_cast<const char*>(str));
+    } else {
+      // Type/conversion mismatch: print the stored value plainly.
+      if (t == LogArgType::Str) {
+        put(s.data(), s.size());
+      } else if (t == LogArgType::F64) {
+        put_printf("%g", d);
+      } else {
+        put_printf("%lld", static_cast<long long>(i));
+      }
+    }
+  }
+  out[n] = '\0';
+  return n;
+}
+
+}  // namespace hft
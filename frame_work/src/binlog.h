@@ -0,0 +1,158 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <string_view>
+#include <type_traits>
+
+#include "types.h"
+
+namespace hft {
+
+// Structured binary logging. A call site is a printf-style format registered once (per
+// call site) for a small ID; each log() copies that ID and the raw argument bytes into a
+// LogEvent claimed in the source's SpscQueue. No formatting happens on the caller's
+// thread: the Logger thread renders text, or writes records verbatim for log_decode.
+//
+//   HFT_LOG(*log_queue_, "drop order seq=%lld", d.seq);
+//
+// Integers travel as 64-bit, floats as double, strings (const char*, std::string,
+// std::string_view) as length-prefixed bytes truncated to what fits in the record.
+
+enum class LogArgType : std::uint8_t { I64 = 1, U64 = 2, F64 = 3, Str = 4 };
+
+constexpr std::size_t kMaxLogFormats = 4096;
+constexpr std::size_t kMaxLogArgs = 16;
+
+struct LogFormat {
+  const char* fmt{};
+  std::uint8_t nargs{};
+  LogArgType types[kMaxLogArgs]{};
+};
+
+// Registers a call site; thread-safe, called once per site. Returns its format ID.
+std::uint16_t register_log_format(const char* fmt, std::span<const LogArgType> types);
+// Format for an ID, or nullptr. Safe from any thread once a record carrying it was seen.
+const LogFormat* find_log_format(std::uint16_t id);
+
+// Renders one record's text (without newline) into out; returns bytes written.
+std::size_t render_log_text(const char* fmt, std::span<const LogArgType> types, const std::uint8_t* payload,
+                            std::size_t len, char* out, std::size_t cap);
+
+template <typename T>
+constexpr LogArgType log_arg_type() {
+  using U = std::remove_cvref_t<T>;
+  if constexpr (std::is_same_v<U, bool> || (std::is_integral_v<U> && std::is_signed_v<U>) || std::is_enum_v<U>) {
+    return LogArgType::I64;
+  } else if constexpr (std::is_integral_v<U>) {
+    return LogArgType::U64;
+  } else if constexpr (std::is_floating_point_v<U>) {
+    return LogArgType::F64;
+  } else {
+    static_assert(std::is_convertible_v<const U&, std::string_view>, "unsupported log argument type");
+    return LogArgType::Str;
+  }
+}
+
+namespace detail {
+
+template <typename T>
+inline std::uint8_t* encode_log_arg(std::uint8_t* p, std::uint8_t* end, const T& v) {
+  constexpr auto type = log_arg_type<T>();
+  if constexpr (type == LogArgType::Str) {
+    const std::string_view s(v);
+    if (p == end) {
+      return p;
+    }
+    const std::size_t n = std::min<std::size_t>({s.size(), 255, static_cast<std::size_t>(end - p - 1)});
+    *p++ = static_cast<std::uint8_t>(n);
+    std::memcpy(p, s.data(), n);
+    return p + n;
+  } else {
+    if (end - p < 8) {
+      return end;  // record full; the decoder prints the rest as missing
+    }
+    if constexpr (type == LogArgType::F64) {
+      const double d = static_cast<double>(v);
+      std::memcpy(p, &d, 8);
+    } else if constexpr (type == LogArgType::I64) {
+      const std::int64_t i = static_cast<std::int64_t>(v);
+      std::memcpy(p, &i, 8);
+    } else {
+      const std::uint64_t u = static_cast<std::uint64_t>(v);
+      std::memcpy(p, &u, 8);
+    }
+    return p + 8;
+  }
+}
+
+// Never called: HFT_LOG names these in an unevaluated operand so -Wformat checks each
+// call site's literal, as it did when logging was printf. Arguments are checked as the
+// type they travel as, so integers take %lld/%llu and strings %s.
+template <typename T>
+using log_format_arg_t = std::conditional_t<
+    log_arg_type<T>() == LogArgType::I64, long long,
+    std::conditional_t<log_arg_type<T>() == LogArgType::U64, unsigned long long,
+                       std::conditional_t<log_arg_type<T>() == LogArgType::F64, double, const char*>>>;
+template <typename T>
+log_format_arg_t<T> log_format_arg(const T&);
+[[gnu::format(printf, 1, 2)]] int check_log_format(const char* fmt, ...);
+
+}  // namespace detail
+
+// FmtFn is a captureless lambda returning the format literal, so every call site is its
+// own instantiation with its own once-only registration.
+template <typename FmtFn, typename... Args>
+bool log_record(FmtFn, LogQueue& q, const Args&... args) {
+  static_assert(sizeof...(Args) <= kMaxLogArgs, "too many log arguments");
+  static const std::uint16_t id = [] {
+    constexpr LogArgType types[sizeof...(Args) + 1] = {log_arg_type<Args>()..., LogArgType::I64};
+    return register_log_format(FmtFn{}(), std::span<const LogArgType>(types, sizeof...(Args)));
+  }();
+  LogEvent* evt = q.try_claim();
+  if (evt == nullptr) {
+    return false;
+  }
+  evt->ts_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch())
+                   .count();
+  evt->fmt = id;
+  std::uint8_t* p = evt->payload;
+  if constexpr (sizeof...(Args) > 0) {
+    std::uint8_t* const end = evt->payload + sizeof(evt->payload);
+    ((p = detail::encode_log_arg(p, end, args)), ...);
+  }
+  evt->len = static_cast<std::uint16_t>(p - evt->payload);
+  q.commit();
+  return true;
+}
+
+// On-disk layout of the Logger's binary mode, read back by tools/log_decode:
+//   "HFTLOG1\0", i64 start_ns, then records, each a u8 kind followed by
+//   kLogRecFormat: u16 id, u8 nargs, u8 types[nargs], u16 len, fmt bytes
+//   kLogRecSource: u16 source, u16 len, name bytes
+//   kLogRecEvent:  u16 source, i64 ts_ns, u16 fmt, u16 len, payload bytes
+constexpr char kLogFileMagic[8] = {'H', 'F', 'T', 'L', 'O', 'G', '1', '\0'};
+constexpr std::uint8_t kLogRecFormat = 1;
+constexpr std::uint8_t kLogRecSource = 2;
+constexpr std::uint8_t kLogRecEvent = 3;
+
+}  // namespace hft
+
+#define HFT_LOG(queue, fmt, ...)                                                                \
+  (static_cast<void>(sizeof(::hft::detail::check_log_format(fmt HFT_LOG_FORMAT_ARGS(__VA_ARGS__)))), \
+   ::hft::log_record([] { return fmt; }, queue __VA_OPT__(, ) __VA_ARGS__))
+
+// ", log_format_arg(a)" for each argument a, by rescanning a self-referencing macro.
+#define HFT_LOG_FORMAT_ARGS(...) __VA_OPT__(HFT_LOG_EXPAND(HFT_LOG_FORMAT_ARGS_(__VA_ARGS__)))
+#define HFT_LOG_FORMAT_ARGS_(a, ...) \
+  , ::hft::detail::log_format_arg(a) __VA_OPT__(HFT_LOG_FORMAT_ARGS_AGAIN HFT_LOG_PARENS(__VA_ARGS__))
+#define HFT_LOG_FORMAT_ARGS_AGAIN() HFT_LOG_FORMAT_ARGS_
+#define HFT_LOG_PARENS ()
+#define HFT_LOG_EXPAND(...) HFT_LOG_EXPAND2(HFT_LOG_EXPAND2(HFT_LOG_EXPAND2(HFT_LOG_EXPAND2(__VA_ARGS__))))
+#define HFT_LOG_EXPAND2(...) HFT_LOG_EXPAND1(HFT_LOG_EXPAND1(HFT_LOG_EXPAND1(HFT_LOG_EXPAND1(__VA_ARGS__))))
+#define HFT_LOG_EXPAND1(...) __VA_ARGS__
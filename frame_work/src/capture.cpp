@@ -0,0 +1,166 @@
+#include "capture.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+namespace hft {
+
+std::int64_t capture_now_ns() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+CaptureWriter::CaptureWriter() : buf_(kBufferSize) {}
+
+CaptureWriter::~CaptureWriter() {
+  flush();
+  if (fd_ >= 0) {
+    ::close(fd_);
+  }
+}
+
+bool CaptureWriter::open(const std::string& path) {
+  const int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+  if (fd < 0) {
+    perror(path.c_str());
+    return false;
+  }
+  struct stat st {};
+  if (::fstat(fd, &st) != 0) {
+    perror(path.c_str());
+    ::close(fd);
+    return false;
+  }
+  fd_ = fd;
+  if (st.st_size == 0) {
+    append(kCaptureMagic, sizeof(kCaptureMagic));
+  }
+  return true;
+}
+
+void CaptureWriter::write_symbols(const SymbolRegistry& symbols) {
+  const auto now = capture_now_ns();
+  for (std::size_t i = 0; i < symbols.size(); ++i) {
+    const auto name = symbols.name(static_cast<SymbolId>(i));
+    write(CaptureKind::Symbol, static_cast<SymbolId>(i), now, name.data(), name.size());
+  }
+}
+
+void CaptureWriter::write(CaptureKind kind, SymbolId symbol, std::int64_t recv_ns, const void* data, std::size_t len) {
+  const CaptureRecordHeader hdr{recv_ns, static_cast<std::uint32_t>(len), symbol, kind, 0};
+  append(&hdr, sizeof(hdr));
+  append(data, len);
+}
+
+void CaptureWriter::append(const void* p, std::size_t n) {
+  const auto* src = static_cast<const char*>(p);
+  while (n > 0) {
+    if (used_ == buf_.size() && !flush()) {
+      return;
+    }
+    const std::size_t chunk = std::min(n, buf_.size() - used_);
+    std::memcpy(buf_.data() + used_, src, chunk);
+    used_ += chunk;
+    src += chunk;
+    n -= chunk;
+  }
+}
+
+bool CaptureWriter::flush() {
+  if (fd_ < 0) {
+    used_ = 0;
+    return false;
+  }
+  std::size_t done = 0;
+  while (done < used_) {
+    const ssize_t written = ::write(fd_, buf_.data() + done, used_ - done);
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      perror("capture write");
+      used_ = 0;
+      return false;
+    }
+    done += static_cast<std::size_t>(written);
+  }
+  used_ = 0;
+  return true;
+}
+
+CaptureReader::~CaptureReader() {
+  if (data_ != nullptr) {
+    ::munmap(const_cast<char*>(data_), size_);
+  }
+}
+
+bool CaptureReader::open(const std::string& path) {
+  const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    perror(path.c_str());
+    return false;
+  }
+  struct stat st {};
+  if (::fstat(fd, &st) != 0 || static_cast<std::size_t>(st.st_size) < sizeof(kCaptureMagic)) {
+    std::cerr << "capture: " << path << " is not a capture file\n";
+    ::close(fd);
+    return false;
+  }
+  size_ = static_cast<std::size_t>(st.st_size);
+  void* p = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE | MAP_POPULATE, fd, 0);
+  ::close(fd);
+  if (p == MAP_FAILED) {
+    perror("capture mmap");
+    size_ = 0;
+    return false;
+  }
+  data_ = static_cast<const char*>(p);
+  ::madvise(p, size_, MADV_SEQUENTIAL);
+  if (std::memcmp(data_, kCaptureMagic, sizeof(kCaptureMagic)) != 0) {
+    std::cerr << "capture: " << path << " has a bad header\n";
+    return false;
+  }
+  rewind();
+  return true;
+}
+
+bool CaptureReader::next(CaptureRecord& rec) {
+  if (size_ - pos_ < sizeof(CaptureRecordHeader)) {
+    truncated_ = pos_ != size_;
+    return false;
+  }
+  CaptureRecordHeader hdr;
+  std::memcpy(&hdr, data_ + pos_, sizeof(hdr));
+  if (size_ - pos_ - sizeof(hdr) < hdr.len) {
+    truncated_ = true;
+    return false;
+  }
+  rec.recv_ns = hdr.recv_ns;
+  rec.kind = hdr.kind;
+  rec.symbol = hdr.symbol;
+  rec.payload = std::string_view(data_ + pos_ + sizeof(hdr), hdr.len);
+  pos_ += sizeof(hdr) + hdr.len;
+  return true;
+}
+
+void CaptureReader::intern_symbols(SymbolRegistry& symbols) {
+  rewind();
+  CaptureRecord rec;
+  while (next(rec)) {
+    if (rec.kind == CaptureKind::Symbol) {
+      symbols.intern(rec.payload);
+    }
+  }
+  rewind();
+}
+
+}  // namespace hft
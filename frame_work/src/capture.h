@@ -0,0 +1,110 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "symbol_registry.h"
+
+namespace hft {
+
+// On-disk layout of a feed capture (hft_demo --capture), replayed by ReplayFeed:
+//   "HFTCAP1\0", then records, each a 16-byte header followed by len payload bytes:
+//   i64 recv_ns (steady_clock), u32 len, u16 symbol, u8 kind, u8 reserved
+// Symbol IDs are those of the capturing run; a kCapSymbol record (payload = name)
+// binds an ID to a name and precedes any record that uses it. Captures are opened
+// for append, so one file may hold several sessions, each starting with its own
+// symbol records.
+constexpr char kCaptureMagic[8] = {'H', 'F', 'T', 'C', 'A', 'P', '1', '\0'};
+
+enum class CaptureKind : std::uint8_t {
+  Symbol = 1,         // symbol name
+  MarketEvent = 2,    // CapturedMarketEvent from the simulated feed
+  DepthDiff = 3,      // raw WebSocket depthUpdate frame
+  DepthSnapshot = 4,  // raw REST /api/v3/depth body
+};
+
+struct CaptureRecordHeader {
+  std::int64_t recv_ns;
+  std::uint32_t len;
+  std::uint16_t symbol;
+  CaptureKind kind;
+  std::uint8_t reserved;
+};
+static_assert(sizeof(CaptureRecordHeader) == 16);
+
+// Payload of a MarketEvent record, fixed at the HFTCAP1 layout of MarketEvent so that
+// fields added to the in-memory struct (such as recv_tsc, which means nothing in
+// another run) never change what is on disk. The record header carries the symbol.
+struct CapturedMarketEvent {
+  std::uint8_t reserved[8];
+  double bid;
+  double ask;
+  double size;
+  std::int64_t seq;
+};
+static_assert(sizeof(CapturedMarketEvent) == 40);
+
+std::int64_t capture_now_ns();
+
+// Single-writer append-only capture. Records are staged in a fixed buffer and written
+// out when it fills and on flush()/destruction, so a write is usually one memcpy.
+class CaptureWriter {
+ public:
+  CaptureWriter();
+  ~CaptureWriter();
+  CaptureWriter(const CaptureWriter&) = delete;
+  CaptureWriter& operator=(const CaptureWriter&) = delete;
+
+  bool open(const std::string& path);
+  void write_symbols(const SymbolRegistry& symbols);
+  void write(CaptureKind kind, SymbolId symbol, std::int64_t recv_ns, const void* data, std::size_t len);
+  bool flush();
+
+ private:
+  static constexpr std::size_t kBufferSize = std::size_t{1} << 20;
+
+  void append(const void* p, std::size_t n);
+
+  int fd_{-1};
+  std::vector<char> buf_;
+  std::size_t used_{0};
+};
+
+struct CaptureRecord {
+  std::int64_t recv_ns{};
+  CaptureKind kind{};
+  SymbolId symbol{};
+  std::string_view payload;
+};
+
+// Read-only mmap of a capture. A record cut short at the end of the file (capture
+// killed mid-write) ends iteration and is reported by truncated().
+class CaptureReader {
+ public:
+  CaptureReader() = default;
+  ~CaptureReader();
+  CaptureReader(const CaptureReader&) = delete;
+  CaptureReader& operator=(const CaptureReader&) = delete;
+
+  bool open(const std::string& path);
+  void rewind() {
+    pos_ = sizeof(kCaptureMagic);
+    truncated_ = false;
+  }
+  bool next(CaptureRecord& rec);
+  bool truncated() const { return truncated_; }
+
+  // Interns every symbol the capture names; call before the registry is frozen.
+  void intern_symbols(SymbolRegistry& symbols);
+
+ private:
+  const char* data_{nullptr};
+  std::size_t size_{0};
+  std::size_t pos_{0};
+  bool truncated_{false};
+};
+
+}  // namespace hft
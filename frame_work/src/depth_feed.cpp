@@ -0,0 +1,80 @@
+#include "depth_feed.h"
+
+#include <algorithm>
+
+#include "binlog.h"
+#include "tsc.h"
+#include "wait_strategy.h"
+
+namespace hft {
+
+DepthFeed::DepthFeed(std::atomic<bool>& running,
+                     SymbolId symbol,
+                     std::shared_ptr<MarketQueue> outbound,
+                     std::shared_ptr<LogQueue> log_queue,
+                     OnFull on_full)
+    : running_(running),
+      symbol_(symbol),
+      outbound_(std::move(outbound)),
+      log_queue_(std::move(log_queue)),
+      on_full_(on_full) {}
+
+void DepthFeed::on_diff(std::string_view frame) {
+  const std::uint64_t recv_tsc = tsc_now();
+  DepthUpdate update;
+  if (!parser_.parse_update(frame, update)) {
+    HFT_LOG(*log_queue_, "depth parse error: %s", frame.substr(0, 64));
+    return;
+  }
+  switch (sync_.on_update(update)) {
+    case DepthSync::Status::Applied:
+      publish(recv_tsc);
+      break;
+    case DepthSync::Status::Gap:
+      HFT_LOG(*log_queue_, "depth gap at U=%lld, resyncing", update.first_id);
+      break;
+    case DepthSync::Status::Overflow:
+      HFT_LOG(*log_queue_, "depth buffer overflow while waiting for snapshot");
+      break;
+    case DepthSync::Status::Buffered:
+    case DepthSync::Status::Stale:
+      break;
+  }
+}
+
+bool DepthFeed::on_snapshot(std::string_view body) {
+  const std::uint64_t recv_tsc = tsc_now();
+  DepthSnapshot snapshot;
+  if (!parser_.parse_snapshot(body, snapshot)) {
+    HFT_LOG(*log_queue_, "snapshot parse error");
+    return false;
+  }
+  if (!sync_.on_snapshot(snapshot)) {
+    HFT_LOG(*log_queue_, "snapshot %lld older than buffered diffs, refetching", snapshot.last_update_id);
+    return false;
+  }
+  HFT_LOG(*log_queue_, "book synced at %lld", snapshot.last_update_id);
+  if (sync_.live()) {
+    publish(recv_tsc);
+  }
+  return true;
+}
+
+void DepthFeed::publish(std::uint64_t recv_tsc) {
+  const auto best = book_.best();
+  if (!best) {
+    return;
+  }
+  ++events_;
+  const MarketEvent evt{symbol_, best->bid, best->ask, std::min(best->bid_qty, best->ask_qty), best->update_id,
+                        recv_tsc};
+  while (!outbound_->push(evt)) {
+    if (on_full_ == OnFull::Drop || !running_.load(std::memory_order_relaxed)) {
+      HFT_LOG(*log_queue_, "drop market evt seq=%lld", best->update_id);
+      return;
+    }
+    cpu_relax();
+  }
+}
+
+}  // namespace hft
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+
+#include "depth_parser.h"
+#include "depth_sync.h"
+#include "order_book.h"
+#include "types.h"
+
+namespace hft {
+
+// Binance depth frames -> synchronised full book -> top-of-book MarketEvents, with no
+// transport attached: BinanceDepthConnector feeds it from the network, ReplayFeed
+// from a capture.
+class DepthFeed {
+ public:
+  enum class OnFull : std::uint8_t {
+    Drop,  // live feed: a full queue loses the event
+    Wait,  // replay: spin until the strategy makes room, so every run sees the same input
+  };
+
+  DepthFeed(std::atomic<bool>& running,
+            SymbolId symbol,
+            std::shared_ptr<MarketQueue> outbound,
+            std::shared_ptr<LogQueue> log_queue,
+            OnFull on_full = OnFull::Drop);
+
+  void on_diff(std::string_view frame);
+  // False when the body is unusable or older than the buffered diffs.
+  bool on_snapshot(std::string_view body);
+  void reset() { sync_.reset(); }
+
+  bool needs_snapshot() const { return sync_.needs_snapshot(); }
+  // Top-of-book events published so far, dropped ones included; read once the
+  // feeding thread has stopped.
+  std::int64_t event_count() const { return events_; }
+
+ private:
+  void publish(std::uint64_t recv_tsc);
+
+  std::atomic<bool>& running_;
+  SymbolId symbol_;
+  std::shared_ptr<MarketQueue> outbound_;
+  std::shared_ptr<LogQueue> log_queue_;
+  OnFull on_full_;
+  OrderBook book_;
+  DepthSync sync_{book_};
+  DepthParser parser_;
+  std::int64_t events_{0};
+};
+
+}  // namespace hft
@@ -0,0 +1,305 @@
+#include "depth_parser.h"
+
+#include <bit>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace hft {
+
+namespace {
+
+constexpr double kPow10[] = {1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+                             1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+constexpr std::uint64_t kExactMantissa = std::uint64_t{1} << 53;
+
+// Position of the first '"' in [p, end), or end.
+const char* find_quote(const char* p, const char* end) {
+#if defined(__SSE2__)
+  const __m128i quote = _mm_set1_epi8('"');
+  while (end - p >= 16) {
+    const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    const auto mask = static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, quote)));
+    if (mask != 0) {
+      return p + std::countr_zero(mask);
+    }
+    p += 16;
+  }
+#endif
+  while (p < end && *p != '"') {
+    ++p;
+  }
+  return p;
+}
+
+bool eight_digits(const char* s) {
+  std::uint64_t v;
+  std::memcpy(&v, s, 8);
+  return ((v & 0xF0F0F0F0F0F0F0F0) | (((v + 0x0606060606060606) & 0xF0F0F0F0F0F0F0F0) >> 4)) == 0x3333333333333333;
+}
+
+// SWAR conversion of eight ASCII digits (little-endian load).
+std::uint32_t parse_eight(const char* s) {
+  std::uint64_t v;
+  std::memcpy(&v, s, 8);
+  v -= 0x3030303030303030;
+  v = (v * 10) + (v >> 8);
+  v = (((v & 0x000000FF000000FF) * (100 + (1000000ULL << 32))) +
+       (((v >> 16) & 0x000000FF000000FF) * (1 + (10000ULL << 32)))) >> 32;
+  return static_cast<std::uint32_t>(v);
+}
+
+// Appends the digits at p to m; returns how many were consumed.
+int accumulate(const char*& p, const char* end, std::uint64_t& m) {
+  const char* start = p;
+  if constexpr (std::endian::native == std::endian::little) {
+    while (end - p >= 8 && p - start <= 11 && eight_digits(p)) {
+      m = m * 100000000 + parse_eight(p);
+      p += 8;
+    }
+  }
+  while (p < end && static_cast<unsigned>(*p - '0') < 10 && p - start < 19) {
+    m = m * 10 + static_cast<unsigned>(*p - '0');
+    ++p;
+  }
+  return static_cast<int>(p - start);
+}
+
+class Cursor {
+ public:
+  explicit Cursor(std::string_view s) : p_(s.data()), end_(s.data() + s.size()) {}
+
+  void skip_ws() {
+    while (p_ < end_ && (*p_ == ' ' || *p_ == '\n' || *p_ == '\r' || *p_ == '\t')) {
+      ++p_;
+    }
+  }
+
+  bool consume(char c) {
+    skip_ws();
+    if (p_ < end_ && *p_ == c) {
+      ++p_;
+      return true;
+    }
+    return false;
+  }
+
+  char peek() {
+    skip_ws();
+    return p_ < end_ ? *p_ : '\0';
+  }
+
+  // Expects an opening quote; returns the raw contents. Binance keys and values carry
+  // no escapes, but a backslash-escaped quote is still stepped over correctly.
+  bool string(std::string_view& out) {
+    if (!consume('"')) {
+      return false;
+    }
+    const char* start = p_;
+    for (;;) {
+      const char* q = find_quote(p_, end_);
+      if (q == end_) {
+        return false;
+      }
+      std::size_t slashes = 0;
+      while (q - slashes > start && q[-1 - static_cast<std::ptrdiff_t>(slashes)] == '\\') {
+        ++slashes;
+      }
+      p_ = q + 1;
+      if (slashes % 2 == 0) {
+        out = std::string_view(start, static_cast<std::size_t>(q - start));
+        return true;
+      }
+    }
+  }
+
+  bool integer(std::int64_t& out) {
+    skip_ws();
+    const auto [ptr, ec] = std::from_chars(p_, end_, out);
+    if (ec != std::errc{}) {
+      return false;
+    }
+    p_ = ptr;
+    return true;
+  }
+
+  // A quoted decimal such as "60000.12000000".
+  bool decimal(double& out) {
+    if (!consume('"')) {
+      return false;
+    }
+    const char* start = p_;
+    std::uint64_t m = 0;
+    int int_digits = accumulate(p_, end_, m);
+    int frac_digits = 0;
+    if (p_ < end_ && *p_ == '.') {
+      ++p_;
+      frac_digits = accumulate(p_, end_, m);
+    }
+    if (p_ < end_ && *p_ == '"' && int_digits + frac_digits > 0 && int_digits + frac_digits <= 19 &&
+        m <= kExactMantissa && frac_digits <= 22) {
+      out = static_cast<double>(m) / kPow10[frac_digits];
+      ++p_;
+      return true;
+    }
+    // Long mantissas, exponents, signs: let the standard parser decide.
+    const char* q = find_quote(start, end_);
+    if (q == end_) {
+      return false;
+    }
+    const auto [ptr, ec] = std::from_chars(start, q, out);
+    if (ec != std::errc{} || ptr != q) {
+      return false;
+    }
+    p_ = q + 1;
+    return true;
+  }
+
+  // [["px","qty"],...] into out, at most max entries.
+  bool levels(std::vector<PriceLevel>& out, std::size_t max) {
+    out.clear();
+    if (!consume('[')) {
+      return false;
+    }
+    if (consume(']')) {
+      return true;
+    }
+    do {
+      if (out.size() == max) {
+        return false;
+      }
+      PriceLevel lvl;
+      if (!consume('[') || !decimal(lvl.price) || !consume(',') || !decimal(lvl.qty) || !consume(']')) {
+        return false;
+      }
+      out.push_back(lvl);
+    } while (consume(','));
+    return consume(']');
+  }
+
+  // Steps over any value: string, number, literal, or a nested object/array.
+  bool skip_value() {
+    const char c = peek();
+    if (c == '"') {
+      std::string_view ignored;
+      return string(ignored);
+    }
+    if (c == '{' || c == '[') {
+      int depth = 0;
+      while (p_ < end_) {
+        const char d = *p_;
+        if (d == '"') {
+          std::string_view ignored;
+          if (!string(ignored)) {
+            return false;
+          }
+          continue;
+        }
+        ++p_;
+        if (d == '{' || d == '[') {
+          ++depth;
+        } else if ((d == '}' || d == ']') && --depth == 0) {
+          return true;
+        }
+      }
+      return false;
+    }
+    const char* start = p_;
+    while (p_ < end_ && *p_ != ',' && *p_ != '}' && *p_ != ']' && *p_ != ' ' && *p_ != '\n') {
+      ++p_;
+    }
+    return p_ != start;
+  }
+
+  // Walks the top-level object, calling on_key(key) positioned at each value. on_key
+  // returns false on a malformed value.
+  template <typename OnKey>
+  bool object(OnKey&& on_key) {
+    if (!consume('{')) {
+      return false;
+    }
+    if (consume('}')) {
+      return true;
+    }
+    do {
+      std::string_view key;
+      if (!string(key) || !consume(':') || !on_key(key)) {
+        return false;
+      }
+    } while (consume(','));
+    return consume('}');
+  }
+
+ private:
+  const char* p_;
+  const char* end_;
+};
+
+}  // namespace
+
+DepthParser::DepthParser(std::size_t max_levels) : max_levels_(max_levels) {
+  bids_.reserve(max_levels_);
+  asks_.reserve(max_levels_);
+}
+
+bool DepthParser::parse_update(std::string_view json, DepthUpdate& out) {
+  enum : unsigned { kFirst = 1, kLast = 2, kBids = 4, kAsks = 8, kAll = 15 };
+  unsigned seen = 0;
+  out.prev_last_id = 0;
+  Cursor cur(json);
+  const bool ok = cur.object([&](std::string_view key) {
+    if (key == "U") {
+      seen |= kFirst;
+      return cur.integer(out.first_id);
+    }
+    if (key == "u") {
+      seen |= kLast;
+      return cur.integer(out.last_id);
+    }
+    if (key == "pu") {
+      return cur.integer(out.prev_last_id);
+    }
+    if (key == "b") {
+      seen |= kBids;
+      return cur.levels(bids_, max_levels_);
+    }
+    if (key == "a") {
+      seen |= kAsks;
+      return cur.levels(asks_, max_levels_);
+    }
+    return cur.skip_value();
+  });
+  out.bids = bids_;
+  out.asks = asks_;
+  return ok && seen == kAll;
+}
+
+bool DepthParser::parse_snapshot(std::string_view json, DepthSnapshot& out) {
+  enum : unsigned { kId = 1, kBids = 2, kAsks = 4, kAll = 7 };
+  unsigned seen = 0;
+  Cursor cur(json);
+  const bool ok = cur.object([&](std::string_view key) {
+    if (key == "lastUpdateId") {
+      seen |= kId;
+      return cur.integer(out.last_update_id);
+    }
+    if (key == "bids") {
+      seen |= kBids;
+      return cur.levels(bids_, max_levels_);
+    }
+    if (key == "asks") {
+      seen |= kAsks;
+      return cur.levels(asks_, max_levels_);
+    }
+    return cur.skip_value();
+  });
+  out.bids = bids_;
+  out.asks = asks_;
+  return ok && seen == kAll;
+}
+
+}  // namespace hft
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+#include <string_view>
+#include <vector>
+
+#include "depth_sync.h"
+#include "order_book.h"
+
+namespace hft {
+
+// Parser for the two Binance depth payloads, read in place from the frame bytes:
+//   diff:     {"e":"depthUpdate","E":..,"s":"..","U":..,"u":..,"pu":..,"b":[["px","qty"],..],"a":[..]}
+//   snapshot: {"lastUpdateId":..,"bids":[["px","qty"],..],"asks":[..]}
+// Other keys are skipped. String boundaries are found 16 bytes at a time (SSE2) and
+// prices/quantities are parsed as an integer mantissa over 10^k, eight digits per
+// step, which is exact (same double as strtod) up to 2^53; longer numbers fall back
+// to std::from_chars.
+//
+// Levels land in arrays reserved at construction, so parsing never allocates. The
+// spans in the result point into them and stay valid until the next parse call.
+// A payload with more than max_levels levels on one side is rejected.
+class DepthParser {
+ public:
+  explicit DepthParser(std::size_t max_levels = 5000);
+
+  bool parse_update(std::string_view json, DepthUpdate& out);
+  bool parse_snapshot(std::string_view json, DepthSnapshot& out);
+
+ private:
+  std::size_t max_levels_;
+  std::vector<PriceLevel> bids_;
+  std::vector<PriceLevel> asks_;
+};
+
+}  // namespace hft
@@ -0,0 +1,112 @@
+#include "depth_sync.h"
+
+namespace hft {
+
+DepthSync::DepthSync(OrderBook& book, std::size_t max_updates, std::size_t max_levels)
+    : book_(book), max_updates_(max_updates), max_levels_(max_levels) {
+  pending_.reserve(max_updates_);
+  pending_levels_.reserve(max_levels_);
+}
+
+DepthSync::Status DepthSync::on_update(const DepthUpdate& u) {
+  return live_ ? apply(u) : buffer(u);
+}
+
+bool DepthSync::on_snapshot(const DepthSnapshot& s) {
+  if (!pending_.empty() && s.last_update_id + 1 < pending_.front().first_id) {
+    return false;
+  }
+  book_.clear();
+  book_.apply_deltas(s.bids, s.asks, s.last_update_id);
+  live_ = true;
+  first_after_snapshot_ = true;
+  last_id_ = s.last_update_id;
+
+  for (std::size_t i = 0; i < pending_.size(); ++i) {
+    const auto u = pending_update(pending_[i]);
+    if (u.last_id <= last_id_) {
+      continue;
+    }
+    if (!continues(u)) {
+      // Keep the tail starting at u as the new buffer; level offsets stay valid.
+      restart();
+      pending_.erase(pending_.begin(), pending_.begin() + static_cast<std::ptrdiff_t>(i));
+      return true;
+    }
+    advance(u);
+  }
+  pending_.clear();
+  pending_levels_.clear();
+  return true;
+}
+
+void DepthSync::reset() {
+  book_.clear();
+  pending_.clear();
+  pending_levels_.clear();
+  live_ = false;
+  first_after_snapshot_ = false;
+  last_id_ = 0;
+}
+
+DepthSync::Status DepthSync::apply(const DepthUpdate& u) {
+  if (u.last_id <= last_id_) {
+    return Status::Stale;
+  }
+  if (!continues(u)) {
+    restart();
+    pending_.clear();
+    pending_levels_.clear();
+    buffer(u);
+    return Status::Gap;
+  }
+  advance(u);
+  return Status::Applied;
+}
+
+bool DepthSync::continues(const DepthUpdate& u) const {
+  if (first_after_snapshot_) {
+    return u.first_id <= last_id_ + 1;
+  }
+  if (u.prev_last_id != 0) {
+    return u.prev_last_id == last_id_;
+  }
+  return u.first_id == last_id_ + 1;
+}
+
+void DepthSync::advance(const DepthUpdate& u) {
+  book_.apply_deltas(u.bids, u.asks, u.last_id);
+  last_id_ = u.last_id;
+  first_after_snapshot_ = false;
+}
+
+void DepthSync::restart() {
+  ++gaps_;
+  book_.clear();
+  live_ = false;
+  first_after_snapshot_ = false;
+  last_id_ = 0;
+}
+
+DepthSync::Status DepthSync::buffer(const DepthUpdate& u) {
+  if (pending_.size() == max_updates_ || pending_levels_.size() + u.bids.size() + u.asks.size() > max_levels_) {
+    pending_.clear();
+    pending_levels_.clear();
+    return Status::Overflow;
+  }
+  const auto bids_begin = static_cast<std::uint32_t>(pending_levels_.size());
+  pending_levels_.insert(pending_levels_.end(), u.bids.begin(), u.bids.end());
+  const auto asks_begin = static_cast<std::uint32_t>(pending_levels_.size());
+  pending_levels_.insert(pending_levels_.end(), u.asks.begin(), u.asks.end());
+  pending_.push_back({u.first_id, u.last_id, u.prev_last_id, bids_begin, static_cast<std::uint32_t>(u.bids.size()),
+                      asks_begin, static_cast<std::uint32_t>(u.asks.size())});
+  return Status::Buffered;
+}
+
+DepthUpdate DepthSync::pending_update(const Pending& p) const {
+  const std::span<const PriceLevel> levels(pending_levels_);
+  return {p.first_id, p.last_id, p.prev_last_id, levels.subspan(p.bids_begin, p.bids_count),
+          levels.subspan(p.asks_begin, p.asks_count)};
+}
+
+}  // namespace hft
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "order_book.h"
+
+namespace hft {
+
+// One diff-stream event. prev_last_id is the futures stream's `pu`; leave it 0 for
+// spot, where continuity is U == previous u + 1 instead.
+struct DepthUpdate {
+  std::int64_t first_id{};      // U
+  std::int64_t last_id{};       // u
+  std::int64_t prev_last_id{};  // pu
+  std::span<const PriceLevel> bids;
+  std::span<const PriceLevel> asks;
+};
+
+struct DepthSnapshot {
+  std::int64_t last_update_id{};
+  std::span<const PriceLevel> bids;
+  std::span<const PriceLevel> asks;
+};
+
+// Keeps an OrderBook in step with Binance's REST snapshot + diff stream:
+//   1. diffs are buffered until a snapshot arrives (fetch one once needs_snapshot());
+//   2. a snapshot older than the first buffered diff is refused, fetch another;
+//   3. buffered diffs the snapshot already covers are dropped, the rest replayed;
+//   4. the first live diff must straddle the snapshot (U <= id + 1 <= u) and every
+//      later one must continue the previous (pu == u, or U == u + 1 without pu).
+// A break clears the book and starts again from 1 with the diff that exposed it.
+//
+// The buffer is preallocated; diffs past either bound discard it and restart at 1.
+class DepthSync {
+ public:
+  enum class Status : std::uint8_t {
+    Buffered,  // waiting for a snapshot
+    Applied,   // book updated
+    Stale,     // already covered by the book, ignored
+    Gap,       // sequence break; book cleared and buffering again
+    Overflow,  // buffer full while waiting; buffer discarded
+  };
+
+  explicit DepthSync(OrderBook& book, std::size_t max_updates = 1024, std::size_t max_levels = std::size_t{1} << 16);
+
+  Status on_update(const DepthUpdate& u);
+  // False when the snapshot predates the buffered diffs; nothing changes then.
+  bool on_snapshot(const DepthSnapshot& s);
+  void reset();
+
+  bool live() const { return live_; }
+  bool needs_snapshot() const { return !live_ && !pending_.empty(); }
+  std::int64_t last_update_id() const { return last_id_; }
+  std::uint64_t gaps() const { return gaps_; }
+
+ private:
+  struct Pending {
+    std::int64_t first_id;
+    std::int64_t last_id;
+    std::int64_t prev_last_id;
+    std::uint32_t bids_begin;
+    std::uint32_t bids_count;
+    std::uint32_t asks_begin;
+    std::uint32_t asks_count;
+  };
+
+  Status apply(const DepthUpdate& u);
+  bool continues(const DepthUpdate& u) const;
+  void advance(const DepthUpdate& u);
+  void restart();  // after a gap: clear the book, keep the buffer
+  Status buffer(const DepthUpdate& u);
+  DepthUpdate pending_update(const Pending& p) const;
+
+  OrderBook& book_;
+  std::size_t max_updates_;
+  std::size_t max_levels_;
+  std::vector<Pending> pending_;
+  std::vector<PriceLevel> pending_levels_;
+  bool live_{false};
+  bool first_after_snapshot_{false};
+  std::int64_t last_id_{0};
+  std::uint64_t gaps_{0};
+};
+
+}  // namespace hft
@@ -4,42 +4,47 @@
 #include <random>
 #include <thread>
 
+#include "binlog.h"
+#include "tsc.h"
+
 namespace hft {
 
 FeedHandler::FeedHandler(std::atomic<bool>& running,
-                         std::vector<std::string> symbols,
+                         const SymbolRegistry& symbols,
+                         const ShardMap& shards,
                          std::vector<std::shared_ptr<MarketQueue>> shard_queues,
                          std::shared_ptr<LogQueue> log_queue)
     : running_(running),
-      symbols_(std::move(symbols)),
+      symbols_(symbols),
       shard_queues_(std::move(shard_queues)),
-      log_queue_(std::move(log_queue)) {}
+      route_(symbols.size()),
+      seqs_(symbols.size(), 0),
+      log_queue_(std::move(log_queue)) {
+  for (std::size_t i = 0; i < route_.size(); ++i) {
+    route_[i] = shard_queues_[shards.shard(static_cast<SymbolId>(i))].get();
+  }
+}
 
 void FeedHandler::run() {
-  std::unordered_map<std::string, std::int64_t> seqs;
   std::mt19937_64 rng{std::random_device{}()};
   std::normal_distribution<double> price_noise{0.0, 0.5};
   while (running_.load(std::memory_order_acquire)) {
-    for (const auto& sym : symbols_) {
-      const auto shard = shard_for_symbol(sym);
-      auto& q = shard_queues_[shard];
-      auto& seq = seqs[sym];
+    for (std::size_t i = 0; i < symbols_.size(); ++i) {
+      const auto sym = static_cast<SymbolId>(i);
+      auto* q = route_[i];
+      auto& seq = seqs_[i];
       ++seq;
-      MarketEvent evt{sym, 100.0 + price_noise(rng), 100.4 + price_noise(rng), 0.5, seq};
+      MarketEvent evt{sym, 100.0 + price_noise(rng), 100.4 + price_noise(rng), 0.5, seq, tsc_now()};
+      if (capture_ != nullptr) {
+        const CapturedMarketEvent rec{{}, evt.bid, evt.ask, evt.size, evt.seq};
+        capture_->write(CaptureKind::MarketEvent, sym, capture_now_ns(), &rec, sizeof(rec));
+      }
       if (!q->push(evt)) {
-        log("drop market evt for " + sym);
+        HFT_LOG(*log_queue_, "drop market evt for %s", symbols_.name(sym));
       }
     }
     std::this_thread::sleep_for(std::chrono::milliseconds(1));
   }
 }
 
-std::size_t FeedHandler::shard_for_symbol(const std::string& sym) const {
-  return std::hash<std::string>{}(sym) % shard_queues_.size();
-}
-
-void FeedHandler::log(const std::string& msg) {
-  log_queue_->push(LogEvent{"feed", msg, std::chrono::steady_clock::now()});
-}
-
 }  // namespace hft
@@ -2,31 +2,39 @@
 
 #include <atomic>
 #include <memory>
-#include <string>
-#include <unordered_map>
 #include <vector>
 
+#include "capture.h"
+#include "shard_map.h"
 #include "types.h"
 
 namespace hft {
 
+// Routes each symbol's events to its strategy shard. The symbol -> queue table is built
+// once from the resolved ShardMap; shard_queues must have shards.shard_count() entries.
 class FeedHandler {
  public:
   FeedHandler(std::atomic<bool>& running,
-              std::vector<std::string> symbols,
+              const SymbolRegistry& symbols,
+              const ShardMap& shards,
               std::vector<std::shared_ptr<MarketQueue>> shard_queues,
               std::shared_ptr<LogQueue> log_queue);
 
+  // Set before run(); the writer must outlive the feed thread.
+  void set_capture(CaptureWriter* capture) { capture_ = capture; }
   void run();
 
- private:
-  std::size_t shard_for_symbol(const std::string& sym) const;
-  void log(const std::string& msg);
+  // Events published for a symbol; read after the feed thread has been joined.
+  std::int64_t event_count(SymbolId sym) const { return seqs_[sym]; }
 
+ private:
   std::atomic<bool>& running_;
-  std::vector<std::string> symbols_;
+  const SymbolRegistry& symbols_;
   std::vector<std::shared_ptr<MarketQueue>> shard_queues_;
+  std::vector<MarketQueue*> route_;  // indexed by SymbolId
+  std::vector<std::int64_t> seqs_;
   std::shared_ptr<LogQueue> log_queue_;
+  CaptureWriter* capture_{nullptr};
 };
 
 }  // namespace hft
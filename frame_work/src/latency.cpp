@@ -0,0 +1,94 @@
+#include "latency.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <thread>
+
+#include "binlog.h"
+
+namespace hft {
+
+LatencyHistogram::LatencyHistogram() : counts_(new std::atomic<std::uint64_t>[kBuckets]) {
+  reset();
+}
+
+std::uint64_t LatencyHistogram::bucket_upper(std::size_t b) {
+  constexpr std::size_t kLinear = std::size_t{1} << kSubBits;
+  constexpr std::size_t kHalf = kLinear / 2;
+  if (b < kLinear) {
+    return b;
+  }
+  const std::size_t k = b - kLinear;
+  const unsigned shift = static_cast<unsigned>(k / kHalf) + 1;
+  const std::uint64_t mantissa = kHalf + k % kHalf;
+  return ((mantissa + 1) << shift) - 1;
+}
+
+std::uint64_t LatencyHistogram::percentile(double q) const {
+  const std::uint64_t total = count();
+  if (total == 0) {
+    return 0;
+  }
+  const auto rank = std::max<std::uint64_t>(1, static_cast<std::uint64_t>(std::ceil(q * static_cast<double>(total))));
+  std::uint64_t seen = 0;
+  for (std::size_t b = 0; b < kBuckets; ++b) {
+    seen += counts_[b].load(std::memory_order_relaxed);
+    if (seen >= rank) {
+      return std::min(bucket_upper(b), max());
+    }
+  }
+  return max();
+}
+
+void LatencyHistogram::reset() {
+  for (std::size_t b = 0; b < kBuckets; ++b) {
+    counts_[b].store(0, std::memory_order_relaxed);
+  }
+  total_.store(0, std::memory_order_relaxed);
+  max_.store(0, std::memory_order_relaxed);
+}
+
+const char* hop_name(Hop hop) {
+  switch (hop) {
+    case Hop::FeedToStrategy: return "feed->strategy";
+    case Hop::Strategy: return "strategy";
+    case Hop::StrategyToOms: return "strategy->oms";
+    case Hop::Oms: return "oms";
+    case Hop::OmsToTrade: return "oms->trade";
+    case Hop::TickToTrade: return "tick-to-trade";
+    case Hop::Count: break;
+  }
+  return "?";
+}
+
+void TickToTrade::reset() {
+  for (auto& h : hops_) {
+    h.reset();
+  }
+}
+
+void TickToTrade::dump(LogQueue& log, double ticks_per_ns) const {
+  const auto ns = [ticks_per_ns](std::uint64_t ticks) {
+    return static_cast<std::int64_t>(static_cast<double>(ticks) / ticks_per_ns);
+  };
+  for (std::size_t i = 0; i < kHops; ++i) {
+    const auto& h = hops_[i];
+    if (h.count() == 0) {
+      continue;
+    }
+    HFT_LOG(log, "latency %s n=%llu p50=%lld p99=%lld p99.9=%lld max=%lld ns", hop_name(static_cast<Hop>(i)),
+            h.count(), ns(h.percentile(0.50)), ns(h.percentile(0.99)), ns(h.percentile(0.999)), ns(h.max()));
+  }
+}
+
+void TickToTradeSwap::dump_and_reset(LogQueue& log, double ticks_per_ns) {
+  const unsigned retired = active_.load(std::memory_order_relaxed);
+  active_.store(retired ^ 1u, std::memory_order_release);
+  // Lets a record() that loaded the old index just before the store finish with it.
+  std::this_thread::sleep_for(std::chrono::microseconds(100));
+  banks_[retired].dump(log, ticks_per_ns);
+  banks_[retired].reset();
+}
+
+}  // namespace hft
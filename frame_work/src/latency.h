@@ -0,0 +1,128 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "tsc.h"
+#include "types.h"
+
+namespace hft {
+
+// Log-linear (HDR-style) histogram of tick counts. Values below 128 get a bucket each;
+// above that every power of two is split into 64 buckets, so a reported percentile is
+// within 1/64 (~1.6%) of the true value. Values beyond 2^40 ticks land in the top bucket.
+//
+// One thread records; counts are relaxed atomics written with load+store rather than a
+// locked add, so recording is a few plain instructions and any other thread may read
+// percentiles at any time without a lock (seeing a slightly torn but usable snapshot).
+class LatencyHistogram {
+ public:
+  static constexpr unsigned kSubBits = 7;
+  static constexpr unsigned kMaxBits = 40;
+  static constexpr std::size_t kBuckets = (1u << kSubBits) + (kMaxBits - kSubBits) * (1u << (kSubBits - 1));
+
+  LatencyHistogram();
+
+  void record(std::uint64_t ticks) {
+    bump(counts_[bucket(ticks)]);
+    bump(total_);
+    if (ticks > max_.load(std::memory_order_relaxed)) {
+      max_.store(ticks, std::memory_order_relaxed);
+    }
+  }
+
+  std::uint64_t count() const { return total_.load(std::memory_order_relaxed); }
+  std::uint64_t max() const { return max_.load(std::memory_order_relaxed); }
+  // Upper edge of the bucket holding quantile q in [0, 1]; 0 when empty.
+  std::uint64_t percentile(double q) const;
+  // Writer only, or the reader once the writer has moved to another histogram.
+  void reset();
+
+  static std::size_t bucket(std::uint64_t v) {
+    if (v < (1u << kSubBits)) {
+      return static_cast<std::size_t>(v);
+    }
+    if (v >= (std::uint64_t{1} << kMaxBits)) {
+      return kBuckets - 1;
+    }
+    const unsigned shift = static_cast<unsigned>(std::bit_width(v)) - kSubBits;  // >= 1
+    const std::size_t mantissa = static_cast<std::size_t>(v >> shift);           // [64, 128)
+    return (1u << kSubBits) + (shift - 1) * (1u << (kSubBits - 1)) + (mantissa - (1u << (kSubBits - 1)));
+  }
+  static std::uint64_t bucket_upper(std::size_t b);
+
+ private:
+  static void bump(std::atomic<std::uint64_t>& c) {
+    c.store(c.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+  }
+
+  std::unique_ptr<std::atomic<std::uint64_t>[]> counts_;
+  std::atomic<std::uint64_t> total_{0};
+  std::atomic<std::uint64_t> max_{0};
+};
+
+// Stage boundaries an OrderCommand's TraceStamps cover, ending at TradeIo's send.
+enum class Hop : std::uint8_t {
+  FeedToStrategy,  // MarketQueue wait
+  Strategy,        // decision logic
+  StrategyToOms,   // DecisionQueue wait
+  Oms,             // risk checks
+  OmsToTrade,      // OrderQueue wait
+  TickToTrade,     // feed receive -> send
+  Count,
+};
+
+const char* hop_name(Hop hop);
+
+// Per-hop histograms fed from the stamps on each order as TradeIo sends it.
+class TickToTrade {
+ public:
+  static constexpr std::size_t kHops = static_cast<std::size_t>(Hop::Count);
+
+  void record(const TraceStamps& t, std::uint64_t send_tsc) {
+    const std::uint32_t send = tsc_since(t.feed_recv, send_tsc);
+    hops_[0].record(t.strat_in);
+    hops_[1].record(span(t.strat_in, t.strat_out));
+    hops_[2].record(span(t.strat_out, t.oms_in));
+    hops_[3].record(span(t.oms_in, t.oms_out));
+    hops_[4].record(span(t.oms_out, send));
+    hops_[5].record(send);
+  }
+
+  const LatencyHistogram& hop(Hop h) const { return hops_[static_cast<std::size_t>(h)]; }
+  void reset();
+
+  // One line per hop with count and p50/p99/p99.9/max in ns.
+  void dump(LogQueue& log, double ticks_per_ns) const;
+
+ private:
+  // Cross-core counters can disagree by a few ticks; clamp rather than wrap.
+  static std::uint32_t span(std::uint32_t from, std::uint32_t to) { return to > from ? to - from : 0; }
+
+  std::array<LatencyHistogram, kHops> hops_;
+};
+
+// Two TickToTrade banks for one writer and one reader. The writer records into the
+// active bank; the reader swaps banks, then logs and clears the one it took out of
+// service, so percentile scans and resets never run on the writer's thread. A record
+// that raced the swap may land in the old bank during the grace period; counts stay
+// approximate in the way LatencyHistogram's already are.
+class TickToTradeSwap {
+ public:
+  void record(const TraceStamps& t, std::uint64_t send_tsc) {
+    banks_[active_.load(std::memory_order_acquire)].record(t, send_tsc);
+  }
+
+  // Reader only: logs the interval since the last call and starts a new one.
+  void dump_and_reset(LogQueue& log, double ticks_per_ns);
+
+ private:
+  std::array<TickToTrade, 2> banks_;
+  std::atomic<unsigned> active_{0};
+};
+
+}  // namespace hft
@@ -1,34 +1,212 @@
 #include "logging.h"
 
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cerrno>
 #include <chrono>
+#include <cstdio>
+#include <cstring>
 #include <iostream>
-#include <thread>
+
+#include "binlog.h"
+#include "topology.h"
 
 namespace hft {
 
-Logger::Logger(std::atomic<bool>& running) : running_(running), start_(std::chrono::steady_clock::now()) {}
+namespace {
+
+std::int64_t steady_ns() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+}  // namespace
+
+Logger::Logger(std::atomic<bool>& running, WaitConfig wait, int numa_node)
+    : running_(running),
+      start_ns_(steady_ns()),
+      wait_(wait),
+      numa_node_(numa_node),
+      chunks_(kChunks, std::vector<char>(kChunkSize)),
+      format_sent_(kMaxLogFormats, false) {
+  for (std::size_t i = 0; i < kChunks; ++i) {
+    iov_[i].iov_base = chunks_[i].data();
+  }
+}
+
+Logger::~Logger() {
+  flush();
+  if (fd_ > 2) {
+    ::close(fd_);
+  }
+}
+
+bool Logger::open(const std::string& path, bool binary) {
+  if (path != "-") {
+    const int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+      perror(path.c_str());
+      return false;
+    }
+    fd_ = fd;
+  }
+  binary_ = binary;
+  if (binary_) {
+    append(kLogFileMagic, sizeof(kLogFileMagic));
+    append(&start_ns_, sizeof(start_ns_));
+  }
+  return true;
+}
 
 std::shared_ptr<LogQueue> Logger::register_source(const std::string& name) {
-  sources_.push_back({name, std::make_shared<LogQueue>()});
+  sources_.push_back({name, make_on_node<LogQueue>(numa_node_)});
+  sources_.back().queue->set_doorbell(wait_.doorbell());
   return sources_.back().queue;
 }
 
 void Logger::run() {
+  if (binary_) {
+    for (std::size_t i = 0; i < sources_.size(); ++i) {
+      write_source(static_cast<std::uint16_t>(i));
+    }
+  }
   while (running_.load(std::memory_order_acquire)) {
-    drain_once();
-    std::this_thread::sleep_for(std::chrono::microseconds(50));
+    if (drain_once()) {
+      wait_.reset();
+    } else {
+      wait_.idle([this] { return has_input(); });
+    }
   }
   drain_once(); // why extra?
 }
 
-void Logger::drain_once() {
-  for (auto& src : sources_) {
-    LogEvent evt;
-    while (src.queue->pop(evt)) {
-      const auto rel = std::chrono::duration_cast<std::chrono::milliseconds>(evt.ts - start_).count();
-      std::cout << "[" << src.name << "] +" << rel << "ms " << evt.message << '\n';
+bool Logger::drain_once() {
+  bool progressed = false;
+  for (std::size_t i = 0; i < sources_.size(); ++i) {
+    const auto source = static_cast<std::uint16_t>(i);
+    while (sources_[i].queue->consume([&](const LogEvent& evt) { write_event(source, evt); })) {
+      progressed = true;
+    }
+  }
+  flush();
+  return progressed;
+}
+
+bool Logger::has_input() const {
+  for (const auto& src : sources_) {
+    if (!src.queue->empty()) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void Logger::write_event(std::uint16_t source, const LogEvent& evt) {
+  if (binary_) {
+    if (!format_sent_[evt.fmt]) {
+      write_format(evt.fmt);
+    }
+    char* p = reserve(1 + 2 + 8 + 2 + 2 + evt.len);
+    *p++ = static_cast<char>(kLogRecEvent);
+    std::memcpy(p, &source, 2);
+    std::memcpy(p + 2, &evt.ts_ns, 8);
+    std::memcpy(p + 10, &evt.fmt, 2);
+    std::memcpy(p + 12, &evt.len, 2);
+    std::memcpy(p + 14, evt.payload, evt.len);
+    return;
+  }
+
+  const LogFormat* f = find_log_format(evt.fmt);
+  const auto& name = sources_[source].name;
+  char* line = reserve(kMaxRecord);
+  const long long rel_ms = (evt.ts_ns - start_ns_) / 1'000'000;
+  int n = std::snprintf(line, kMaxRecord, "[%s] +%lldms ", name.c_str(), rel_ms);
+  n = std::min(n, static_cast<int>(kMaxRecord) - 2);
+  if (f != nullptr) {
+    n += static_cast<int>(render_log_text(f->fmt, {f->types, f->nargs}, evt.payload, evt.len, line + n,
+                                          kMaxRecord - 1 - static_cast<std::size_t>(n)));
+  }
+  line[n++] = '\n';
+  iov_[chunk_].iov_len -= kMaxRecord - static_cast<std::size_t>(n);  // give back the unused tail
+}
+
+void Logger::write_source(std::uint16_t source) {
+  const auto& name = sources_[source].name;
+  const auto len = static_cast<std::uint16_t>(name.size());
+  char* p = reserve(1 + 2 + 2 + len);
+  *p++ = static_cast<char>(kLogRecSource);
+  std::memcpy(p, &source, 2);
+  std::memcpy(p + 2, &len, 2);
+  std::memcpy(p + 4, name.data(), len);
+}
+
+void Logger::write_format(std::uint16_t id) {
+  const LogFormat* f = find_log_format(id);
+  if (f == nullptr) {
+    return;
+  }
+  const auto len = static_cast<std::uint16_t>(std::strlen(f->fmt));
+  char* p = reserve(1 + 2 + 1 + f->nargs + 2 + len);
+  *p++ = static_cast<char>(kLogRecFormat);
+  std::memcpy(p, &id, 2);
+  p[2] = static_cast<char>(f->nargs);
+  std::memcpy(p + 3, f->types, f->nargs);
+  std::memcpy(p + 3 + f->nargs, &len, 2);
+  std::memcpy(p + 5 + f->nargs, f->fmt, len);
+  format_sent_[id] = true;
+}
+
+// Returns n contiguous bytes in the staging chunks, moving to the next chunk (or
+// flushing when all are full) if the current one cannot hold them.
+char* Logger::reserve(std::size_t n) {
+  if (iov_[chunk_].iov_len + n > kChunkSize) {
+    if (chunk_ + 1 == kChunks) {
+      flush();
+    } else {
+      ++chunk_;
+    }
+  }
+  char* p = chunks_[chunk_].data() + iov_[chunk_].iov_len;
+  iov_[chunk_].iov_len += n;
+  return p;
+}
+
+void Logger::append(const void* p, std::size_t n) {
+  std::memcpy(reserve(n), p, n);
+}
+
+void Logger::flush() {
+  if (chunk_ == 0 && iov_[0].iov_len == 0) {
+    return;  // nothing staged; skip the empty writev
+  }
+  std::size_t count = chunk_ + 1;
+  iovec* iov = iov_;
+  while (count > 0) {
+    const ssize_t written = ::writev(fd_, iov, static_cast<int>(count));
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      perror("logger writev");
+      break;
     }
+    auto left = static_cast<std::size_t>(written);
+    while (count > 0 && left >= iov->iov_len) {
+      left -= iov->iov_len;
+      ++iov;
+      --count;
+    }
+    if (count > 0) {
+      iov->iov_base = static_cast<char*>(iov->iov_base) + left;
+      iov->iov_len -= left;
+    }
+  }
+  for (std::size_t i = 0; i < kChunks; ++i) {
+    iov_[i].iov_base = chunks_[i].data();
+    iov_[i].iov_len = 0;
   }
+  chunk_ = 0;
 }
 
 }  // namespace hft
@@ -1,18 +1,33 @@
 #pragma once
 
+#include <sys/uio.h>
+
 #include <atomic>
+#include <cstddef>
+#include <cstdint>
 #include <memory>
 #include <string>
 #include <vector>
 
 #include "types.h"
+#include "wait_strategy.h"
 
 namespace hft {
 
+// Drains the per-source binary log rings (see binlog.h). Text mode renders each record
+// as "[source] +Nms text"; binary mode writes records verbatim for tools/log_decode.
+// Output is staged in fixed chunks and flushed with one writev per drain pass.
 class Logger {
  public:
-  explicit Logger(std::atomic<bool>& running);
+  // Source queues are allocated on `numa_node` (the logger thread's node, -1 = local).
+  explicit Logger(std::atomic<bool>& running, WaitConfig wait = {WaitKind::SpinPark, 64, 1000}, int numa_node = -1);
+  ~Logger();
+
+  Logger(const Logger&) = delete;
+  Logger& operator=(const Logger&) = delete;
 
+  // Output file, "-" for stdout (the default). Call before run().
+  bool open(const std::string& path, bool binary);
   std::shared_ptr<LogQueue> register_source(const std::string& name);
   void run();
 
@@ -22,11 +37,30 @@ class Logger {
     std::shared_ptr<LogQueue> queue;
   };
 
-  void drain_once();
+  static constexpr std::size_t kChunkSize = 64 * 1024;
+  static constexpr std::size_t kChunks = 8;
+  static constexpr std::size_t kMaxRecord = 1024;  // worst-case rendered/encoded event
+
+  bool drain_once();
+  bool has_input() const;
+  void write_event(std::uint16_t source, const LogEvent& evt);
+  void write_source(std::uint16_t source);
+  void write_format(std::uint16_t id);
+  char* reserve(std::size_t n);
+  void append(const void* p, std::size_t n);
+  void flush();
 
   std::atomic<bool>& running_;
-  std::chrono::steady_clock::time_point start_;
+  std::int64_t start_ns_;
   std::vector<SourceQueue> sources_;
+  WaitStrategy wait_;
+  int numa_node_;
+  int fd_ = 1;
+  bool binary_ = false;
+  std::vector<std::vector<char>> chunks_;
+  iovec iov_[kChunks]{};
+  std::size_t chunk_ = 0;  // chunk being filled; iov_[i].iov_len is its fill level
+  std::vector<bool> format_sent_;
 };
 
 }  // namespace hft
@@ -1,86 +1,283 @@
+#include <algorithm>
 #include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cstdlib>
 #include <iostream>
 #include <memory>
 #include <string>
 #include <thread>
+#include <utility>
 #include <vector>
 
 #include "binance_depth.h"
+#include "capture.h"
 #include "feed_handler.h"
 #include "logging.h"
 #include "oms_risk.h"
+#include "replay_feed.h"
+#include "risk.h"
+#include "shard_map.h"
 #include "strategy_shard.h"
+#include "topology.h"
 #include "trade_io.h"
 #include "types.h"
+#include "wait_strategy.h"
 
 int main(int argc, char* argv[]) {
   using namespace std::chrono_literals;
   std::atomic<bool> running{true};
 
-  hft::Logger logger(running);
+  bool use_binance = false;
+  std::string binance_symbol = "BTCUSDT";
+  std::string binance_stand_in;  // HOST:PORT of a plain-text stand-in, e.g. tools/depth_standin
+  hft::WaitConfig hot_wait;  // strategy, OMS and trade threads; the logger always parks
+  hft::Topology topo;        // components: feed, strat0..stratN-1, oms, trade, log
+  std::size_t shard_count = 2;
+  std::string shard_map_path;
+  std::string rates_out;
+  std::string risk_path;
+  std::string log_path = "-";
+  bool log_binary = false;
+  std::string capture_path;
+  std::string replay_path;
+  hft::ReplayPace replay_pace = hft::ReplayPace::Max;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    bool ok = true;
+    if (arg == "--binance" && i + 1 < argc) {
+      use_binance = true;
+      binance_symbol = argv[++i];
+    } else if (arg == "--binance-endpoint" && i + 1 < argc) {
+      binance_stand_in = argv[++i];
+    } else if (arg == "--wait" && i + 1 < argc) {
+      if (!hft::parse_wait_kind(argv[++i], hot_wait.kind)) {
+        std::cerr << "unknown wait strategy " << argv[i] << " (spin|yield|park)\n";
+        return 1;
+      }
+    } else if (arg == "--topology" && i + 1 < argc) {
+      ok = topo.load_file(argv[++i]);
+    } else if (arg == "--pin" && i + 1 < argc) {
+      ok = topo.parse_pin_list(argv[++i]);
+    } else if (arg == "--fifo" && i + 1 < argc) {
+      ok = topo.parse_fifo_list(argv[++i]);
+    } else if (arg == "--mlockall") {
+      topo.set_lock_memory(true);
+    } else if (arg == "--log-file" && i + 1 < argc) {
+      log_path = argv[++i];
+    } else if (arg == "--log-binary") {
+      log_binary = true;
+    } else if (arg == "--shards" && i + 1 < argc) {
+      shard_count = std::strtoul(argv[++i], nullptr, 10);
+      ok = shard_count > 0 && shard_count <= 256;
+      if (!ok) {
+        std::cerr << "--shards must be in 1..256\n";
+      }
+    } else if (arg == "--shard-map" && i + 1 < argc) {
+      shard_map_path = argv[++i];
+    } else if (arg == "--rates-out" && i + 1 < argc) {
+      rates_out = argv[++i];
+    } else if (arg == "--risk-limits" && i + 1 < argc) {
+      risk_path = argv[++i];
+    } else if (arg == "--capture" && i + 1 < argc) {
+      capture_path = argv[++i];
+    } else if (arg == "--replay" && i + 1 < argc) {
+      replay_path = argv[++i];
+    } else if (arg == "--replay-pace" && i + 1 < argc) {
+      if (!hft::parse_replay_pace(argv[++i], replay_pace)) {
+        std::cerr << "unknown replay pace " << argv[i] << " (max|recorded)\n";
+        return 1;
+      }
+    }
+    if (!ok) {
+      return 1;
+    }
+  }
+
+  // Symbol IDs and their shards are fixed here, before any pipeline thread starts.
+  std::transform(binance_symbol.begin(), binance_symbol.end(), binance_symbol.begin(), ::toupper);
+  hft::SymbolRegistry symbols;
+  for (const char* sym : {"BTCUSDT", "ETHUSDT", "XRPUSDT", "SOLUSDT"}) {
+    symbols.intern(sym);
+  }
+  [[maybe_unused]] const hft::SymbolId binance_id = symbols.intern(binance_symbol);
+  hft::CaptureReader replay_capture;
+  if (!replay_path.empty()) {
+    if (!replay_capture.open(replay_path)) {
+      return 1;
+    }
+    replay_capture.intern_symbols(symbols);
+  }
+  hft::ShardMap shard_map(shard_count);
+  if (!shard_map_path.empty() && !shard_map.load_file(shard_map_path, symbols)) {
+    return 1;
+  }
+  shard_map.resolve(symbols);
+  hft::RiskEngine risk(symbols.size());
+  if (!risk_path.empty() && !risk.load_file(risk_path, symbols)) {
+    return 1;
+  }
+  // Replay feeds from a capture, so recording it again would only copy the file.
+  std::unique_ptr<hft::CaptureWriter> capture;
+  if (!capture_path.empty() && replay_path.empty()) {
+    capture = std::make_unique<hft::CaptureWriter>();
+    if (!capture->open(capture_path)) {
+      return 1;
+    }
+    capture->write_symbols(symbols);
+  }
+#ifdef ENABLE_BINANCE
+  hft::BinanceEndpoint binance_endpoint;
+  if (!binance_stand_in.empty() && !binance_endpoint.parse_plain(binance_stand_in)) {
+    std::cerr << "--binance-endpoint expects HOST:PORT\n";
+    return 1;
+  }
+#endif
+
+  hft::Logger logger(running, {hft::WaitKind::SpinPark, 64, 1000}, topo.numa_node("log"));
+  if (!logger.open(log_path, log_binary)) {
+    return 1;
+  }
   auto log_feed = logger.register_source("feed");
   auto log_binance = logger.register_source("binance");
-  auto log_strat0 = logger.register_source("strat0");
-  auto log_strat1 = logger.register_source("strat1");
+  std::vector<std::string> shard_names;
+  std::vector<std::shared_ptr<hft::LogQueue>> log_strats;
+  for (std::size_t i = 0; i < shard_count; ++i) {
+    shard_names.push_back("strat" + std::to_string(i));
+    log_strats.push_back(logger.register_source(shard_names.back()));
+  }
   auto log_oms = logger.register_source("oms");
   auto log_trade = logger.register_source("trade");
+  auto log_latency = logger.register_source("latency");
 
-  std::thread log_thread([&]() { logger.run(); });
+  std::thread log_thread([&]() {
+    hft::apply_placement("log", topo.placement("log"));
+    logger.run();
+  });
 
-  auto feed_to_strat0 = std::make_shared<hft::MarketQueue>();
-  auto feed_to_strat1 = std::make_shared<hft::MarketQueue>();
-  auto strat0_to_oms = std::make_shared<hft::StrategyQueue>();
-  auto strat1_to_oms = std::make_shared<hft::StrategyQueue>();
-  auto oms_to_trade = std::make_shared<hft::OrderQueue>();
+  // Each queue lives on its consumer's NUMA node, pre-faulted before trading starts.
+  std::vector<std::shared_ptr<hft::MarketQueue>> shard_market_queues;
+  for (const auto& name : shard_names) {
+    shard_market_queues.push_back(hft::make_on_node<hft::MarketQueue>(topo.numa_node(name)));
+  }
+  auto strats_to_oms = hft::make_on_node<hft::DecisionQueue>(topo.numa_node("oms"));
+  auto oms_to_trade = hft::make_on_node<hft::OrderQueue>(topo.numa_node("trade"));
+  auto trade_to_oms = hft::make_on_node<hft::DoneQueue>(topo.numa_node("oms"));
+  auto ref_prices = std::make_shared<hft::ReferencePrices>(symbols.size());
 
-  std::vector<std::string> symbols = {"BTCUSDT", "ETHUSDT", "XRPUSDT", "SOLUSDT"};
-  std::vector<std::shared_ptr<hft::MarketQueue>> shard_market_queues{feed_to_strat0, feed_to_strat1};
-  hft::FeedHandler feed(running, symbols, shard_market_queues, log_feed);
+  hft::FeedHandler feed(running, symbols, shard_map, shard_market_queues, log_feed);
+  feed.set_capture(capture.get());
 
-  hft::StrategyShard strat0(running, "strat0", feed_to_strat0, strat0_to_oms, log_strat0);
-  hft::StrategyShard strat1(running, "strat1", feed_to_strat1, strat1_to_oms, log_strat1);
+  std::vector<std::unique_ptr<hft::StrategyShard>> strats;
+  for (std::size_t i = 0; i < shard_count; ++i) {
+    strats.push_back(std::make_unique<hft::StrategyShard>(running, shard_names[i], shard_market_queues[i],
+                                                          strats_to_oms, ref_prices, log_strats[i], hot_wait));
+  }
 
-  std::vector<std::shared_ptr<hft::StrategyQueue>> strat_outputs{strat0_to_oms, strat1_to_oms};
-  hft::OmsRisk oms(running, strat_outputs, oms_to_trade, log_oms);
-  hft::TradeIo trade(running, oms_to_trade, log_trade);
+  hft::OmsRisk oms(running, symbols, strats_to_oms, oms_to_trade, trade_to_oms, ref_prices, std::move(risk), log_oms,
+                   hot_wait);
+  hft::TradeIo trade(running, symbols, oms_to_trade, trade_to_oms, log_trade, hot_wait);
 
-  bool use_binance = false;
-  std::string binance_symbol = "btcusdt";
-  for (int i = 1; i < argc; ++i) {
-    std::string arg = argv[i];
-    if (arg == "--binance" && i + 1 < argc) {
-      use_binance = true;
-      binance_symbol = argv[++i];
-    }
+  if (topo.lock_memory()) {
+    hft::lock_all_memory();
   }
 
   std::thread feed_thread;
+  std::unique_ptr<hft::ReplayFeed> replay;
   std::unique_ptr<hft::BinanceDepthConnector> binance;
-  if (use_binance) {
+  if (!replay_path.empty()) {
+    replay = std::make_unique<hft::ReplayFeed>(running, symbols, shard_map, shard_market_queues, log_feed,
+                                               replay_capture, replay_pace);
+    feed_thread = std::thread([&]() {
+      hft::apply_placement("feed", topo.placement("feed"));
+      replay->run();
+    });
+  } else if (use_binance) {
 #ifdef ENABLE_BINANCE
-    binance = std::make_unique<hft::BinanceDepthConnector>(running, binance_symbol, feed_to_strat0, log_binance);
-    feed_thread = std::thread([&]() { binance->run(); });
+    binance = std::make_unique<hft::BinanceDepthConnector>(running, binance_id, symbols,
+                                                           shard_market_queues[shard_map.shard(binance_id)], log_binance,
+                                                           binance_endpoint);
+    binance->set_capture(capture.get());
+    feed_thread = std::thread([&]() {
+      hft::apply_placement("feed", topo.placement("feed"));
+      binance->run();
+    });
 #else
     std::cerr << "Binance support not built; rebuild with ENABLE_BINANCE\n";
-    feed_thread = std::thread([&]() { feed.run(); });
+    feed_thread = std::thread([&]() {
+      hft::apply_placement("feed", topo.placement("feed"));
+      feed.run();
+    });
 #endif
   } else {
-    feed_thread = std::thread([&]() { feed.run(); });
+    feed_thread = std::thread([&]() {
+      hft::apply_placement("feed", topo.placement("feed"));
+      feed.run();
+    });
+  }
+  std::vector<std::thread> strat_threads;
+  for (std::size_t i = 0; i < shard_count; ++i) {
+    strat_threads.emplace_back([&, i]() {
+      hft::apply_placement(shard_names[i], topo.placement(shard_names[i]));
+      strats[i]->run();
+    });
   }
-  std::thread strat_thread0([&]() { strat0.run(); });
-  std::thread strat_thread1([&]() { strat1.run(); });
-  std::thread oms_thread([&]() { oms.run(); });
-  std::thread trade_thread([&]() { trade.run(); });
+  std::thread oms_thread([&]() {
+    hft::apply_placement("oms", topo.placement("oms"));
+    oms.run();
+  });
+  std::thread trade_thread([&]() {
+    hft::apply_placement("trade", topo.placement("trade"));
+    trade.run();
+  });
 
-  std::this_thread::sleep_for(2s);
+  // This thread reports tick-to-trade latency once a second while the pipeline runs,
+  // and once more for the tail before stopping it.
+  const auto started = std::chrono::steady_clock::now();
+  auto next_report = started + 1s;
+  const auto wait_until = [&](auto done) {
+    while (!done()) {
+      std::this_thread::sleep_for(10ms);
+      if (std::chrono::steady_clock::now() >= next_report) {
+        trade.report_latency(*log_latency);
+        next_report += 1s;
+      }
+    }
+  };
+  if (replay) {
+    // Run the whole capture, then give the pipeline a moment to drain.
+    wait_until([&] { return replay->finished(); });
+    const auto drained = std::chrono::steady_clock::now() + 100ms;
+    wait_until([&] { return std::chrono::steady_clock::now() >= drained; });
+  } else {
+    wait_until([&] { return std::chrono::steady_clock::now() >= started + 2s; });
+  }
+  trade.report_latency(*log_latency);
   running.store(false, std::memory_order_release);
 
   feed_thread.join();
-  strat_thread0.join();
-  strat_thread1.join();
+  for (auto& t : strat_threads) {
+    t.join();
+  }
   oms_thread.join();
   trade_thread.join();
   log_thread.join();
 
+  // Input for tools/shard_rebalance, from whichever source drove the run.
+  if (!rates_out.empty()) {
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - started;
+    std::vector<hft::SymbolRate> rates;
+    for (std::size_t i = 0; i < symbols.size(); ++i) {
+      const auto sym = static_cast<hft::SymbolId>(i);
+      const std::int64_t events = replay    ? replay->event_count(sym)
+                                  : binance ? binance->event_count(sym)
+                                            : feed.event_count(sym);
+      rates.push_back({std::string(symbols.name(sym)), static_cast<double>(events) / elapsed.count()});
+    }
+    if (!hft::write_symbol_rates(rates_out, rates)) {
+      return 1;
+    }
+  }
+
   return 0;
 }
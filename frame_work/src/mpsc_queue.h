@@ -0,0 +1,101 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+
+#include "wait_strategy.h"
+
+namespace hft {
+
+// Bounded multi-producer single-consumer queue (Vyukov's per-cell sequence scheme).
+// Producers take a ticket with a CAS on head_; each cell carries a sequence number
+// that tells producers when it is free and the consumer when it is published, so the
+// consumer needs no atomic RMW and drains in ticket order, i.e. arrival order.
+//
+// A producer stalled between claiming a ticket and publishing it holds up the cells
+// behind it (the consumer sees them as not yet ready) until it finishes.
+template <typename T, std::size_t CapacityPow2>
+class MpscQueue {
+ public:
+  static_assert((CapacityPow2 & (CapacityPow2 - 1)) == 0, "Capacity must be power-of-two");
+
+  MpscQueue() {
+    for (std::size_t i = 0; i < CapacityPow2; ++i) {
+      cells_[i].seq.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  bool push(const T& item) { return try_emplace(item); }
+
+  // Any thread. Returns false when the queue is full.
+  template <typename... Args>
+  bool try_emplace(Args&&... args) {
+    std::size_t ticket = head_.load(std::memory_order_relaxed);
+    Cell* cell;
+    for (;;) {
+      cell = &cells_[ticket & mask_];
+      const std::size_t seq = cell->seq.load(std::memory_order_acquire);
+      const auto diff = static_cast<std::ptrdiff_t>(seq - ticket);
+      if (diff == 0) {
+        if (head_.compare_exchange_weak(ticket, ticket + 1, std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (diff < 0) {
+        return false;  // cell still holds the item from one lap ago
+      } else {
+        ticket = head_.load(std::memory_order_relaxed);
+      }
+    }
+    cell->value = T{std::forward<Args>(args)...};
+    cell->seq.store(ticket + 1, std::memory_order_release);
+    if (doorbell_ != nullptr) {
+      doorbell_->ring();
+    }
+    return true;
+  }
+
+  bool pop(T& out) {
+    return consume([&out](const T& item) { out = item; }, 1) != 0;
+  }
+
+  // Consumer: calls fn(const T&) on up to max published items in arrival order.
+  template <typename Fn>
+  std::size_t consume(Fn&& fn, std::size_t max = CapacityPow2) {
+    std::size_t count = 0;
+    while (count < max) {
+      Cell& cell = cells_[tail_ & mask_];
+      if (cell.seq.load(std::memory_order_acquire) != tail_ + 1) {
+        break;
+      }
+      fn(cell.value);
+      cell.seq.store(tail_ + CapacityPow2, std::memory_order_release);
+      ++tail_;
+      ++count;
+    }
+    return count;
+  }
+
+  // Consumer-side check, e.g. for WaitStrategy::idle before parking.
+  bool empty() const {
+    return cells_[tail_ & mask_].seq.load(std::memory_order_acquire) != tail_ + 1;
+  }
+
+  // Rung after every publish so a parked consumer wakes; set before threads start.
+  void set_doorbell(Doorbell* doorbell) { doorbell_ = doorbell; }
+
+ private:
+  // One cell per cache line so producers filling neighbouring tickets do not collide.
+  struct alignas(64) Cell {
+    std::atomic<std::size_t> seq;
+    T value;
+  };
+
+  static constexpr std::size_t mask_ = CapacityPow2 - 1;
+  alignas(64) std::atomic<std::size_t> head_{0};
+  Doorbell* doorbell_{nullptr};
+  alignas(64) std::size_t tail_{0};  // consumer only
+  Cell cells_[CapacityPow2];
+};
+
+}  // namespace hft
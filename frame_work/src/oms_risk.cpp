@@ -1,49 +1,69 @@
 #include "oms_risk.h"
 
 #include <chrono>
-#include <thread>
+
+#include "binlog.h"
+#include "tsc.h"
 
 namespace hft {
 
 OmsRisk::OmsRisk(std::atomic<bool>& running,
-                 std::vector<std::shared_ptr<StrategyQueue>> strategy_inputs,
+                 const SymbolRegistry& symbols,
+                 std::shared_ptr<DecisionQueue> inbound,
                  std::shared_ptr<OrderQueue> outbound,
-                 std::shared_ptr<LogQueue> log_queue)
+                 std::shared_ptr<DoneQueue> done,
+                 std::shared_ptr<const ReferencePrices> refs,
+                 RiskEngine risk,
+                 std::shared_ptr<LogQueue> log_queue,
+                 WaitConfig wait)
     : running_(running),
-      strategy_inputs_(std::move(strategy_inputs)),
+      symbols_(symbols),
+      inbound_(std::move(inbound)),
       outbound_(std::move(outbound)),
-      log_queue_(std::move(log_queue)) {}
+      done_(std::move(done)),
+      refs_(std::move(refs)),
+      risk_(std::move(risk)),
+      log_queue_(std::move(log_queue)),
+      wait_(wait) {
+  inbound_->set_doorbell(wait_.doorbell());
+  done_->set_doorbell(wait_.doorbell());
+}
 
 void OmsRisk::run() {
   while (running_.load(std::memory_order_acquire)) {
-    bool progressed = false;
-    for (auto& q : strategy_inputs_) {
-      StrategyDecision d;
-      if (!q->pop(d)) {
-        continue;
+    // One clock read per batch; the rate limits do not need finer resolution.
+    const std::int64_t now_ns =
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+    // Finished orders first, so their exposure is free for this batch's checks.
+    const auto released = done_->consume([this](const OrderDone& o) {
+      if (o.filled > 0.0) {
+        risk_.on_fill(o.symbol, o.buy, o.filled, o.price);
       }
-      progressed = true;
-      if (!risk_passes(d)) {
-        log("risk reject " + d.symbol + " seq=" + std::to_string(d.seq));
-        continue;
+      if (o.qty > o.filled) {
+        risk_.on_cancel(o.symbol, o.buy, o.qty - o.filled, o.price);
       }
-      OrderCommand cmd{d.symbol, d.buy, d.price, d.qty, d.seq};
-      if (!outbound_->push(cmd)) {
-        log("drop order seq=" + std::to_string(d.seq));
+    });
+    const auto n = inbound_->consume([&](const StrategyDecision& d) {
+      TraceStamps trace = d.trace;
+      trace.oms_in = tsc_since(trace.feed_recv, tsc_now());
+      const auto verdict = risk_.check(d, refs_->mid(d.symbol), now_ns);
+      if (verdict != RiskResult::Pass) {
+        HFT_LOG(*log_queue_, "risk reject %s %s seq=%lld", symbols_.name(d.symbol), risk_result_name(verdict), d.seq);
+        return;
       }
-    }
-    if (!progressed) {
-      std::this_thread::sleep_for(std::chrono::microseconds(50));
+      trace.oms_out = tsc_since(trace.feed_recv, tsc_now());
+      if (!outbound_->try_emplace(d.symbol, d.buy, d.price, d.qty, d.seq, trace)) {
+        HFT_LOG(*log_queue_, "drop order seq=%lld", d.seq);
+        risk_.on_cancel(d.symbol, d.buy, d.qty, d.price);
+      }
+    }, kDrainBatch);
+    if (n + released != 0) {
+      wait_.reset();
+    } else {
+      wait_.idle([this] { return !inbound_->empty() || !done_->empty(); });
     }
   }
 }
 
-bool OmsRisk::risk_passes(const StrategyDecision& d) const {
-  return d.qty <= 1.5;
-}
-
-void OmsRisk::log(const std::string& msg) {
-  log_queue_->push(LogEvent{"oms", msg, std::chrono::steady_clock::now()});
-}
-
 }  // namespace hft
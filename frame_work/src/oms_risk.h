@@ -2,29 +2,39 @@
 
 #include <atomic>
 #include <memory>
-#include <vector>
 
+#include "risk.h"
 #include "types.h"
+#include "wait_strategy.h"
 
 namespace hft {
 
 class OmsRisk {
  public:
   OmsRisk(std::atomic<bool>& running,
-          std::vector<std::shared_ptr<StrategyQueue>> strategy_inputs,
+          const SymbolRegistry& symbols,
+          std::shared_ptr<DecisionQueue> inbound,
           std::shared_ptr<OrderQueue> outbound,
-          std::shared_ptr<LogQueue> log_queue);
+          std::shared_ptr<DoneQueue> done,
+          std::shared_ptr<const ReferencePrices> refs,
+          RiskEngine risk,
+          std::shared_ptr<LogQueue> log_queue,
+          WaitConfig wait = {});
 
   void run();
 
  private:
-  bool risk_passes(const StrategyDecision& d) const;
-  void log(const std::string& msg);
+  static constexpr std::size_t kDrainBatch = 64;  // decisions handled per running_ check
 
   std::atomic<bool>& running_;
-  std::vector<std::shared_ptr<StrategyQueue>> strategy_inputs_;
+  const SymbolRegistry& symbols_;
+  std::shared_ptr<DecisionQueue> inbound_;
   std::shared_ptr<OrderQueue> outbound_;
+  std::shared_ptr<DoneQueue> done_;
+  std::shared_ptr<const ReferencePrices> refs_;
+  RiskEngine risk_;
   std::shared_ptr<LogQueue> log_queue_;
+  WaitStrategy wait_;
 };
 
 }  // namespace hft
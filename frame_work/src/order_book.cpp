@@ -1,8 +1,195 @@
 #include "order_book.h"
 
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
 namespace hft {
 
-void OrderBook::apply_deltas(const std::vector<PriceLevel>& bids, const std::vector<PriceLevel>& asks, std::int64_t update_id) {
+OrderBook::OrderBook(double tick_size, std::size_t ladder_levels)
+    : tick_size_(tick_size),
+      inv_tick_(1.0 / tick_size),
+      levels_(std::max<std::size_t>(64, (ladder_levels + 63) & ~std::size_t{63})) {
+  for (Side* side : {&bids_, &asks_}) {
+    side->qty.assign(levels_, 0.0);
+    side->bits.assign(levels_ / 64, 0);
+    side->summary.assign((side->bits.size() + 63) / 64, 0);
+  }
+}
+
+void OrderBook::apply_deltas(std::span<const PriceLevel> bids, std::span<const PriceLevel> asks, std::int64_t update_id) {
+  for (const auto& lvl : bids) {
+    apply_level(lvl, true);
+  }
+  for (const auto& lvl : asks) {
+    apply_level(lvl, false);
+  }
+  last_update_id_ = update_id;
+}
+
+std::optional<BestBidAsk> OrderBook::best() const {
+  if (best_bid_slot_ == kNoLevel || best_ask_slot_ == kNoLevel) {
+    return std::nullopt;
+  }
+  const auto bid_slot = static_cast<std::size_t>(best_bid_slot_);
+  const auto ask_slot = static_cast<std::size_t>(best_ask_slot_);
+  return BestBidAsk{static_cast<double>(base_tick_ + best_bid_slot_) * tick_size_, bids_.qty[bid_slot],
+                    static_cast<double>(base_tick_ + best_ask_slot_) * tick_size_, asks_.qty[ask_slot],
+                    last_update_id_};
+}
+
+void OrderBook::clear() {
+  for (Side* side : {&bids_, &asks_}) {
+    std::fill(side->qty.begin(), side->qty.end(), 0.0);
+    std::fill(side->bits.begin(), side->bits.end(), 0);
+    std::fill(side->summary.begin(), side->summary.end(), 0);
+  }
+  anchored_ = false;
+  best_bid_slot_ = kNoLevel;
+  best_ask_slot_ = kNoLevel;
+  last_update_id_ = 0;
+}
+
+std::int64_t OrderBook::to_tick(double price) const {
+  return std::llround(price * inv_tick_);
+}
+
+void OrderBook::apply_level(const PriceLevel& lvl, bool is_bid) {
+  const bool remove = !(lvl.qty > 0.0);
+  const std::int64_t tick = to_tick(lvl.price);
+  const auto levels = static_cast<std::int64_t>(levels_);
+  if (!anchored_) {
+    if (remove) {
+      return;
+    }
+    base_tick_ = tick - levels / 2;
+    anchored_ = true;
+  }
+
+  std::int64_t slot = tick - base_tick_;
+  if (slot < 0 || slot >= levels) {
+    if (remove) {
+      return;  // never stored
+    }
+    const std::int64_t own_best = is_bid ? best_bid_slot_ : best_ask_slot_;
+    const std::int64_t other_best = is_bid ? best_ask_slot_ : best_bid_slot_;
+    const bool touch_side = is_bid ? slot >= levels : slot < 0;
+    std::int64_t new_base = tick - levels / 2;
+    if (own_best == kNoLevel && other_best == kNoLevel) {
+      // Nothing stored yet: recentering loses nothing.
+    } else if (own_best != kNoLevel && touch_side) {
+      // The touch moved off the window. Keep the other side's best in it if the new
+      // level still fits too, so one side running ahead does not wipe the other.
+      if (other_best != kNoLevel) {
+        const std::int64_t other_tick = base_tick_ + other_best;
+        new_base = is_bid ? std::max(std::min(new_base, other_tick), tick - levels + 1)
+                          : std::min(std::max(new_base, other_tick - levels + 1), tick);
+      }
+    } else {
+      // Deeper than the window, or the first level of a side that would need the other
+      // side moved out of the way.
+      ++dropped_levels_;
+      return;
+    }
+    recenter(new_base);
+    slot = tick - base_tick_;
+  }
+
+  const auto idx = static_cast<std::size_t>(slot);
+  if (is_bid) {
+    set_slot(bids_, idx, remove ? 0.0 : lvl.qty);
+    if (!remove && slot > best_bid_slot_) {
+      best_bid_slot_ = slot;
+    } else if (remove && slot == best_bid_slot_) {
+      best_bid_slot_ = highest_slot(bids_);
+    }
+  } else {
+    set_slot(asks_, idx, remove ? 0.0 : lvl.qty);
+    if (!remove && (best_ask_slot_ == kNoLevel || slot < best_ask_slot_)) {
+      best_ask_slot_ = slot;
+    } else if (remove && slot == best_ask_slot_) {
+      best_ask_slot_ = lowest_slot(asks_);
+    }
+  }
+}
+
+void OrderBook::set_slot(Side& side, std::size_t slot, double qty) {
+  side.qty[slot] = qty;
+  const std::size_t word = slot >> 6;
+  const std::uint64_t bit = std::uint64_t{1} << (slot & 63);
+  if (qty != 0.0) {
+    side.bits[word] |= bit;
+    side.summary[word >> 6] |= std::uint64_t{1} << (word & 63);
+  } else {
+    side.bits[word] &= ~bit;
+    if (side.bits[word] == 0) {
+      side.summary[word >> 6] &= ~(std::uint64_t{1} << (word & 63));
+    }
+  }
+}
+
+// Slides the window so that `new_base` becomes slot 0. Levels that fall off either
+// end are lost and counted as dropped; this is O(levels) but only happens when the
+// touch leaves the window.
+void OrderBook::recenter(std::int64_t new_base) {
+  const std::int64_t shift = new_base - base_tick_;
+  const auto levels = static_cast<std::int64_t>(levels_);
+  const auto occupied = [](auto first, auto last) {
+    return static_cast<std::uint64_t>(std::count_if(first, last, [](double qty) { return qty != 0.0; }));
+  };
+  for (Side* side : {&bids_, &asks_}) {
+    auto& q = side->qty;
+    if (shift >= levels || shift <= -levels) {
+      dropped_levels_ += occupied(q.begin(), q.end());
+      std::fill(q.begin(), q.end(), 0.0);
+    } else if (shift > 0) {
+      dropped_levels_ += occupied(q.begin(), q.begin() + shift);
+      std::copy(q.begin() + shift, q.end(), q.begin());
+      std::fill(q.end() - shift, q.end(), 0.0);
+    } else if (shift < 0) {
+      dropped_levels_ += occupied(q.end() + shift, q.end());
+      std::copy_backward(q.begin(), q.end() + shift, q.end());
+      std::fill(q.begin(), q.begin() - shift, 0.0);
+    }
+    rebuild_bits(*side);
+  }
+  base_tick_ = new_base;
+  best_bid_slot_ = highest_slot(bids_);
+  best_ask_slot_ = lowest_slot(asks_);
+  ++recenters_;
+}
+
+void OrderBook::rebuild_bits(Side& side) {
+  std::fill(side.bits.begin(), side.bits.end(), 0);
+  std::fill(side.summary.begin(), side.summary.end(), 0);
+  for (std::size_t slot = 0; slot < side.qty.size(); ++slot) {
+    if (side.qty[slot] != 0.0) {
+      set_slot(side, slot, side.qty[slot]);
+    }
+  }
+}
+
+std::int64_t OrderBook::highest_slot(const Side& side) {
+  for (std::size_t w = side.summary.size(); w-- > 0;) {
+    if (const auto s = side.summary[w]) {
+      const std::size_t word = w * 64 + 63 - static_cast<std::size_t>(std::countl_zero(s));
+      return static_cast<std::int64_t>(word * 64 + 63 - static_cast<std::size_t>(std::countl_zero(side.bits[word])));
+    }
+  }
+  return kNoLevel;
+}
+
+std::int64_t OrderBook::lowest_slot(const Side& side) {
+  for (std::size_t w = 0; w < side.summary.size(); ++w) {
+    if (const auto s = side.summary[w]) {
+      const std::size_t word = w * 64 + static_cast<std::size_t>(std::countr_zero(s));
+      return static_cast<std::int64_t>(word * 64 + static_cast<std::size_t>(std::countr_zero(side.bits[word])));
+    }
+  }
+  return kNoLevel;
+}
+
+void MapOrderBook::apply_deltas(std::span<const PriceLevel> bids, std::span<const PriceLevel> asks, std::int64_t update_id) {
   for (const auto& lvl : bids) {
     if (lvl.qty == 0.0) {
       bids_.erase(lvl.price);
@@ -20,7 +207,7 @@ void OrderBook::apply_deltas(const std::vector<PriceLevel>& bids, const std::vec
   last_update_id_ = update_id;
 }
 
-std::optional<BestBidAsk> OrderBook::best() const {
+std::optional<BestBidAsk> MapOrderBook::best() const {
   if (bids_.empty() || asks_.empty()) {
     return std::nullopt;
   }
@@ -1,10 +1,10 @@
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
 #include <map>
 #include <optional>
-#include <string>
-#include <utility>
+#include <span>
 #include <vector>
 
 namespace hft {
@@ -22,9 +22,63 @@ struct BestBidAsk {
   std::int64_t update_id{};
 };
 
+// Array-backed price ladder. Prices are converted to integer ticks and stored in a
+// contiguous window of `ladder_levels` slots centred on the touch; a two-level bitmap
+// per side finds the best level with a couple of clz/ctz. Updates never allocate.
+//
+// Levels that land deeper than the window (bids below it, asks above it) are dropped
+// and counted. A level on the touch side of the window recenters it onto that price,
+// as far as the other side's best allows; levels that fall off in a recenter are
+// counted as dropped too. While only one side holds levels, a level for the empty
+// side outside the window is dropped rather than moving the window off the other.
 class OrderBook {
  public:
-  void apply_deltas(const std::vector<PriceLevel>& bids, const std::vector<PriceLevel>& asks, std::int64_t update_id);
+  static constexpr std::size_t kDefaultLadderLevels = std::size_t{1} << 14;
+
+  explicit OrderBook(double tick_size = 0.01, std::size_t ladder_levels = kDefaultLadderLevels);
+
+  void apply_deltas(std::span<const PriceLevel> bids, std::span<const PriceLevel> asks, std::int64_t update_id);
+  std::optional<BestBidAsk> best() const;
+  void clear();
+
+  std::uint64_t dropped_levels() const { return dropped_levels_; }
+  std::uint64_t recenters() const { return recenters_; }
+
+ private:
+  struct Side {
+    std::vector<double> qty;             // slot -> qty, 0 means empty
+    std::vector<std::uint64_t> bits;     // one bit per slot
+    std::vector<std::uint64_t> summary;  // one bit per non-zero word of `bits`
+  };
+
+  static constexpr std::int64_t kNoLevel = -1;
+
+  std::int64_t to_tick(double price) const;
+  void apply_level(const PriceLevel& lvl, bool is_bid);
+  void set_slot(Side& side, std::size_t slot, double qty);
+  void recenter(std::int64_t new_base);
+  void rebuild_bits(Side& side);
+  static std::int64_t highest_slot(const Side& side);
+  static std::int64_t lowest_slot(const Side& side);
+
+  double tick_size_;
+  double inv_tick_;
+  std::size_t levels_;
+  std::int64_t base_tick_{0};  // tick of slot 0
+  bool anchored_{false};
+  Side bids_;
+  Side asks_;
+  std::int64_t best_bid_slot_{kNoLevel};
+  std::int64_t best_ask_slot_{kNoLevel};
+  std::int64_t last_update_id_{0};
+  std::uint64_t dropped_levels_{0};
+  std::uint64_t recenters_{0};
+};
+
+// Reference std::map book, kept for benchmarking and cross-checking the ladder.
+class MapOrderBook {
+ public:
+  void apply_deltas(std::span<const PriceLevel> bids, std::span<const PriceLevel> asks, std::int64_t update_id);
   std::optional<BestBidAsk> best() const;
 
  private:
@@ -0,0 +1,164 @@
+#include "replay_feed.h"
+
+#include <chrono>
+#include <cstring>
+#include <thread>
+
+#include "binlog.h"
+#include "tsc.h"
+#include "wait_strategy.h"
+
+namespace hft {
+
+namespace {
+
+// Close enough to the target to stop sleeping and spin instead.
+constexpr std::int64_t kSpinWindowNs = 200'000;
+constexpr SymbolId kUnbound = 0xffff;  // capture ID with no symbol record yet
+
+}  // namespace
+
+bool parse_replay_pace(std::string_view s, ReplayPace& out) {
+  if (s == "max") {
+    out = ReplayPace::Max;
+  } else if (s == "recorded") {
+    out = ReplayPace::Recorded;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+ReplayFeed::ReplayFeed(std::atomic<bool>& running,
+                       const SymbolRegistry& symbols,
+                       const ShardMap& shards,
+                       std::vector<std::shared_ptr<MarketQueue>> shard_queues,
+                       std::shared_ptr<LogQueue> log_queue,
+                       CaptureReader& capture,
+                       ReplayPace pace)
+    : running_(running),
+      symbols_(symbols),
+      shard_queues_(std::move(shard_queues)),
+      log_queue_(std::move(log_queue)),
+      capture_(capture),
+      pace_(pace),
+      route_(symbols.size()),
+      depth_(symbols.size()),
+      events_(symbols.size(), 0) {
+  for (std::size_t i = 0; i < route_.size(); ++i) {
+    route_[i] = shard_queues_[shards.shard(static_cast<SymbolId>(i))].get();
+  }
+  // Size the ID map and build every DepthFeed now so replay itself never allocates.
+  std::vector<SymbolId> ids;
+  capture_.rewind();
+  CaptureRecord rec;
+  while (capture_.next(rec)) {
+    if (rec.kind == CaptureKind::Symbol) {
+      if (ids.size() <= rec.symbol) {
+        ids.resize(rec.symbol + 1u, kUnbound);
+      }
+      ids[rec.symbol] = *symbols_.find(rec.payload);
+    } else if ((rec.kind == CaptureKind::DepthDiff || rec.kind == CaptureKind::DepthSnapshot) &&
+               rec.symbol < ids.size() && ids[rec.symbol] != kUnbound) {
+      const SymbolId sym = ids[rec.symbol];
+      if (!depth_[sym]) {
+        depth_[sym] = std::make_unique<DepthFeed>(running_, sym, shard_queues_[shards.shard(sym)], log_queue_,
+                                                  DepthFeed::OnFull::Wait);
+      }
+    }
+  }
+  id_map_.assign(ids.size(), kUnbound);
+  capture_.rewind();
+}
+
+void ReplayFeed::run() {
+  const auto start = std::chrono::steady_clock::now();
+  std::int64_t start_ns = 0;
+  std::int64_t first_ns = -1;  // pacing origin, reset per capture session
+  std::int64_t records = 0;
+  std::int64_t events = 0;
+  std::int64_t bad_size = 0;
+  CaptureRecord rec;
+  while (running_.load(std::memory_order_acquire) && capture_.next(rec)) {
+    ++records;
+    if (rec.kind == CaptureKind::Symbol) {
+      id_map_[rec.symbol] = *symbols_.find(rec.payload);
+      first_ns = -1;  // a new session: its clock is unrelated to the previous one
+      continue;
+    }
+    if (pace_ == ReplayPace::Recorded) {
+      if (first_ns < 0) {
+        first_ns = rec.recv_ns;
+        start_ns = capture_now_ns();
+      }
+      wait_until(start_ns + (rec.recv_ns - first_ns));
+    }
+    if (rec.symbol >= id_map_.size() || id_map_[rec.symbol] == kUnbound) {
+      continue;
+    }
+    const SymbolId sym = id_map_[rec.symbol];
+    switch (rec.kind) {
+      case CaptureKind::MarketEvent: {
+        CapturedMarketEvent cap;
+        if (rec.payload.size() != sizeof(cap)) {
+          ++bad_size;
+          break;
+        }
+        std::memcpy(&cap, rec.payload.data(), sizeof(cap));
+        push(MarketEvent{sym, cap.bid, cap.ask, cap.size, cap.seq, tsc_now()});
+        ++events_[sym];
+        ++events;
+        break;
+      }
+      case CaptureKind::DepthDiff:
+        depth_[sym]->on_diff(rec.payload);
+        ++events;
+        break;
+      case CaptureKind::DepthSnapshot:
+        depth_[sym]->on_snapshot(rec.payload);
+        break;
+      case CaptureKind::Symbol:
+        break;
+    }
+  }
+  const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+  if (capture_.truncated()) {
+    HFT_LOG(*log_queue_, "replay: capture ends mid-record, stopped there");
+  }
+  if (bad_size > 0) {
+    HFT_LOG(*log_queue_, "replay: skipped %lld market events of the wrong size (expected %llu bytes)", bad_size,
+            sizeof(CapturedMarketEvent));
+  }
+  HFT_LOG(*log_queue_, "replay done: %lld records, %lld events in %.1f ms", records, events, elapsed.count());
+  finished_.store(true, std::memory_order_release);
+}
+
+std::int64_t ReplayFeed::event_count(SymbolId sym) const {
+  return events_[sym] + (depth_[sym] ? depth_[sym]->event_count() : 0);
+}
+
+void ReplayFeed::wait_until(std::int64_t target_ns) const {
+  for (;;) {
+    const std::int64_t left = target_ns - capture_now_ns();
+    if (left <= 0 || !running_.load(std::memory_order_relaxed)) {
+      return;
+    }
+    if (left > kSpinWindowNs) {
+      std::this_thread::sleep_for(std::chrono::nanoseconds(left - kSpinWindowNs / 2));
+    } else {
+      cpu_relax();
+    }
+  }
+}
+
+void ReplayFeed::push(const MarketEvent& evt) {
+  auto* q = route_[evt.symbol];
+  while (!q->push(evt)) {
+    if (!running_.load(std::memory_order_relaxed)) {
+      return;
+    }
+    cpu_relax();
+  }
+}
+
+}  // namespace hft
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+#include "capture.h"
+#include "depth_feed.h"
+#include "shard_map.h"
+#include "types.h"
+
+namespace hft {
+
+enum class ReplayPace : std::uint8_t {
+  Max,       // as fast as the pipeline drains
+  Recorded,  // records released at their captured receive-time offsets
+};
+
+bool parse_replay_pace(std::string_view s, ReplayPace& out);  // max|recorded
+
+// Drives the MarketQueues from a capture instead of a live source. Simulated-feed
+// events are routed as recorded; depth frames and snapshots go through a DepthFeed per
+// symbol, in capture order, so the book and its gaps/resyncs repeat exactly. Replay
+// never drops: a full queue is waited on, so every run sees identical input.
+//
+// The registry must already hold the capture's symbols (CaptureReader::intern_symbols).
+class ReplayFeed {
+ public:
+  ReplayFeed(std::atomic<bool>& running,
+             const SymbolRegistry& symbols,
+             const ShardMap& shards,
+             std::vector<std::shared_ptr<MarketQueue>> shard_queues,
+             std::shared_ptr<LogQueue> log_queue,
+             CaptureReader& capture,
+             ReplayPace pace);
+
+  void run();
+  bool finished() const { return finished_.load(std::memory_order_acquire); }
+  // Events replayed for sym, simulated and depth alike; read after run() returns.
+  std::int64_t event_count(SymbolId sym) const;
+
+ private:
+  void wait_until(std::int64_t target_ns) const;
+  void push(const MarketEvent& evt);
+
+  std::atomic<bool>& running_;
+  const SymbolRegistry& symbols_;
+  std::vector<std::shared_ptr<MarketQueue>> shard_queues_;
+  std::shared_ptr<LogQueue> log_queue_;
+  CaptureReader& capture_;
+  ReplayPace pace_;
+  std::vector<MarketQueue*> route_;                 // indexed by SymbolId
+  std::vector<SymbolId> id_map_;                    // capture symbol -> SymbolId
+  std::vector<std::unique_ptr<DepthFeed>> depth_;   // indexed by SymbolId, built up front
+  std::vector<std::int64_t> events_;                // simulated events, indexed by SymbolId
+  std::atomic<bool> finished_{false};
+};
+
+}  // namespace hft
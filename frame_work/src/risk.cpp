@@ -0,0 +1,171 @@
+#include "risk.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+namespace hft {
+
+namespace {
+
+std::istringstream fields(std::string& line) {
+  if (const auto hash = line.find('#'); hash != std::string::npos) {
+    line.erase(hash);
+  }
+  return std::istringstream(line);
+}
+
+}  // namespace
+
+const char* risk_result_name(RiskResult r) {
+  switch (r) {
+    case RiskResult::Pass: return "pass";
+    case RiskResult::FatFinger: return "fat-finger";
+    case RiskResult::NoReference: return "no-reference";
+    case RiskResult::PriceBand: return "price-band";
+    case RiskResult::Position: return "position";
+    case RiskResult::Notional: return "notional";
+    case RiskResult::GlobalNotional: return "global-notional";
+    case RiskResult::Rate: return "rate";
+    case RiskResult::GlobalRate: return "global-rate";
+  }
+  return "?";
+}
+
+RiskEngine::RiskEngine(std::size_t symbols, RiskLimits defaults, GlobalRiskLimits global) : table_(symbols) {
+  for (std::size_t i = 0; i < symbols; ++i) {
+    set_limits(static_cast<SymbolId>(i), defaults);
+  }
+  set_global_limits(global);
+}
+
+bool RiskEngine::load_file(const std::string& path, const SymbolRegistry& symbols) {
+  std::ifstream in(path);
+  if (!in) {
+    std::cerr << "risk limits: cannot open " << path << "\n";
+    return false;
+  }
+  std::string line;
+  int lineno = 0;
+  while (std::getline(in, line)) {
+    ++lineno;
+    auto ss = fields(line);
+    std::string symbol;
+    if (!(ss >> symbol)) {
+      continue;
+    }
+    if (symbol == "GLOBAL") {
+      GlobalRiskLimits g;
+      if (!(ss >> g.max_open_notional >> g.orders_per_sec >> g.burst)) {
+        std::cerr << "risk limits: " << path << ":" << lineno
+                  << ": expected 'GLOBAL <max_open_notional> <orders_per_sec> <burst>'\n";
+        return false;
+      }
+      set_global_limits(g);
+      continue;
+    }
+    RiskLimits l;
+    if (!(ss >> l.max_order_qty >> l.max_position >> l.max_open_notional >> l.orders_per_sec >> l.burst >>
+          l.band_bps)) {
+      std::cerr << "risk limits: " << path << ":" << lineno
+                << ": expected '<SYMBOL> <max_order_qty> <max_position> <max_open_notional> <orders_per_sec> "
+                   "<burst> <band_bps>'\n";
+      return false;
+    }
+    if (symbol == "*") {
+      for (std::size_t i = 0; i < table_.size(); ++i) {
+        set_limits(static_cast<SymbolId>(i), l);
+      }
+      continue;
+    }
+    const auto sym = symbols.find(symbol);
+    if (!sym || *sym >= table_.size()) {
+      std::cerr << "risk limits: " << path << ":" << lineno << ": unknown symbol " << symbol << "\n";
+      return false;
+    }
+    set_limits(*sym, l);
+  }
+  return true;
+}
+
+void RiskEngine::set_limits(SymbolId sym, const RiskLimits& limits) {
+  auto& s = table_[sym];
+  s.limits = limits;
+  s.bucket.tokens = limits.burst;
+}
+
+void RiskEngine::set_global_limits(const GlobalRiskLimits& limits) {
+  global_ = limits;
+  global_bucket_.tokens = limits.burst;
+}
+
+void RiskEngine::TokenBucket::refill(double per_sec, double burst, std::int64_t now_ns) {
+  if (now_ns > last_ns) {
+    tokens = std::min(burst, tokens + static_cast<double>(now_ns - last_ns) * per_sec * 1e-9);
+    last_ns = now_ns;
+  }
+}
+
+RiskResult RiskEngine::check(const StrategyDecision& d, double ref_mid, std::int64_t now_ns) {
+  auto& s = table_[d.symbol];
+  const auto& l = s.limits;
+
+  if (!(d.qty > 0.0) || d.qty > l.max_order_qty) {
+    return RiskResult::FatFinger;
+  }
+  if (!(ref_mid > 0.0)) {
+    return RiskResult::NoReference;
+  }
+  if (std::fabs(d.price - ref_mid) > ref_mid * l.band_bps * 1e-4) {
+    return RiskResult::PriceBand;
+  }
+  const bool position_ok = d.buy ? s.position + s.open_buy + d.qty <= l.max_position
+                                 : s.position - s.open_sell - d.qty >= -l.max_position;
+  if (!position_ok) {
+    return RiskResult::Position;
+  }
+  const double notional = d.price * d.qty;
+  if (s.open_notional + notional > l.max_open_notional) {
+    return RiskResult::Notional;
+  }
+  if (global_open_notional_ + notional > global_.max_open_notional) {
+    return RiskResult::GlobalNotional;
+  }
+  s.bucket.refill(l.orders_per_sec, l.burst, now_ns);
+  if (s.bucket.tokens < 1.0) {
+    return RiskResult::Rate;
+  }
+  global_bucket_.refill(global_.orders_per_sec, global_.burst, now_ns);
+  if (global_bucket_.tokens < 1.0) {
+    return RiskResult::GlobalRate;
+  }
+
+  s.bucket.tokens -= 1.0;
+  global_bucket_.tokens -= 1.0;
+  (d.buy ? s.open_buy : s.open_sell) += d.qty;
+  s.open_notional += notional;
+  global_open_notional_ += notional;
+  return RiskResult::Pass;
+}
+
+void RiskEngine::release(SymbolState& s, bool buy, double qty, double price) {
+  auto& open = buy ? s.open_buy : s.open_sell;
+  open = std::max(0.0, open - qty);
+  const double notional = std::min(price * qty, s.open_notional);
+  s.open_notional -= notional;
+  global_open_notional_ = std::max(0.0, global_open_notional_ - notional);
+}
+
+void RiskEngine::on_fill(SymbolId sym, bool buy, double qty, double price) {
+  auto& s = table_[sym];
+  release(s, buy, qty, price);
+  s.position += buy ? qty : -qty;
+}
+
+void RiskEngine::on_cancel(SymbolId sym, bool buy, double qty, double price) {
+  release(table_[sym], buy, qty, price);
+}
+
+}  // namespace hft
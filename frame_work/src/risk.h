@@ -0,0 +1,116 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "types.h"
+
+namespace hft {
+
+struct RiskLimits {
+  double max_order_qty = 10.0;          // fat-finger cap on a single order
+  double max_position = 1000.0;         // |position| if every open order on one side fills
+  double max_open_notional = 1e6;       // price * qty of orders sent and not yet done
+  double orders_per_sec = 5000.0;       // token bucket refill rate
+  double burst = 100.0;                 // token bucket depth
+  double band_bps = 500.0;              // max distance of the order price from the last mid
+};
+
+struct GlobalRiskLimits {
+  double max_open_notional = 1e7;
+  double orders_per_sec = 20000.0;
+  double burst = 500.0;
+};
+
+enum class RiskResult : std::uint8_t {
+  Pass,
+  FatFinger,
+  NoReference,  // no market data seen for the symbol yet
+  PriceBand,
+  Position,
+  Notional,
+  GlobalNotional,
+  Rate,
+  GlobalRate,
+};
+
+const char* risk_result_name(RiskResult r);
+
+// Last mid per symbol, written by the strategy shard that owns the symbol and read by
+// the risk stage. One slot per cache line so shards updating neighbouring symbols do
+// not share lines. Size it from the registry after the last intern().
+class ReferencePrices {
+ public:
+  explicit ReferencePrices(std::size_t symbols) : slots_(symbols) {}
+
+  void update(SymbolId sym, double mid) { slots_[sym].mid.store(mid, std::memory_order_relaxed); }
+  double mid(SymbolId sym) const { return slots_[sym].mid.load(std::memory_order_relaxed); }
+
+ private:
+  struct alignas(64) Slot {
+    std::atomic<double> mid{0.0};
+  };
+
+  std::vector<Slot> slots_;
+};
+
+// Pre-trade checks for the OMS thread. Limits and running exposure live together in a
+// flat table indexed by SymbolId; check() touches one table entry plus the global
+// totals, runs in constant time and never allocates.
+//
+// An order that passes is reserved immediately: its qty counts as open on its side
+// and its notional as open exposure until on_fill() or on_cancel() releases it. In
+// hft_demo, OmsRisk makes those calls from TradeIo's done reports (OrderDone). With no
+// venue, TradeIo reports every order done unfilled as soon as it is sent, so the
+// position and open-notional checks only ever see zero open exposure and a flat
+// position there; they bind once a venue reports resting orders and real fills.
+//
+// Limits file, one entry per line, '#' starts a comment:
+//   <SYMBOL> <max_order_qty> <max_position> <max_open_notional> <orders_per_sec> <burst> <band_bps>
+//   GLOBAL <max_open_notional> <orders_per_sec> <burst>
+// A '*' symbol sets every symbol at that point in the file, so list it first.
+class RiskEngine {
+ public:
+  explicit RiskEngine(std::size_t symbols, RiskLimits defaults = {}, GlobalRiskLimits global = {});
+
+  bool load_file(const std::string& path, const SymbolRegistry& symbols);
+  void set_limits(SymbolId sym, const RiskLimits& limits);
+  void set_global_limits(const GlobalRiskLimits& limits);
+
+  RiskResult check(const StrategyDecision& d, double ref_mid, std::int64_t now_ns);
+
+  void on_fill(SymbolId sym, bool buy, double qty, double price);
+  void on_cancel(SymbolId sym, bool buy, double qty, double price);
+
+  double position(SymbolId sym) const { return table_[sym].position; }
+  double open_notional(SymbolId sym) const { return table_[sym].open_notional; }
+
+ private:
+  struct TokenBucket {
+    double tokens{};
+    std::int64_t last_ns{};
+
+    void refill(double per_sec, double burst, std::int64_t now_ns);
+  };
+
+  struct alignas(64) SymbolState {
+    RiskLimits limits;
+    double position{};
+    double open_buy{};
+    double open_sell{};
+    double open_notional{};
+    TokenBucket bucket;
+  };
+
+  void release(SymbolState& s, bool buy, double qty, double price);
+
+  std::vector<SymbolState> table_;
+  GlobalRiskLimits global_;
+  double global_open_notional_{};
+  TokenBucket global_bucket_;
+};
+
+}  // namespace hft
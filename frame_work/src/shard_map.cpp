@@ -0,0 +1,135 @@
+#include "shard_map.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <numeric>
+#include <sstream>
+#include <string_view>
+
+namespace hft {
+
+namespace {
+
+std::uint64_t fnv1a(std::string_view s) {
+  std::uint64_t h = 14695981039346656037ULL;
+  for (const char c : s) {
+    h ^= static_cast<unsigned char>(c);
+    h *= 1099511628211ULL;
+  }
+  return h;
+}
+
+// Strips a '#' comment and returns the line's whitespace-separated fields.
+std::istringstream fields(std::string& line) {
+  if (const auto hash = line.find('#'); hash != std::string::npos) {
+    line.erase(hash);
+  }
+  return std::istringstream(line);
+}
+
+}  // namespace
+
+bool ShardMap::load_file(const std::string& path, SymbolRegistry& symbols) {
+  std::ifstream in(path);
+  if (!in) {
+    std::cerr << "shard map: cannot open " << path << "\n";
+    return false;
+  }
+  std::string line;
+  int lineno = 0;
+  while (std::getline(in, line)) {
+    ++lineno;
+    auto ss = fields(line);
+    std::string symbol;
+    if (!(ss >> symbol)) {
+      continue;
+    }
+    std::size_t shard = 0;
+    if (!(ss >> shard)) {
+      std::cerr << "shard map: " << path << ":" << lineno << ": expected '<SYMBOL> <shard>'\n";
+      return false;
+    }
+    if (!assign(symbols.intern(symbol), shard)) {
+      std::cerr << "shard map: " << path << ":" << lineno << ": shard " << shard << " out of range (" << shard_count_
+                << " shards)\n";
+      return false;
+    }
+  }
+  return true;
+}
+
+bool ShardMap::assign(SymbolId sym, std::size_t shard) {
+  if (shard >= shard_count_) {
+    return false;
+  }
+  if (table_.size() <= sym) {
+    table_.resize(sym + 1u, kUnassigned);
+  }
+  table_[sym] = static_cast<std::uint16_t>(shard);
+  return true;
+}
+
+void ShardMap::resolve(const SymbolRegistry& symbols) {
+  table_.resize(symbols.size(), kUnassigned);
+  for (std::size_t i = 0; i < table_.size(); ++i) {
+    if (table_[i] == kUnassigned) {
+      table_[i] = static_cast<std::uint16_t>(fnv1a(symbols.name(static_cast<SymbolId>(i))) % shard_count_);
+    }
+  }
+}
+
+bool write_symbol_rates(const std::string& path, const std::vector<SymbolRate>& rates) {
+  std::ofstream out(path);
+  if (!out) {
+    std::cerr << "rates: cannot open " << path << "\n";
+    return false;
+  }
+  out << "# symbol events_per_sec\n";
+  for (const auto& r : rates) {
+    out << r.symbol << " " << r.events_per_sec << "\n";
+  }
+  return static_cast<bool>(out);
+}
+
+bool read_symbol_rates(const std::string& path, std::vector<SymbolRate>& rates) {
+  std::ifstream in(path);
+  if (!in) {
+    std::cerr << "rates: cannot open " << path << "\n";
+    return false;
+  }
+  std::string line;
+  int lineno = 0;
+  while (std::getline(in, line)) {
+    ++lineno;
+    auto ss = fields(line);
+    SymbolRate r;
+    if (!(ss >> r.symbol)) {
+      continue;
+    }
+    if (!(ss >> r.events_per_sec) || r.events_per_sec < 0) {
+      std::cerr << "rates: " << path << ":" << lineno << ": expected '<SYMBOL> <events_per_sec>'\n";
+      return false;
+    }
+    rates.push_back(std::move(r));
+  }
+  return true;
+}
+
+std::vector<std::size_t> balance_shards(const std::vector<SymbolRate>& rates, std::size_t shard_count) {
+  std::vector<std::size_t> order(rates.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(),
+                   [&](std::size_t a, std::size_t b) { return rates[a].events_per_sec > rates[b].events_per_sec; });
+
+  std::vector<double> load(shard_count, 0.0);
+  std::vector<std::size_t> shard_of(rates.size(), 0);
+  for (const auto i : order) {
+    const auto lightest = static_cast<std::size_t>(std::min_element(load.begin(), load.end()) - load.begin());
+    shard_of[i] = lightest;
+    load[lightest] += rates[i].events_per_sec;
+  }
+  return shard_of;
+}
+
+}  // namespace hft
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "symbol_registry.h"
+
+namespace hft {
+
+// Symbol -> strategy shard assignment, resolved once at startup into a flat table
+// indexed by SymbolId so the feed routes an event with a single load.
+//
+// Map file, one symbol per line, '#' starts a comment:
+//   <SYMBOL> <shard>
+// Symbols named in the file are interned. Symbols without an explicit entry fall
+// back to a stable name hash (FNV-1a), so the layout is identical across runs.
+class ShardMap {
+ public:
+  explicit ShardMap(std::size_t shard_count = 1) : shard_count_(shard_count) {}
+
+  bool load_file(const std::string& path, SymbolRegistry& symbols);
+  bool assign(SymbolId sym, std::size_t shard);
+  // Fills the table for every symbol in the registry; call after the last intern().
+  void resolve(const SymbolRegistry& symbols);
+
+  std::size_t shard_count() const { return shard_count_; }
+  std::size_t shard(SymbolId sym) const { return table_[sym]; }
+
+ private:
+  static constexpr std::uint16_t kUnassigned = 0xffff;
+
+  std::size_t shard_count_;
+  std::vector<std::uint16_t> table_;
+};
+
+// Per-symbol event rate as measured by a run (hft_demo --rates-out).
+struct SymbolRate {
+  std::string symbol;
+  double events_per_sec{};
+};
+
+bool write_symbol_rates(const std::string& path, const std::vector<SymbolRate>& rates);
+bool read_symbol_rates(const std::string& path, std::vector<SymbolRate>& rates);
+
+// Greedy longest-processing-time assignment: hottest symbol first, each onto the
+// currently least loaded shard. Returns the shard for each entry of `rates`.
+std::vector<std::size_t> balance_shards(const std::vector<SymbolRate>& rates, std::size_t shard_count);
+
+}  // namespace hft
@@ -2,35 +2,127 @@
 
 #include <atomic>
 #include <cstddef>
+#include <utility>
+
+#include "wait_strategy.h"
 
 namespace hft {
 
+// Each side keeps a private copy of the other side's index and only reloads the shared
+// atomic when the copy says full/empty, so steady-state calls stay on their own line.
 template <typename T, std::size_t CapacityPow2>
 class SpscQueue {
  public:
   static_assert((CapacityPow2 & (CapacityPow2 - 1)) == 0, "Capacity must be power-of-two");
 
   bool push(const T& item) {
-    const std::size_t head = head_.load(std::memory_order_relaxed); // why relax?
-    const std::size_t next = (head + 1) & mask_;
-    if (next == tail_.load(std::memory_order_acquire)) {
+    T* slot = try_claim();
+    if (slot == nullptr) {
       return false; // full?
     }
-    buffer_[head] = item;
-    head_.store(next, std::memory_order_release);
+    *slot = item;
+    commit();
     return true;
   }
 
+  template <typename... Args>
+  bool try_emplace(Args&&... args) {
+    T* slot = try_claim();
+    if (slot == nullptr) {
+      return false;
+    }
+    *slot = T{std::forward<Args>(args)...};
+    commit();
+    return true;
+  }
+
+  // Producer: returns the next free slot to build the item in place, or nullptr when
+  // full. Nothing is visible to the consumer until commit().
+  T* try_claim() {
+    const std::size_t head = head_.load(std::memory_order_relaxed); // why relax?
+    const std::size_t next = (head + 1) & mask_;
+    if (next == tail_cache_) {
+      tail_cache_ = tail_.load(std::memory_order_acquire);
+      if (next == tail_cache_) {
+        return nullptr;
+      }
+    }
+    return &buffer_[head];
+  }
+
+  void commit() {
+    head_.store((head_.load(std::memory_order_relaxed) + 1) & mask_, std::memory_order_release);
+    if (doorbell_ != nullptr) {
+      doorbell_->ring();
+    }
+  }
+
+  // Pushes up to n items with a single index publish; returns how many were pushed.
+  std::size_t push_batch(const T* items, std::size_t n) {
+    const std::size_t head = head_.load(std::memory_order_relaxed);
+    std::size_t free = (tail_cache_ - head - 1) & mask_;
+    if (free < n) {
+      tail_cache_ = tail_.load(std::memory_order_acquire);
+      free = (tail_cache_ - head - 1) & mask_;
+    }
+    const std::size_t count = n < free ? n : free;
+    for (std::size_t i = 0; i < count; ++i) {
+      buffer_[(head + i) & mask_] = items[i];
+    }
+    if (count != 0) {
+      head_.store((head + count) & mask_, std::memory_order_release);
+      if (doorbell_ != nullptr) {
+        doorbell_->ring();
+      }
+    }
+    return count;
+  }
+
   bool pop(T& out) {
     const std::size_t tail = tail_.load(std::memory_order_relaxed);
-    if (tail == head_.load(std::memory_order_acquire)) {
-      return false;
+    if (tail == head_cache_) {
+      head_cache_ = head_.load(std::memory_order_acquire);
+      if (tail == head_cache_) {
+        return false;
+      }
     }
     out = buffer_[tail];
     tail_.store((tail + 1) & mask_, std::memory_order_release);
     return true;
   }
 
+  // Pops up to max items with a single index publish; returns how many were popped.
+  std::size_t pop_batch(T* out, std::size_t max) {
+    return consume([&out](const T& item) { *out++ = item; }, max);
+  }
+
+  // Calls fn(const T&) on up to max items in place, then releases them all at once.
+  template <typename Fn>
+  std::size_t consume(Fn&& fn, std::size_t max = CapacityPow2) {
+    const std::size_t tail = tail_.load(std::memory_order_relaxed);
+    std::size_t avail = (head_cache_ - tail) & mask_;
+    if (avail < max) {
+      head_cache_ = head_.load(std::memory_order_acquire);
+      avail = (head_cache_ - tail) & mask_;
+    }
+    const std::size_t count = max < avail ? max : avail;
+    for (std::size_t i = 0; i < count; ++i) {
+      fn(buffer_[(tail + i) & mask_]);
+    }
+    if (count != 0) {
+      tail_.store((tail + count) & mask_, std::memory_order_release);
+    }
+    return count;
+  }
+
+  // Consumer-side check, e.g. for WaitStrategy::idle before parking.
+  bool empty() const {
+    return tail_.load(std::memory_order_relaxed) == head_.load(std::memory_order_acquire);
+  }
+
+  // Rung after every publish so a parked consumer wakes; set before threads start.
+  void set_doorbell(Doorbell* doorbell) { doorbell_ = doorbell; }
+
   std::size_t size() const {
     const std::size_t head = head_.load(std::memory_order_acquire);
     const std::size_t tail = tail_.load(std::memory_order_acquire);
@@ -39,9 +131,12 @@ class SpscQueue {
 
  private:
   alignas(64) std::atomic<std::size_t> head_{0};
+  std::size_t tail_cache_{0};  // producer's view of tail_
+  Doorbell* doorbell_{nullptr};
   alignas(64) std::atomic<std::size_t> tail_{0};
+  std::size_t head_cache_{0};  // consumer's view of head_
   static constexpr std::size_t mask_ = CapacityPow2 - 1;
-  T buffer_[CapacityPow2];
+  alignas(64) T buffer_[CapacityPow2];
 };
 
 }  // namespace hft
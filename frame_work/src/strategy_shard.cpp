@@ -1,40 +1,47 @@
 #include "strategy_shard.h"
 
-#include <chrono>
-#include <thread>
+#include "binlog.h"
+#include "tsc.h"
 
 namespace hft {
 
 StrategyShard::StrategyShard(std::atomic<bool>& running,
                              std::string name,
                              std::shared_ptr<MarketQueue> inbound,
-                             std::shared_ptr<StrategyQueue> outbound,
-                             std::shared_ptr<LogQueue> log_queue)
+                             std::shared_ptr<DecisionQueue> outbound,
+                             std::shared_ptr<ReferencePrices> refs,
+                             std::shared_ptr<LogQueue> log_queue,
+                             WaitConfig wait)
     : running_(running),
       name_(std::move(name)),
       inbound_(std::move(inbound)),
       outbound_(std::move(outbound)),
-      log_queue_(std::move(log_queue)) {}
+      refs_(std::move(refs)),
+      log_queue_(std::move(log_queue)),
+      wait_(wait) {
+  inbound_->set_doorbell(wait_.doorbell());
+}
 
 void StrategyShard::run() {
   while (running_.load(std::memory_order_acquire)) {
     MarketEvent evt;
     if (!inbound_->pop(evt)) {
-      std::this_thread::sleep_for(std::chrono::microseconds(50));
+      wait_.idle([this] { return !inbound_->empty(); });
       continue;
     }
+    wait_.reset();
+    TraceStamps trace{evt.recv_tsc};
+    trace.strat_in = tsc_since(evt.recv_tsc, tsc_now());
     const double mid = (evt.bid + evt.ask) * 0.5;
+    refs_->update(evt.symbol, mid);  // this shard is the symbol's only writer
     const bool buy = (evt.seq % 2) == 0;
     const double px = buy ? mid - 0.05 : mid + 0.05;
-    StrategyDecision decision{evt.symbol, buy, px, evt.size * 0.8, evt.seq};
+    trace.strat_out = tsc_since(evt.recv_tsc, tsc_now());
+    StrategyDecision decision{evt.symbol, buy, px, evt.size * 0.8, evt.seq, trace};
     if (!outbound_->push(decision)) {
-      log("drop decision seq=" + std::to_string(evt.seq));
+      HFT_LOG(*log_queue_, "drop decision seq=%lld", evt.seq);
     }
   }
 }
 
-void StrategyShard::log(const std::string& msg) {
-  log_queue_->push(LogEvent{name_, msg, std::chrono::steady_clock::now()});
-}
-
 }  // namespace hft
@@ -4,7 +4,9 @@
 #include <memory>
 #include <string>
 
+#include "risk.h"
 #include "types.h"
+#include "wait_strategy.h"
 
 namespace hft {
 
@@ -13,19 +15,21 @@ class StrategyShard {
   StrategyShard(std::atomic<bool>& running,
                 std::string name,
                 std::shared_ptr<MarketQueue> inbound,
-                std::shared_ptr<StrategyQueue> outbound,
-                std::shared_ptr<LogQueue> log_queue);
+                std::shared_ptr<DecisionQueue> outbound,
+                std::shared_ptr<ReferencePrices> refs,
+                std::shared_ptr<LogQueue> log_queue,
+                WaitConfig wait = {});
 
   void run();
 
  private:
-  void log(const std::string& msg);
-
   std::atomic<bool>& running_;
   std::string name_;
   std::shared_ptr<MarketQueue> inbound_;
-  std::shared_ptr<StrategyQueue> outbound_;
+  std::shared_ptr<DecisionQueue> outbound_;
+  std::shared_ptr<ReferencePrices> refs_;
   std::shared_ptr<LogQueue> log_queue_;
+  WaitStrategy wait_;
 };
 
 }  // namespace hft
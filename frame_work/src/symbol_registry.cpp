@@ -0,0 +1,29 @@
+#include "symbol_registry.h"
+
+#include <limits>
+#include <stdexcept>
+
+namespace hft {
+
+SymbolId SymbolRegistry::intern(std::string_view name) {
+  if (const auto id = find(name)) {
+    return *id;
+  }
+  if (names_.size() > std::numeric_limits<SymbolId>::max()) {
+    throw std::length_error("too many symbols");
+  }
+  const auto id = static_cast<SymbolId>(names_.size());
+  names_.emplace_back(name);
+  ids_.emplace(names_.back(), id);
+  return id;
+}
+
+std::optional<SymbolId> SymbolRegistry::find(std::string_view name) const {
+  const auto it = ids_.find(std::string(name));
+  if (it == ids_.end()) {
+    return std::nullopt;
+  }
+  return it->second;
+}
+
+}  // namespace hft
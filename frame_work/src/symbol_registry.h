@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace hft {
+
+using SymbolId = std::uint16_t;
+
+// Maps symbol names to dense integer IDs. Populate it at startup before any pipeline
+// thread starts; afterwards it is read-only and safe to share between threads.
+class SymbolRegistry {
+ public:
+  SymbolId intern(std::string_view name);
+  std::optional<SymbolId> find(std::string_view name) const;
+  std::string_view name(SymbolId id) const { return names_[id]; }
+  std::size_t size() const { return names_.size(); }
+
+ private:
+  std::vector<std::string> names_;
+  std::unordered_map<std::string, SymbolId> ids_;
+};
+
+}  // namespace hft
@@ -0,0 +1,176 @@
+#include "topology.h"
+
+#include <dirent.h>
+#include <linux/mempolicy.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+namespace hft {
+
+namespace {
+
+// Parses "a=1,b=2" and hands each pair to fn; false on malformed input.
+template <typename Fn>
+bool parse_pairs(std::string_view spec, Fn&& fn) {
+  while (!spec.empty()) {
+    const auto comma = spec.find(',');
+    const auto item = spec.substr(0, comma);
+    const auto eq = item.find('=');
+    if (eq == std::string_view::npos || eq == 0) {
+      std::cerr << "topology: expected comp=value, got '" << item << "'\n";
+      return false;
+    }
+    try {
+      fn(std::string(item.substr(0, eq)), std::stoi(std::string(item.substr(eq + 1))));
+    } catch (const std::exception&) {
+      std::cerr << "topology: bad number in '" << item << "'\n";
+      return false;
+    }
+    spec = comma == std::string_view::npos ? std::string_view{} : spec.substr(comma + 1);
+  }
+  return true;
+}
+
+std::size_t page_round(std::size_t bytes) {
+  const auto page = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+  return (bytes + page - 1) & ~(page - 1);
+}
+
+}  // namespace
+
+bool Topology::load_file(const std::string& path) {
+  std::ifstream in(path);
+  if (!in) {
+    std::cerr << "topology: cannot open " << path << "\n";
+    return false;
+  }
+  std::string line;
+  int lineno = 0;
+  while (std::getline(in, line)) {
+    ++lineno;
+    if (const auto hash = line.find('#'); hash != std::string::npos) {
+      line.erase(hash);
+    }
+    std::istringstream ss(line);
+    std::string component;
+    if (!(ss >> component)) {
+      continue;
+    }
+    if (component == "mlockall") {
+      lock_memory_ = true;
+      continue;
+    }
+    ThreadPlacement p;
+    if (!(ss >> p.cpu)) {
+      std::cerr << "topology: " << path << ":" << lineno << ": expected '<component> <cpu> [fifo_priority]'\n";
+      return false;
+    }
+    ss >> p.fifo_priority;
+    placements_[component] = p;
+  }
+  return true;
+}
+
+bool Topology::parse_pin_list(std::string_view spec) {
+  return parse_pairs(spec, [this](std::string comp, int cpu) { placements_[std::move(comp)].cpu = cpu; });
+}
+
+bool Topology::parse_fifo_list(std::string_view spec) {
+  return parse_pairs(spec, [this](std::string comp, int prio) { placements_[std::move(comp)].fifo_priority = prio; });
+}
+
+ThreadPlacement Topology::placement(std::string_view component) const {
+  const auto it = placements_.find(std::string(component));
+  return it == placements_.end() ? ThreadPlacement{} : it->second;
+}
+
+int Topology::numa_node(std::string_view component) const {
+  return numa_node_of_cpu(placement(component).cpu);
+}
+
+bool apply_placement(std::string_view name, const ThreadPlacement& p) {
+  bool ok = true;
+  const std::string thread_name(name.substr(0, 15));
+  pthread_setname_np(pthread_self(), thread_name.c_str());
+  if (p.cpu >= 0) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(p.cpu, &set);
+    if (const int rc = pthread_setaffinity_np(pthread_self(), sizeof(set), &set); rc != 0) {
+      std::cerr << name << ": pin to cpu " << p.cpu << " failed: " << std::strerror(rc) << "\n";
+      ok = false;
+    }
+  }
+  if (p.fifo_priority > 0) {
+    sched_param param{};
+    param.sched_priority = p.fifo_priority;
+    if (const int rc = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param); rc != 0) {
+      std::cerr << name << ": SCHED_FIFO " << p.fifo_priority << " failed: " << std::strerror(rc) << "\n";
+      ok = false;
+    }
+  }
+  return ok;
+}
+
+bool lock_all_memory() {
+  if (::mlockall(MCL_CURRENT | MCL_FUTURE) != 0) {
+    perror("mlockall");
+    return false;
+  }
+  return true;
+}
+
+int numa_node_of_cpu(int cpu) {
+  if (cpu < 0) {
+    return -1;
+  }
+  const std::string dir = "/sys/devices/system/cpu/cpu" + std::to_string(cpu);
+  DIR* d = ::opendir(dir.c_str());
+  if (d == nullptr) {
+    return -1;
+  }
+  int node = -1;
+  while (const dirent* e = ::readdir(d)) {
+    if (std::strncmp(e->d_name, "node", 4) == 0 && e->d_name[4] >= '0' && e->d_name[4] <= '9') {
+      node = std::atoi(e->d_name + 4);
+      break;
+    }
+  }
+  ::closedir(d);
+  return node;
+}
+
+void* alloc_on_node(std::size_t bytes, int node) {
+  const std::size_t len = page_round(bytes);
+  void* p = ::mmap(nullptr, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (p == MAP_FAILED) {
+    perror("mmap");
+    return nullptr;
+  }
+  if (node >= 0) {
+    unsigned long mask[16]{};
+    const auto bits = 8 * sizeof(unsigned long);
+    if (static_cast<std::size_t>(node) < sizeof(mask) * 8) {
+      mask[node / bits] |= 1UL << (node % bits);
+      // Best effort: single-node kernels or seccomp may refuse; first touch still applies.
+      ::syscall(SYS_mbind, p, len, MPOL_PREFERRED, mask, sizeof(mask) * 8, 0);
+    }
+  }
+  std::memset(p, 0, len);  // fault every page in now, under the policy above
+  return p;
+}
+
+void free_on_node(void* p, std::size_t bytes) {
+  ::munmap(p, page_round(bytes));
+}
+
+}  // namespace hft
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace hft {
+
+struct ThreadPlacement {
+  int cpu = -1;           // -1 leaves the thread unpinned
+  int fifo_priority = 0;  // >0 switches the thread to SCHED_FIFO at that priority
+};
+
+// Startup thread/memory layout, keyed by component name (feed, strat0, oms, ...).
+//
+// Config file, one directive per line, '#' starts a comment:
+//   <component> <cpu> [fifo_priority]
+//   mlockall
+// The CLI forms are --pin comp=cpu[,comp=cpu...], --fifo comp=prio[,...] and --mlockall.
+class Topology {
+ public:
+  bool load_file(const std::string& path);
+  bool parse_pin_list(std::string_view spec);
+  bool parse_fifo_list(std::string_view spec);
+  void set_lock_memory(bool on) { lock_memory_ = on; }
+
+  ThreadPlacement placement(std::string_view component) const;
+  int numa_node(std::string_view component) const;  // -1 when unpinned or unknown
+  bool lock_memory() const { return lock_memory_; }
+
+ private:
+  std::unordered_map<std::string, ThreadPlacement> placements_;
+  bool lock_memory_ = false;
+};
+
+// Called on the component's own thread before it enters its loop. Failures (e.g. no
+// CAP_SYS_NICE for SCHED_FIFO) are reported on stderr and the thread carries on.
+bool apply_placement(std::string_view name, const ThreadPlacement& p);
+bool lock_all_memory();
+int numa_node_of_cpu(int cpu);
+
+// Page-aligned anonymous mapping bound (preferred) to `node` and pre-faulted, so no
+// page fault or remote allocation happens once trading starts. node -1 = local policy.
+void* alloc_on_node(std::size_t bytes, int node);
+void free_on_node(void* p, std::size_t bytes);
+
+template <typename T>
+std::shared_ptr<T> make_on_node(int node) {
+  void* mem = alloc_on_node(sizeof(T), node);
+  if (mem == nullptr) {
+    throw std::bad_alloc{};
+  }
+  return std::shared_ptr<T>(new (mem) T(), [](T* p) {
+    p->~T();
+    free_on_node(p, sizeof(T));
+  });
+}
+
+}  // namespace hft
@@ -1,35 +1,48 @@
 #include "trade_io.h"
 
-#include <chrono>
-#include <iomanip>
-#include <sstream>
-#include <thread>
+#include "binlog.h"
+#include "tsc.h"
 
 namespace hft {
 
-TradeIo::TradeIo(std::atomic<bool>& running, std::shared_ptr<OrderQueue> inbound, std::shared_ptr<LogQueue> log_queue)
-    : running_(running), inbound_(std::move(inbound)), log_queue_(std::move(log_queue)) {}
+TradeIo::TradeIo(std::atomic<bool>& running,
+                 const SymbolRegistry& symbols,
+                 std::shared_ptr<OrderQueue> inbound,
+                 std::shared_ptr<DoneQueue> done,
+                 std::shared_ptr<LogQueue> log_queue,
+                 WaitConfig wait)
+    : running_(running),
+      symbols_(symbols),
+      inbound_(std::move(inbound)),
+      done_(std::move(done)),
+      log_queue_(std::move(log_queue)),
+      wait_(wait),
+      ticks_per_ns_(tsc_ticks_per_ns()) {
+  inbound_->set_doorbell(wait_.doorbell());
+}
 
 void TradeIo::run() {
   while (running_.load(std::memory_order_acquire)) {
+    // Room for the order's done report is taken first, so no report is ever dropped:
+    // with none, the order waits in the queue until OmsRisk catches up.
+    OrderDone* done = done_->try_claim();
     OrderCommand cmd;
-    if (!inbound_->pop(cmd)) {
-      std::this_thread::sleep_for(std::chrono::microseconds(50));  // should be busy loop in production?
+    if (done == nullptr || !inbound_->pop(cmd)) {
+      wait_.idle([this] { return !inbound_->empty(); });
       continue;
     }
-    log("send " + cmd.symbol + " " + (cmd.buy ? "BUY" : "SELL") + " qty=" + fmt(cmd.qty) +
-        " px=" + fmt(cmd.price) + " seq=" + std::to_string(cmd.seq));
+    wait_.reset();
+    const std::uint64_t send_tsc = tsc_now();
+    HFT_LOG(*log_queue_, "send %s %s qty=%.2f px=%.2f seq=%lld", symbols_.name(cmd.symbol), cmd.buy ? "BUY" : "SELL",
+            cmd.qty, cmd.price, cmd.seq);
+    latency_.record(cmd.trace, send_tsc);
+    *done = OrderDone{cmd.symbol, cmd.buy, cmd.price, cmd.qty, 0.0, cmd.seq};
+    done_->commit();
   }
 }
 
-std::string TradeIo::fmt(double v) {
-  std::ostringstream oss;
-  oss << std::fixed << std::setprecision(2) << v;
-  return oss.str();
-}
-
-void TradeIo::log(const std::string& msg) {
-  log_queue_->push(LogEvent{"trade", msg, std::chrono::steady_clock::now()});
+void TradeIo::report_latency(LogQueue& log) {
+  latency_.dump_and_reset(log, ticks_per_ns_);
 }
 
 }  // namespace hft
@@ -2,25 +2,40 @@
 
 #include <atomic>
 #include <memory>
-#include <string>
 
+#include "latency.h"
 #include "types.h"
+#include "wait_strategy.h"
 
 namespace hft {
 
+// Sends orders and reports each one back to OmsRisk once it is finished. There is no
+// venue connection yet, so every order is reported done unfilled as soon as it is sent,
+// as an IOC that found nothing to trade against would be.
 class TradeIo {
  public:
-  TradeIo(std::atomic<bool>& running, std::shared_ptr<OrderQueue> inbound, std::shared_ptr<LogQueue> log_queue);
+  TradeIo(std::atomic<bool>& running,
+          const SymbolRegistry& symbols,
+          std::shared_ptr<OrderQueue> inbound,
+          std::shared_ptr<DoneQueue> done,
+          std::shared_ptr<LogQueue> log_queue,
+          WaitConfig wait = {});
 
   void run();
 
- private:
-  static std::string fmt(double v);
-  void log(const std::string& msg);
+  // Logs and clears the per-hop tick-to-trade histograms recorded since the last call.
+  // For one reader thread other than run()'s, so the send path never formats them.
+  void report_latency(LogQueue& log);
 
+ private:
   std::atomic<bool>& running_;
+  const SymbolRegistry& symbols_;
   std::shared_ptr<OrderQueue> inbound_;
+  std::shared_ptr<DoneQueue> done_;
   std::shared_ptr<LogQueue> log_queue_;
+  WaitStrategy wait_;
+  TickToTradeSwap latency_;
+  double ticks_per_ns_;
 };
 
 }  // namespace hft
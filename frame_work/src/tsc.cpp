@@ -0,0 +1,21 @@
+#include "tsc.h"
+
+#include <thread>
+
+namespace hft {
+
+double tsc_ticks_per_ns() {
+  static const double ratio = [] {
+    using Clock = std::chrono::steady_clock;
+    const auto t0 = Clock::now();
+    const std::uint64_t c0 = tsc_now();
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    const std::uint64_t c1 = tsc_now();
+    const auto t1 = Clock::now();
+    const double ns = std::chrono::duration<double, std::nano>(t1 - t0).count();
+    return ns > 0.0 && c1 > c0 ? static_cast<double>(c1 - c0) / ns : 1.0;
+  }();
+  return ratio;
+}
+
+}  // namespace hft
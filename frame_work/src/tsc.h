@@ -0,0 +1,41 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <limits>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace hft {
+
+// Cycle-counter stamps for tick-to-trade tracing. tsc_now() is a bare rdtsc (no fence,
+// no rdtscp): a few ns, monotonic and synchronised across cores on any invariant-TSC
+// part, and the few cycles of reordering it allows are noise next to a queue hop.
+inline std::uint64_t tsc_now() {
+#if defined(__x86_64__) || defined(__i386__)
+  return __rdtsc();
+#elif defined(__aarch64__)
+  std::uint64_t v;
+  asm volatile("mrs %0, cntvct_el0" : "=r"(v));
+  return v;
+#else
+  return static_cast<std::uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+          .count());
+#endif
+}
+
+// Ticks elapsed since base, saturated to 32 bits (~1.4 s at 3 GHz).
+inline std::uint32_t tsc_since(std::uint64_t base, std::uint64_t now) {
+  const std::uint64_t d = now >= base ? now - base : 0;
+  return d > std::numeric_limits<std::uint32_t>::max() ? std::numeric_limits<std::uint32_t>::max()
+                                                        : static_cast<std::uint32_t>(d);
+}
+
+// Counter ticks per nanosecond, measured once against steady_clock (~20 ms on the first
+// call, so make it from setup code rather than a hot thread).
+double tsc_ticks_per_ns();
+
+}  // namespace hft
@@ -1,47 +1,86 @@
 #pragma once
 
-#include <chrono>
 #include <cstdint>
 #include <memory>
-#include <string>
+#include <type_traits>
 
+#include "mpsc_queue.h"
 #include "spsc_queue.h"
+#include "symbol_registry.h"
 
 namespace hft {
 
+// All pipeline messages are trivially copyable and fixed-size so a queue slot holds
+// them inline and push/pop is a plain copy with no heap traffic.
+
+// Binary log record: format ID plus raw argument bytes, rendered later (see binlog.h).
 struct LogEvent {
-  std::string source;
-  std::string message;
-  std::chrono::steady_clock::time_point ts;
+  std::int64_t ts_ns{};  // steady_clock
+  std::uint16_t fmt{};
+  std::uint16_t len{};   // payload bytes used
+  std::uint8_t payload[116]{};
+};
+
+// Tick-to-trade trace (tsc.h). The feed stamp is absolute; each later stage stores its
+// offset from it in ticks, which keeps the trace to 24 bytes per message.
+struct TraceStamps {
+  std::uint64_t feed_recv{};
+  std::uint32_t strat_in{};
+  std::uint32_t strat_out{};
+  std::uint32_t oms_in{};
+  std::uint32_t oms_out{};
 };
 
 struct MarketEvent {
-  std::string symbol;
+  SymbolId symbol{};
   double bid{};
   double ask{};
   double size{};
   std::int64_t seq{};
+  std::uint64_t recv_tsc{};  // when the feed received the update
 };
 
 struct StrategyDecision {
-  std::string symbol;
+  SymbolId symbol{};
   bool buy{};
   double price{};
   double qty{};
   std::int64_t seq{}; // same seq num as in MarketEvent?
+  TraceStamps trace{};
 };
 
 struct OrderCommand { // same struct as above? merge?
-  std::string symbol;
+  SymbolId symbol{};
+  bool buy{};
+  double price{};
+  double qty{};
+  std::int64_t seq{};
+  TraceStamps trace{};
+};
+
+// TradeIo -> OmsRisk: an order is finished, filled of its qty having traded at price.
+// Lets the risk stage release what it reserved for the order.
+struct OrderDone {
+  SymbolId symbol{};
   bool buy{};
   double price{};
   double qty{};
+  double filled{};
   std::int64_t seq{};
 };
 
+static_assert(std::is_trivially_copyable_v<LogEvent>);
+static_assert(std::is_trivially_copyable_v<MarketEvent>);
+static_assert(std::is_trivially_copyable_v<StrategyDecision>);
+static_assert(std::is_trivially_copyable_v<OrderCommand>);
+static_assert(std::is_trivially_copyable_v<OrderDone>);
+
 using LogQueue = SpscQueue<LogEvent, 1024>;
 using MarketQueue = SpscQueue<MarketEvent, 1024>;
 using StrategyQueue = SpscQueue<StrategyDecision, 1024>;
 using OrderQueue = SpscQueue<OrderCommand, 1024>;
+using DoneQueue = SpscQueue<OrderDone, 1024>;
+// Fan-in from every strategy shard to OmsRisk, sized for a burst from all shards.
+using DecisionQueue = MpscQueue<StrategyDecision, 4096>;
 
 }  // namespace hft
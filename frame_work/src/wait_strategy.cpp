@@ -0,0 +1,51 @@
+#include "wait_strategy.h"
+
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <climits>
+#include <cstring>
+#include <ctime>
+
+namespace hft {
+
+namespace {
+
+long futex(std::atomic<std::uint32_t>* word, int op, std::uint32_t val, const timespec* timeout) {
+  return ::syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(word), op, val, timeout, nullptr, 0);
+}
+
+}  // namespace
+
+void Doorbell::wake() {
+  epoch_.fetch_add(1, std::memory_order_release);
+  futex(&epoch_, FUTEX_WAKE_PRIVATE, INT_MAX, nullptr);
+}
+
+void WaitStrategy::park(std::uint32_t epoch) {
+  const timespec timeout{static_cast<time_t>(cfg_.park_timeout_us / 1'000'000),
+                         static_cast<long>(cfg_.park_timeout_us % 1'000'000) * 1000};
+  futex(&doorbell_.epoch_, FUTEX_WAIT_PRIVATE, epoch, &timeout);
+}
+
+const char* to_string(WaitKind kind) {
+  switch (kind) {
+    case WaitKind::BusySpin: return "spin";
+    case WaitKind::SpinYield: return "yield";
+    case WaitKind::SpinPark: return "park";
+  }
+  return "?";
+}
+
+bool parse_wait_kind(const char* s, WaitKind& out) {
+  for (auto kind : {WaitKind::BusySpin, WaitKind::SpinYield, WaitKind::SpinPark}) {
+    if (std::strcmp(s, to_string(kind)) == 0) {
+      out = kind;
+      return true;
+    }
+  }
+  return false;
+}
+
+}  // namespace hft
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+namespace hft {
+
+inline void cpu_relax() {
+#if defined(__x86_64__) || defined(__i386__)
+  _mm_pause();
+#elif defined(__aarch64__)
+  asm volatile("yield");
+#endif
+}
+
+// Futex word a producer rings after publishing into a queue whose consumer may be
+// parked. The ring is a fence plus one load unless the consumer is actually asleep.
+class Doorbell {
+ public:
+  void ring() {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (waiting_.load(std::memory_order_relaxed)) {
+      wake();
+    }
+  }
+
+ private:
+  friend class WaitStrategy;
+
+  void wake();
+
+  alignas(64) std::atomic<std::uint32_t> epoch_{0};
+  std::atomic<bool> waiting_{false};
+};
+
+enum class WaitKind : std::uint8_t {
+  BusySpin,   // pause and poll forever: lowest latency, burns the core
+  SpinYield,  // pause for a while, then sched_yield between polls
+  SpinPark,   // pause, then sleep on a futex until a producer rings the doorbell
+};
+
+struct WaitConfig {
+  WaitKind kind = WaitKind::SpinYield;
+  std::uint32_t spin_limit = 4096;  // idle polls before yielding/parking
+  std::uint32_t park_timeout_us = 1000;  // bound on a park so shutdown is noticed
+};
+
+// Consumer-side idle policy. A component calls idle() each time a poll found no work
+// and reset() once it makes progress. For SpinPark the component's input queues must
+// ring doorbell() (see SpscQueue::set_doorbell) or parks only end on the timeout.
+class WaitStrategy {
+ public:
+  explicit WaitStrategy(WaitConfig cfg = {}) : cfg_(cfg) {}
+
+  WaitStrategy(const WaitStrategy&) = delete;
+  WaitStrategy& operator=(const WaitStrategy&) = delete;
+
+  // `has_work` re-checks the inputs after the consumer announces it is about to park,
+  // so a push racing with the park is never missed.
+  template <typename HasWork>
+  void idle(HasWork&& has_work) {
+    if (cfg_.kind == WaitKind::BusySpin || idle_polls_ < cfg_.spin_limit) {
+      ++idle_polls_;
+      cpu_relax();
+      return;
+    }
+    if (cfg_.kind == WaitKind::SpinYield) {
+      std::this_thread::yield();
+      return;
+    }
+    doorbell_.waiting_.store(true, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    const std::uint32_t epoch = doorbell_.epoch_.load(std::memory_order_acquire);
+    if (!has_work()) {
+      park(epoch);
+    }
+    doorbell_.waiting_.store(false, std::memory_order_relaxed);
+  }
+
+  void reset() { idle_polls_ = 0; }
+
+  // Doorbell for producers to ring, or nullptr when this policy never parks.
+  Doorbell* doorbell() { return cfg_.kind == WaitKind::SpinPark ? &doorbell_ : nullptr; }
+  WaitKind kind() const { return cfg_.kind; }
+
+ private:
+  void park(std::uint32_t epoch);
+
+  WaitConfig cfg_;
+  std::uint32_t idle_polls_{0};
+  Doorbell doorbell_;
+};
+
+const char* to_string(WaitKind kind);
+bool parse_wait_kind(const char* s, WaitKind& out);
+
+}  // namespace hft
@@ -0,0 +1,126 @@
+// Local stand-in for Binance's depth endpoints. It replays a captured session so the
+// connector's snapshot bootstrap, gap detection and resync run offline:
+//
+//   depth_standin capture.txt [port] [interval_ms]
+//   hft_demo --binance BTCUSDT --binance-endpoint 127.0.0.1:PORT
+//
+// capture.txt holds one frame per line ('#' lines are skipped):
+//   snapshot <body of GET /api/v3/depth>
+//   diff <depthUpdate WebSocket frame>
+// The n-th snapshot request gets the n-th snapshot (the last one repeats). Every
+// WebSocket connection gets all diffs in order, interval_ms apart (default 100), then
+// a close. A hole in the diffs' U/u sequence followed by a newer snapshot exercises
+// the resync path.
+
+#include <algorithm>
+#include <atomic>
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/beast/core.hpp>
+#include <boost/beast/http.hpp>
+#include <boost/beast/websocket.hpp>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+namespace beast = boost::beast;
+namespace http = beast::http;
+namespace websocket = beast::websocket;
+using tcp = boost::asio::ip::tcp;
+
+struct Capture {
+  std::vector<std::string> snapshots;
+  std::vector<std::string> diffs;
+};
+
+bool load_capture(const std::string& path, Capture& cap) {
+  std::ifstream in(path);
+  if (!in) {
+    std::cerr << "cannot open " << path << "\n";
+    return false;
+  }
+  std::string line;
+  int lineno = 0;
+  while (std::getline(in, line)) {
+    ++lineno;
+    if (line.empty() || line[0] == '#') {
+      continue;
+    }
+    const auto space = line.find(' ');
+    const std::string kind = line.substr(0, space);
+    if (space == std::string::npos || (kind != "snapshot" && kind != "diff")) {
+      std::cerr << path << ":" << lineno << ": expected 'snapshot <json>' or 'diff <json>'\n";
+      return false;
+    }
+    (kind == "snapshot" ? cap.snapshots : cap.diffs).push_back(line.substr(space + 1));
+  }
+  return true;
+}
+
+void serve(tcp::socket sock, const Capture& cap, std::atomic<std::size_t>& snapshot_requests,
+           std::chrono::milliseconds interval) {
+  try {
+    beast::flat_buffer buffer;
+    http::request<http::string_body> req;
+    http::read(sock, buffer, req);
+
+    if (websocket::is_upgrade(req)) {
+      websocket::stream<tcp::socket> ws{std::move(sock)};
+      ws.accept(req);
+      ws.text(true);
+      std::cerr << "stream " << req.target() << ": " << cap.diffs.size() << " diffs\n";
+      for (const auto& diff : cap.diffs) {
+        ws.write(boost::asio::buffer(diff));
+        std::this_thread::sleep_for(interval);
+      }
+      ws.close(websocket::close_code::normal);
+      return;
+    }
+
+    const auto n = snapshot_requests.fetch_add(1);
+    http::response<http::string_body> res{http::status::ok, req.version()};
+    res.set(http::field::content_type, "application/json");
+    if (cap.snapshots.empty()) {
+      res.result(http::status::not_found);
+    } else {
+      res.body() = cap.snapshots[std::min(n, cap.snapshots.size() - 1)];
+    }
+    res.prepare_payload();
+    http::write(sock, res);
+    std::cerr << "snapshot #" << n << " " << req.target() << "\n";
+    beast::error_code ec;
+    sock.shutdown(tcp::socket::shutdown_send, ec);
+  } catch (const std::exception& ex) {
+    std::cerr << "connection: " << ex.what() << "\n";
+  }
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  if (argc < 2) {
+    std::cerr << "usage: depth_standin capture.txt [port] [interval_ms]\n";
+    return 1;
+  }
+  Capture cap;
+  if (!load_capture(argv[1], cap)) {
+    return 1;
+  }
+  const auto port = static_cast<unsigned short>(argc > 2 ? std::stoi(argv[2]) : 9443);
+  const std::chrono::milliseconds interval{argc > 3 ? std::stoi(argv[3]) : 100};
+
+  boost::asio::io_context ioc;
+  tcp::acceptor acceptor{ioc, {boost::asio::ip::make_address("127.0.0.1"), port}};
+  std::cerr << "serving " << cap.snapshots.size() << " snapshots, " << cap.diffs.size() << " diffs on 127.0.0.1:"
+            << port << "\n";
+  std::atomic<std::size_t> snapshot_requests{0};
+  for (;;) {
+    tcp::socket sock{ioc};
+    acceptor.accept(sock);
+    std::thread(serve, std::move(sock), std::cref(cap), std::ref(snapshot_requests), interval).detach();
+  }
+}
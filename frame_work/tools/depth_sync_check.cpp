@@ -0,0 +1,161 @@
+// Replays a scripted depth capture through DepthParser + DepthSync and checks the
+// outcome of each frame against the expectations written next to it:
+//
+//   depth_sync_check [fixture]
+//
+// The default fixture, tools/fixtures/depth_sync.txt, covers the snapshot bootstrap, a
+// snapshot older than the buffered diffs, a U/u gap, `pu` continuity and a buffer
+// overflow; its header describes the directives. Exits non-zero on the first frame
+// that fails to parse and after reporting every failed expectation.
+
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+
+#include "depth_parser.h"
+#include "depth_sync.h"
+#include "order_book.h"
+
+#ifndef DEPTH_SYNC_FIXTURE
+#define DEPTH_SYNC_FIXTURE "tools/fixtures/depth_sync.txt"
+#endif
+
+namespace {
+
+struct Scenario {
+  std::string name;
+  std::unique_ptr<hft::OrderBook> book;
+  std::unique_ptr<hft::DepthSync> sync;
+};
+
+const char* to_string(hft::DepthSync::Status s) {
+  switch (s) {
+    case hft::DepthSync::Status::Buffered:
+      return "buffered";
+    case hft::DepthSync::Status::Applied:
+      return "applied";
+    case hft::DepthSync::Status::Stale:
+      return "stale";
+    case hft::DepthSync::Status::Gap:
+      return "gap";
+    case hft::DepthSync::Status::Overflow:
+      return "overflow";
+  }
+  return "?";
+}
+
+// One `key=value` of an expect line against the current state; empty when it holds.
+std::string check_key(const Scenario& sc, const std::string& key, const std::string& value) {
+  const auto best = sc.book->best();
+  std::string actual;
+  bool ok = false;
+  if (key == "last") {
+    actual = std::to_string(sc.sync->last_update_id());
+    ok = actual == value;
+  } else if (key == "live") {
+    actual = sc.sync->live() ? "1" : "0";
+    ok = actual == value;
+  } else if (key == "gaps") {
+    actual = std::to_string(sc.sync->gaps());
+    ok = actual == value;
+  } else if (key == "bid" || key == "ask") {
+    const double px = !best ? 0.0 : key == "bid" ? best->bid : best->ask;
+    actual = std::to_string(px);
+    ok = std::fabs(px - std::stod(value)) < 1e-9;
+  } else {
+    return "unknown key " + key;
+  }
+  return ok ? std::string() : key + "=" + actual + ", expected " + value;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  const std::string path = argc > 1 ? argv[1] : DEPTH_SYNC_FIXTURE;
+  std::ifstream in(path);
+  if (!in) {
+    std::cerr << "cannot open " << path << "\n";
+    return 1;
+  }
+
+  hft::DepthParser parser;
+  Scenario sc;
+  std::string result;  // outcome of the last frame, for the expect line after it
+  std::size_t checks = 0;
+  std::size_t failures = 0;
+  std::string line;
+  int lineno = 0;
+  while (std::getline(in, line)) {
+    ++lineno;
+    const auto where = [&] { return path + ":" + std::to_string(lineno) + ": "; };
+    std::istringstream words(line);
+    std::string word;
+    words >> word;
+    if (word == "#") {
+      words >> word;
+      if (word == "scenario") {
+        std::size_t max_updates = 1024;
+        words >> sc.name;
+        for (std::string opt; words >> opt;) {
+          if (opt.rfind("max_updates=", 0) == 0) {
+            max_updates = std::stoul(opt.substr(12));
+          }
+        }
+        sc.book = std::make_unique<hft::OrderBook>();
+        sc.sync = std::make_unique<hft::DepthSync>(*sc.book, max_updates);
+        result.clear();
+      } else if (word == "expect") {
+        std::string expected;
+        words >> expected;
+        ++checks;
+        std::string failure;
+        if (expected != result) {
+          failure = "got " + (result.empty() ? std::string("no frame") : result) + ", expected " + expected;
+        }
+        for (std::string kv; failure.empty() && words >> kv;) {
+          const auto eq = kv.find('=');
+          failure = eq == std::string::npos ? "malformed " + kv : check_key(sc, kv.substr(0, eq), kv.substr(eq + 1));
+        }
+        if (!failure.empty()) {
+          ++failures;
+          std::cerr << where() << "[" << sc.name << "] " << failure << "\n";
+        }
+      }
+      continue;
+    }
+    if (word.empty() || word[0] == '#') {
+      continue;
+    }
+    if (!sc.sync) {
+      std::cerr << where() << "frame before the first '# scenario'\n";
+      return 1;
+    }
+    const std::string json = line.substr(word.size() + 1);
+    if (word == "diff") {
+      hft::DepthUpdate u;
+      if (!parser.parse_update(json, u)) {
+        std::cerr << where() << "diff does not parse\n";
+        return 1;
+      }
+      result = to_string(sc.sync->on_update(u));
+    } else if (word == "snapshot") {
+      hft::DepthSnapshot s;
+      if (!parser.parse_snapshot(json, s)) {
+        std::cerr << where() << "snapshot does not parse\n";
+        return 1;
+      }
+      result = sc.sync->on_snapshot(s) ? "synced" : "refused";
+    } else {
+      std::cerr << where() << "expected 'snapshot <json>' or 'diff <json>'\n";
+      return 1;
+    }
+  }
+
+  std::cout << checks - failures << "/" << checks << " DepthSync checks passed\n";
+  return failures == 0 && checks > 0 ? 0 : 1;
+}
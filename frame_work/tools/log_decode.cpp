@@ -0,0 +1,141 @@
+// Renders a binary log written by `hft_demo --log-binary --log-file PATH` as the same
+// "[source] +Nms text" lines the logger prints in text mode.
+//
+//   log_decode run.binlog [--ns]
+//
+// --ns prints absolute steady_clock nanoseconds instead of milliseconds since start.
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "binlog.h"
+
+namespace {
+
+struct Format {
+  std::string fmt;
+  std::vector<hft::LogArgType> types;
+};
+
+class Reader {
+ public:
+  explicit Reader(const std::vector<char>& buf) : p_(buf.data()), end_(buf.data() + buf.size()) {}
+
+  bool done() const { return p_ == end_; }
+
+  template <typename T>
+  bool read(T& v) {
+    if (static_cast<std::size_t>(end_ - p_) < sizeof(T)) {
+      return false;
+    }
+    std::memcpy(&v, p_, sizeof(T));
+    p_ += sizeof(T);
+    return true;
+  }
+
+  bool bytes(std::size_t n, const char*& out) {
+    if (static_cast<std::size_t>(end_ - p_) < n) {
+      return false;
+    }
+    out = p_;
+    p_ += n;
+    return true;
+  }
+
+ private:
+  const char* p_;
+  const char* end_;
+};
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  if (argc < 2) {
+    std::cerr << "usage: " << argv[0] << " FILE [--ns]\n";
+    return 1;
+  }
+  const bool abs_ns = argc > 2 && std::string(argv[2]) == "--ns";
+
+  std::ifstream in(argv[1], std::ios::binary);
+  if (!in) {
+    perror(argv[1]);
+    return 1;
+  }
+  const std::vector<char> buf((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+  Reader r(buf);
+
+  const char* magic = nullptr;
+  std::int64_t start_ns = 0;
+  if (!r.bytes(sizeof(hft::kLogFileMagic), magic) || std::memcmp(magic, hft::kLogFileMagic, sizeof(hft::kLogFileMagic)) != 0 ||
+      !r.read(start_ns)) {
+    std::cerr << argv[1] << ": not a binary log\n";
+    return 1;
+  }
+
+  std::unordered_map<std::uint16_t, Format> formats;
+  std::unordered_map<std::uint16_t, std::string> sources;
+  char text[1024];
+  std::size_t events = 0;
+  while (!r.done()) {
+    std::uint8_t kind = 0;
+    r.read(kind);
+    bool ok = false;
+    if (kind == hft::kLogRecFormat) {
+      std::uint16_t id = 0;
+      std::uint8_t nargs = 0;
+      const char* types = nullptr;
+      std::uint16_t len = 0;
+      const char* fmt = nullptr;
+      ok = r.read(id) && r.read(nargs) && r.bytes(nargs, types) && r.read(len) && r.bytes(len, fmt);
+      if (ok) {
+        Format& f = formats[id];
+        f.fmt.assign(fmt, len);
+        f.types.resize(nargs);
+        std::memcpy(f.types.data(), types, nargs);
+      }
+    } else if (kind == hft::kLogRecSource) {
+      std::uint16_t source = 0;
+      std::uint16_t len = 0;
+      const char* name = nullptr;
+      ok = r.read(source) && r.read(len) && r.bytes(len, name);
+      if (ok) {
+        sources[source].assign(name, len);
+      }
+    } else if (kind == hft::kLogRecEvent) {
+      std::uint16_t source = 0;
+      std::int64_t ts_ns = 0;
+      std::uint16_t fmt = 0;
+      std::uint16_t len = 0;
+      const char* payload = nullptr;
+      ok = r.read(source) && r.read(ts_ns) && r.read(fmt) && r.read(len) && r.bytes(len, payload);
+      if (ok) {
+        const auto f = formats.find(fmt);
+        if (f == formats.end()) {
+          std::snprintf(text, sizeof(text), "<unknown format %u>", fmt);
+        } else {
+          hft::render_log_text(f->second.fmt.c_str(), f->second.types,
+                               reinterpret_cast<const std::uint8_t*>(payload), len, text, sizeof(text));
+        }
+        if (abs_ns) {
+          std::printf("[%s] %lld %s\n", sources[source].c_str(), static_cast<long long>(ts_ns), text);
+        } else {
+          std::printf("[%s] +%lldms %s\n", sources[source].c_str(), static_cast<long long>((ts_ns - start_ns) / 1'000'000),
+                      text);
+        }
+        ++events;
+      }
+    }
+    if (!ok) {
+      std::cerr << argv[1] << ": truncated or corrupt record after " << events << " events\n";
+      return 1;
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,77 @@
+// Offline shard planner: reads per-symbol event rates (hft_demo --rates-out) and writes
+// a shard map for hft_demo --shard-map that spreads the load across N shards.
+//
+//   shard_rebalance rates.txt 4 > shards.map
+//
+// Per-shard load before (hash placement) and after is reported on stderr.
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "shard_map.h"
+
+namespace {
+
+void report(const char* label, const std::vector<hft::SymbolRate>& rates, const std::vector<std::size_t>& shard_of,
+            std::size_t shard_count) {
+  std::vector<double> load(shard_count, 0.0);
+  double total = 0.0;
+  for (std::size_t i = 0; i < rates.size(); ++i) {
+    load[shard_of[i]] += rates[i].events_per_sec;
+    total += rates[i].events_per_sec;
+  }
+  const double max_load = *std::max_element(load.begin(), load.end());
+  const double mean = total / static_cast<double>(shard_count);
+  std::cerr << label << ": max shard " << max_load << " ev/s, mean " << mean << " ev/s, imbalance "
+            << (mean > 0 ? max_load / mean : 0.0) << "x\n";
+  for (std::size_t s = 0; s < shard_count; ++s) {
+    std::cerr << "  shard " << s << ": " << load[s] << " ev/s\n";
+  }
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  if (argc < 3) {
+    std::cerr << "usage: " << argv[0] << " RATES_FILE SHARDS\n";
+    return 1;
+  }
+  const std::size_t shard_count = std::strtoul(argv[2], nullptr, 10);
+  if (shard_count == 0 || shard_count > 256) {
+    std::cerr << "SHARDS must be in 1..256\n";
+    return 1;
+  }
+  std::vector<hft::SymbolRate> rates;
+  if (!hft::read_symbol_rates(argv[1], rates)) {
+    return 1;
+  }
+  if (rates.empty()) {
+    std::cerr << argv[1] << ": no symbols\n";
+    return 1;
+  }
+
+  // What the feed would do without a map: resolve() on an empty ShardMap hashes names.
+  hft::SymbolRegistry symbols;
+  for (const auto& r : rates) {
+    symbols.intern(r.symbol);
+  }
+  hft::ShardMap hashed(shard_count);
+  hashed.resolve(symbols);
+  std::vector<std::size_t> before(rates.size());
+  for (std::size_t i = 0; i < rates.size(); ++i) {
+    before[i] = hashed.shard(*symbols.find(rates[i].symbol));
+  }
+
+  const auto after = hft::balance_shards(rates, shard_count);
+  report("hashed", rates, before, shard_count);
+  report("balanced", rates, after, shard_count);
+
+  std::cout << "# generated by shard_rebalance from " << argv[1] << " for " << shard_count << " shards\n";
+  for (std::size_t i = 0; i < rates.size(); ++i) {
+    std::cout << rates[i].symbol << " " << after[i] << "\n";
+  }
+  return 0;
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <pthread.h>
+#include <sched.h>
+
+#include <charconv>
+#include <string_view>
+#include <vector>
+
+namespace hft {
+
+// "2,3,5" -> {2, 3, 5}. False on anything but comma-separated non-negative integers.
+inline bool parse_cpu_list(std::string_view s, std::vector<int>& out) {
+    out.clear();
+    while (!s.empty()) {
+        const size_t comma = s.find(',');
+        const std::string_view item = s.substr(0, comma);
+        int cpu = -1;
+        const auto [end, ec] = std::from_chars(item.data(), item.data() + item.size(), cpu);
+        if (ec != std::errc{} || end != item.data() + item.size() || cpu < 0 || cpu >= CPU_SETSIZE) return false;
+        out.push_back(cpu);
+        if (comma == std::string_view::npos) break;
+        s.remove_prefix(comma + 1);
+    }
+    return !out.empty();
+}
+
+// Pins the calling thread to one CPU. A negative cpu leaves it where it is.
+inline bool pin_current_thread(int cpu) {
+    if (cpu < 0) return true;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+}
+
+}  // namespace hft
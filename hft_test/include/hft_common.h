@@ -3,12 +3,9 @@
 #include <algorithm>
 #include <atomic>
 #include <chrono>
-#include <cmath>
+#include <array>
 #include <cstdint>
-#include <functional>
-#include <string>
-#include <unordered_map>
-#include <vector>
+#include <span>
 
 namespace hft {
 
@@ -21,9 +18,10 @@ inline int64_t now_ns() {
 }
 
 enum class Side : uint8_t { Buy = 0, Sell = 1 };
-enum class OrderType : uint8_t { Limit = 0 };
-enum class TimeInForce : uint8_t { GTC = 0 };
-enum class ExecType : uint8_t { Ack = 0, Fill = 1, PartialFill = 2, Reject = 3, Cancel = 4 };
+enum class OrderType : uint8_t { Limit = 0, Market = 1 };
+enum class TimeInForce : uint8_t { GTC = 0, IOC = 1 };
+enum class ExecType : uint8_t { Ack = 0, Fill = 1, PartialFill = 2, Reject = 3, Cancel = 4, Replaced = 5, CancelReject = 6 };
+enum class OrderAction : uint8_t { New = 0, Cancel = 1, Replace = 2 };
 
 struct LevelDelta {
     Side side{};
@@ -31,123 +29,78 @@ struct LevelDelta {
     int64_t qty = 0;  // size in base units
 };
 
+// Most levels one book update carries; a feed message with more is split.
+constexpr size_t kMaxDeltaLevels = 16;
+
+// One book update, held inline so it is copied and queued without allocating.
 struct BookDelta {
     uint64_t md_event_id = 0;
-    std::string symbol;
-    std::vector<LevelDelta> levels;
+    uint32_t symbol_id = 0;
+    uint32_t level_count = 0;
     uint64_t exch_update_id_begin = 0;
     uint64_t exch_update_id_end = 0;
+    int64_t event_time_ns = 0;  // exchange event time; 0 when unknown
+    std::array<LevelDelta, kMaxDeltaLevels> levels{};
+
+    bool add(const LevelDelta& lvl) {
+        if (level_count == kMaxDeltaLevels) return false;
+        levels[level_count++] = lvl;
+        return true;
+    }
+    std::span<const LevelDelta> view() const { return {levels.data(), level_count}; }
 };
 
 struct OrderRequest {
-    uint64_t req_id = 0;
+    OrderAction action = OrderAction::New;
+    uint64_t cl_ord_id = 0;  // chosen by the strategy; Cancel/Replace name the order
     uint64_t md_event_id = 0;
+    uint32_t symbol_id = 0;
     Side side{};
     int64_t px = 0;
-    int64_t qty = 0;
+    int64_t qty = 0;  // total, filled included (New, Replace)
     OrderType type = OrderType::Limit;
     TimeInForce tif = TimeInForce::GTC;
     double signal_z = 0.0;
+    int64_t ts_md_recv_ns = 0;  // Thread A took the book update behind this request
+    int64_t ts_send_ns = 0;     // pushed to the OMS
 };
 
 struct ExecUpdate {
     uint64_t cl_ord_id = 0;
     uint64_t md_event_id = 0;
+    uint32_t symbol_id = 0;
     ExecType exec_type = ExecType::Ack;
     int64_t fill_px = 0;
     int64_t fill_qty = 0;
+    int64_t leaves_qty = 0;
     int64_t ts_oms_recv_ns = 0;
+    int64_t ts_md_recv_ns = 0;  // Ack: the order's ts_md_recv_ns, for tick-to-ack
 };
 
+// OMS view of an order. At most one cancel/replace is in flight per order:
+//
+//   PendingNew --Ack--> Live --PartialFill--> PartiallyFilled
+//   Live/PartiallyFilled --cancel sent--> PendingCancel --Cancel--> Done
+//                        --replace sent--> PendingReplace --Replaced--> Live/PartiallyFilled
+//   Pending* --CancelReject--> Live/PartiallyFilled;  any --Fill/Reject--> Done
+enum class OrdStatus : uint8_t { PendingNew, Live, PartiallyFilled, PendingCancel, PendingReplace, Done };
+
 struct OrderState {
     uint64_t md_event_id = 0;
+    uint32_t symbol_id = 0;
     Side side{};
     int64_t px = 0;
     int64_t qty = 0;
-    ExecType state = ExecType::Ack;
+    OrdStatus status = OrdStatus::PendingNew;
     int64_t filled = 0;
-};
-
-struct RollingStats {
-    // Welford incremental mean/std
-    uint64_t n = 0;
-    double mean = 0.0;
-    double m2 = 0.0;
-
-    void add(double x) {
-        ++n;
-        double delta = x - mean;
-        mean += delta / static_cast<double>(n);
-        double delta2 = x - mean;
-        m2 += delta * delta2;
-    }
-
-    [[nodiscard]] double stddev() const {
-        if (n < 2) return 0.0;
-        return std::sqrt(m2 / static_cast<double>(n - 1));
-    }
-};
-
-class ScopedTimer {
-public:
-    using Sink = std::function<void(const std::string&, int64_t)>;
-
-    ScopedTimer(const std::string& name, Sink sink)
-        : name_(name), sink_(std::move(sink)), begin_(Clock::now()) {}
-
-    ~ScopedTimer() {
-        if (sink_) {
-            auto dur = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - begin_).count();
-            sink_(name_, dur);
-        }
-    }
-
-private:
-    std::string name_;
-    Sink sink_;
-    TimePoint begin_;
-};
-
-class Telemetry {
-public:
-    void record(const std::string& name, int64_t ns) {
-        auto& bucket = buckets_[name];
-        bucket.samples.push_back(ns);
-    }
-
-    std::string summary() const {
-        std::string out;
-        for (auto& [name, bucket] : buckets_) {
-            if (bucket.samples.empty()) continue;
-            auto stats = percentiles(bucket.samples);
-            out += name + ": p50=" + std::to_string(stats.p50) + "us p90=" + std::to_string(stats.p90) +
-                   "us p99=" + std::to_string(stats.p99) + "us\n";
-        }
-        return out;
-    }
-
-private:
-    struct Bucket {
-        std::vector<int64_t> samples;
-    };
-
-    struct Percentiles {
-        double p50 = 0;
-        double p90 = 0;
-        double p99 = 0;
-    };
-
-    static Percentiles percentiles(std::vector<int64_t> v) {
-        if (v.empty()) return {};
-        std::sort(v.begin(), v.end());
-        auto pick = [&](double frac) {
-            size_t idx = static_cast<size_t>(frac * (v.size() - 1));
-            return static_cast<double>(v[idx]) / 1000.0;  // ns -> us
-        };
-        return {pick(0.50), pick(0.90), pick(0.99)};
-    }
-
-    std::unordered_map<std::string, Bucket> buckets_;
+    int64_t sent_ns = 0;  // framed for SimEx
+    int64_t md_recv_ns = 0;
+    // Cancel/replace asked for while a request was in flight; sent once it resolves.
+    // A later ask overwrites an earlier one, so a fast-moving quote costs one message.
+    OrderAction queued = OrderAction::New;  // New: nothing queued
+    int64_t queued_px = 0;
+    int64_t queued_qty = 0;
+    bool deferred = false;  // waiting for send room to send what is queued
 };
 
 }  // namespace hft
@@ -0,0 +1,214 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <string_view>
+#include <vector>
+
+#include "hft_common.h"
+
+namespace hft {
+
+// When feed messages arrive. Poisson spaces them independently; Hawkes makes every
+// message raise the chance of another for a while, so they come in bursts.
+enum class Arrivals : uint8_t { Poisson, Hawkes };
+
+inline bool parse_arrivals(std::string_view s, Arrivals& out) {
+    if (s == "poisson") {
+        out = Arrivals::Poisson;
+    } else if (s == "hawkes") {
+        out = Arrivals::Hawkes;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+struct FeedConfig {
+    int64_t start_px = 28'000'000;
+    int64_t tick = 10;
+    uint32_t depth = 10;             // levels kept per side
+    uint32_t max_spread_ticks = 5;
+    uint32_t max_changes = 3;        // level changes per message, 1..max_changes
+    double modify_weight = 0.7;      // new size for a level, skewed toward the top
+    double insert_weight = 0.15;     // new best level inside the spread
+    double delete_weight = 0.15;     // best level cleared
+    int64_t max_qty = 100;
+    double rate = 0.0;               // messages/s; 0 leaves them unscheduled
+    Arrivals arrivals = Arrivals::Poisson;
+    double hawkes_branching = 0.7;   // messages each message triggers on average, < 1
+    double hawkes_decay = 3.0;       // decay rate of the excitation, in multiples of rate
+};
+
+// Synthetic depth feed shaped like Binance's diff stream, over symbols
+// [first_symbol, first_symbol + count). Each symbol keeps depth levels a side on a
+// one-tick grid from its best bid and ask. It is first sent as a snapshot, split into
+// BookDeltas of at most kMaxDeltaLevels, then as diffs of 1..max_changes changes:
+//
+//   modify  a level gets a new size;
+//   insert  a new best level one tick inside the spread; the deepest level drops out;
+//   delete  the best level is cleared; a new deepest level appears.
+//
+// Inserts and deletes move the top, so the mid walks. Each diff has an event time from
+// the arrival process at the configured rate, measured from the first diff; snapshot
+// messages have event time 0, as do diffs when rate is 0.
+class MarketDataGenerator {
+public:
+    MarketDataGenerator(const FeedConfig& cfg, uint32_t first_symbol, uint32_t count, uint32_t seed)
+        : cfg_(normalized(cfg)),
+          first_symbol_(first_symbol),
+          count_(count),
+          best_(static_cast<size_t>(count) * 2),
+          qty_(static_cast<size_t>(count) * 2 * cfg_.depth),
+          rng_(seed),
+          pick_symbol_(0, count - 1),
+          pick_changes_(1, cfg_.max_changes),
+          pick_qty_(1, cfg_.max_qty),
+          pick_depth_(0.3) {
+        const double total = cfg_.modify_weight + cfg_.insert_weight + cfg_.delete_weight;
+        insert_below_ = cfg_.insert_weight / total;
+        delete_below_ = insert_below_ + cfg_.delete_weight / total;
+        base_rate_ = cfg_.arrivals == Arrivals::Hawkes ? cfg_.rate * (1.0 - cfg_.hawkes_branching) : cfg_.rate;
+        decay_per_s_ = cfg_.hawkes_decay * cfg_.rate;
+        for (uint32_t s = 0; s < count_; ++s) {
+            best_[s * 2] = cfg_.start_px - cfg_.tick;
+            best_[s * 2 + 1] = cfg_.start_px + cfg_.tick;
+            for (uint32_t k = 0; k < cfg_.depth * 2; ++k) qty_[s * 2 * cfg_.depth + k] = pick_qty_(rng_);
+        }
+    }
+
+    BookDelta next(uint64_t md_event_id) {
+        BookDelta delta;
+        delta.md_event_id = md_event_id;
+        delta.exch_update_id_begin = ++update_id_;
+        delta.exch_update_id_end = update_id_;
+        if (snapshot_symbol_ < count_) {
+            next_snapshot(delta);
+            return delta;
+        }
+        const uint32_t s = pick_symbol_(rng_);
+        delta.symbol_id = first_symbol_ + s;
+        delta.event_time_ns = next_arrival_ns();
+        const uint32_t changes = pick_changes_(rng_);
+        for (uint32_t c = 0; c < changes; ++c) change(s, delta);
+        return delta;
+    }
+
+private:
+    static constexpr size_t kBid = 0;
+    static constexpr size_t kAsk = 1;
+
+    static FeedConfig normalized(FeedConfig cfg) {
+        cfg.depth = std::max(cfg.depth, 1u);
+        cfg.max_spread_ticks = std::max(cfg.max_spread_ticks, 1u);
+        cfg.max_changes = std::clamp<uint32_t>(cfg.max_changes, 1, kMaxDeltaLevels / 2);  // two levels each
+        cfg.max_qty = std::max<int64_t>(cfg.max_qty, 1);
+        cfg.hawkes_branching = std::clamp(cfg.hawkes_branching, 0.0, 0.99);
+        return cfg;
+    }
+
+    double uniform() { return std::uniform_real_distribution<double>(0.0, 1.0)(rng_); }
+
+    // Price of level k: away from the top by k ticks.
+    int64_t level_px(uint32_t s, size_t side, uint32_t k) const {
+        const int64_t away = static_cast<int64_t>(k) * cfg_.tick;
+        return side == kBid ? best_[s * 2] - away : best_[s * 2 + 1] + away;
+    }
+    int64_t* levels(uint32_t s, size_t side) { return &qty_[(static_cast<size_t>(s) * 2 + side) * cfg_.depth]; }
+    static Side to_side(size_t side) { return side == kBid ? Side::Buy : Side::Sell; }
+
+    void next_snapshot(BookDelta& delta) {
+        const uint32_t s = snapshot_symbol_;
+        delta.symbol_id = first_symbol_ + s;
+        while (snapshot_level_ < cfg_.depth * 2 && delta.level_count < kMaxDeltaLevels) {
+            const size_t side = snapshot_level_ / cfg_.depth;
+            const uint32_t k = snapshot_level_ % cfg_.depth;
+            delta.add(LevelDelta{to_side(side), level_px(s, side, k), levels(s, side)[k]});
+            ++snapshot_level_;
+        }
+        if (snapshot_level_ == cfg_.depth * 2) {
+            ++snapshot_symbol_;
+            snapshot_level_ = 0;
+        }
+    }
+
+    void change(uint32_t s, BookDelta& delta) {
+        const size_t side = uniform() < 0.5 ? kBid : kAsk;
+        const int64_t spread_ticks = (best_[s * 2 + 1] - best_[s * 2]) / cfg_.tick;
+        const auto max_spread_ticks = static_cast<int64_t>(cfg_.max_spread_ticks);
+        const double op = uniform();
+        if (op < insert_below_ && spread_ticks > 1) {
+            insert_best(s, side, delta);
+        } else if (op >= insert_below_ && op < delete_below_ && spread_ticks < max_spread_ticks) {
+            delete_best(s, side, delta);
+        } else {
+            const uint32_t k = std::min(pick_depth_(rng_), cfg_.depth - 1);
+            const int64_t qty = pick_qty_(rng_);
+            levels(s, side)[k] = qty;
+            delta.add(LevelDelta{to_side(side), level_px(s, side, k), qty});
+        }
+    }
+
+    void insert_best(uint32_t s, size_t side, BookDelta& delta) {
+        int64_t* q = levels(s, side);
+        delta.add(LevelDelta{to_side(side), level_px(s, side, cfg_.depth - 1), 0});
+        std::move_backward(q, q + cfg_.depth - 1, q + cfg_.depth);
+        best_[s * 2 + side] += side == kBid ? cfg_.tick : -cfg_.tick;
+        q[0] = pick_qty_(rng_);
+        delta.add(LevelDelta{to_side(side), level_px(s, side, 0), q[0]});
+    }
+
+    void delete_best(uint32_t s, size_t side, BookDelta& delta) {
+        int64_t* q = levels(s, side);
+        delta.add(LevelDelta{to_side(side), level_px(s, side, 0), 0});
+        std::move(q + 1, q + cfg_.depth, q);
+        best_[s * 2 + side] += side == kBid ? -cfg_.tick : cfg_.tick;
+        q[cfg_.depth - 1] = pick_qty_(rng_);
+        delta.add(LevelDelta{to_side(side), level_px(s, side, cfg_.depth - 1), q[cfg_.depth - 1]});
+    }
+
+    // Poisson: exponential gaps at rate. Hawkes: intensity base + excess, where each
+    // message adds branching * decay to the excess and the excess decays
+    // exponentially; sampled by thinning against the current intensity, which only
+    // falls until the next message. base = rate * (1 - branching) keeps the mean rate.
+    int64_t next_arrival_ns() {
+        if (cfg_.rate <= 0.0) return 0;
+        if (cfg_.arrivals == Arrivals::Poisson) {
+            t_s_ += -std::log1p(-uniform()) / base_rate_;
+        } else {
+            for (;;) {
+                const double bound = base_rate_ + excess_;
+                const double gap = -std::log1p(-uniform()) / bound;
+                t_s_ += gap;
+                excess_ *= std::exp(-decay_per_s_ * gap);
+                if (uniform() * bound <= base_rate_ + excess_) break;
+            }
+            excess_ += cfg_.hawkes_branching * decay_per_s_;
+        }
+        return static_cast<int64_t>(t_s_ * 1e9);
+    }
+
+    FeedConfig cfg_;
+    uint32_t first_symbol_;
+    uint32_t count_;
+    std::vector<int64_t> best_;  // [symbol][side]: best bid, best ask
+    std::vector<int64_t> qty_;   // [symbol][side][level]
+    std::mt19937_64 rng_;
+    std::uniform_int_distribution<uint32_t> pick_symbol_;
+    std::uniform_int_distribution<uint32_t> pick_changes_;
+    std::uniform_int_distribution<int64_t> pick_qty_;
+    std::geometric_distribution<uint32_t> pick_depth_;
+    double insert_below_ = 0.0;
+    double delete_below_ = 0.0;
+    double base_rate_ = 0.0;
+    double decay_per_s_ = 0.0;
+    double excess_ = 0.0;
+    double t_s_ = 0.0;
+    uint64_t update_id_ = 0;
+    uint32_t snapshot_symbol_ = 0;
+    uint32_t snapshot_level_ = 0;
+};
+
+}  // namespace hft
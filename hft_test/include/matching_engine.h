@@ -0,0 +1,266 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <unordered_map>
+#include <vector>
+
+#include "hft_common.h"
+
+namespace hft {
+
+// An order as the matcher sees it. owner is opaque to the book; SimEx stores the
+// session handle there so reports find their way back to the right connection.
+struct MatchOrder {
+    uint64_t owner = 0;
+    uint64_t cl_ord_id = 0;
+    uint64_t md_event_id = 0;
+    Side side{};
+    OrderType type = OrderType::Limit;
+    TimeInForce tif = TimeInForce::GTC;
+    int64_t px = 0;
+    int64_t qty = 0;
+};
+
+// One execution report's worth of outcome for one order.
+struct MatchEvent {
+    uint64_t owner = 0;
+    uint64_t cl_ord_id = 0;
+    uint64_t md_event_id = 0;
+    ExecType type = ExecType::Ack;
+    int64_t px = 0;      // fill price (the resting order's); new price for Replaced
+    int64_t qty = 0;     // filled; cancelled remainder; new total for Replaced
+    int64_t leaves = 0;  // still open after this event
+};
+
+// Price-time priority limit order book for one symbol. Each price level is a FIFO of
+// resting orders kept in a pooled, index-linked list, so matching walks levels best
+// first and orders oldest first, a cancel unlinks in O(1), and a finished order's node
+// is reused.
+//
+// An incoming order is acked, then trades against the opposite side for as long as it
+// crosses (market orders cross any price) at each resting order's price. What is left
+// rests if it is a GTC limit and is cancelled otherwise. Resting orders are found for
+// cancel/replace by (owner, cl_ord_id); a request for an order that is not resting
+// (unknown, or already filled) gets CancelReject.
+class MatchingBook {
+public:
+    template <typename OnEvent>
+    void submit(const MatchOrder& o, OnEvent&& on_event) {
+        if (o.qty <= 0 || (o.type == OrderType::Limit && o.px <= 0) || index_.contains(Key{o.owner, o.cl_ord_id})) {
+            on_event(MatchEvent{o.owner, o.cl_ord_id, o.md_event_id, ExecType::Reject, 0, 0, 0});
+            return;
+        }
+        on_event(MatchEvent{o.owner, o.cl_ord_id, o.md_event_id, ExecType::Ack, 0, 0, o.qty});
+        execute(o, o.qty, on_event);
+    }
+
+    template <typename OnEvent>
+    void cancel(uint64_t owner, uint64_t cl_ord_id, OnEvent&& on_event) {
+        const auto it = index_.find(Key{owner, cl_ord_id});
+        if (it == index_.end()) {
+            on_event(MatchEvent{owner, cl_ord_id, 0, ExecType::CancelReject, 0, 0, 0});
+            return;
+        }
+        const uint32_t idx = it->second;
+        const Resting r = pool_[idx];
+        unlink(idx);
+        on_event(MatchEvent{owner, cl_ord_id, r.order.md_event_id, ExecType::Cancel, 0, r.leaves, 0});
+    }
+
+    // qty is the new total, filled included. Shrinking in place keeps the order's queue
+    // position; a new price or a larger size requeues it, and it may trade at once.
+    template <typename OnEvent>
+    void replace(uint64_t owner, uint64_t cl_ord_id, int64_t px, int64_t qty, OnEvent&& on_event) {
+        const auto it = index_.find(Key{owner, cl_ord_id});
+        if (it == index_.end() || px <= 0) {
+            on_event(MatchEvent{owner, cl_ord_id, 0, ExecType::CancelReject, 0, 0, 0});
+            return;
+        }
+        const uint32_t idx = it->second;
+        Resting& r = pool_[idx];
+        const int64_t filled = r.order.qty - r.leaves;
+        if (qty <= filled) {
+            on_event(MatchEvent{owner, cl_ord_id, r.order.md_event_id, ExecType::CancelReject, 0, 0, r.leaves});
+            return;
+        }
+        if (px == r.order.px && qty <= r.order.qty) {
+            r.leaves = qty - filled;
+            r.order.qty = qty;
+            on_event(MatchEvent{owner, cl_ord_id, r.order.md_event_id, ExecType::Replaced, px, qty, r.leaves});
+            return;
+        }
+        MatchOrder o = r.order;
+        unlink(idx);
+        o.px = px;
+        o.qty = qty;
+        on_event(MatchEvent{owner, cl_ord_id, o.md_event_id, ExecType::Replaced, px, qty, qty - filled});
+        execute(o, qty - filled, on_event);
+    }
+
+    // Drops every order owner has resting, without reports (the owner has gone);
+    // returns how many.
+    size_t cancel_owner(uint64_t owner) {
+        std::vector<uint32_t> gone;
+        for (const auto& [key, idx] : index_) {
+            if (key.owner == owner) gone.push_back(idx);
+        }
+        for (const uint32_t idx : gone) unlink(idx);
+        return gone.size();
+    }
+
+    size_t resting() const { return index_.size(); }
+    // 0 when the side is empty.
+    int64_t best_bid() const { return bids_.empty() ? 0 : bids_.begin()->first; }
+    int64_t best_ask() const { return asks_.empty() ? 0 : asks_.begin()->first; }
+    size_t bid_levels() const { return bids_.size(); }
+    size_t ask_levels() const { return asks_.size(); }
+
+private:
+    static constexpr uint32_t kNil = UINT32_MAX;
+
+    struct Resting {
+        MatchOrder order;  // qty is the total, filled included
+        int64_t leaves = 0;
+        uint32_t prev = kNil;
+        uint32_t next = kNil;
+    };
+
+    struct Level {
+        uint32_t head = kNil;
+        uint32_t tail = kNil;
+    };
+
+    struct Key {
+        uint64_t owner;
+        uint64_t cl_ord_id;
+        bool operator==(const Key&) const = default;
+    };
+
+    struct KeyHash {
+        size_t operator()(const Key& k) const {
+            return std::hash<uint64_t>{}(k.cl_ord_id * 0x9E3779B97F4A7C15ull ^ k.owner);
+        }
+    };
+
+    // Trades leaves of o against the opposite side, then rests or cancels the rest.
+    template <typename OnEvent>
+    void execute(const MatchOrder& o, int64_t leaves, OnEvent& on_event) {
+        if (o.side == Side::Buy) {
+            leaves = match(asks_, o, leaves, [&](int64_t ask) { return o.type == OrderType::Market || ask <= o.px; },
+                           on_event);
+        } else {
+            leaves = match(bids_, o, leaves, [&](int64_t bid) { return o.type == OrderType::Market || bid >= o.px; },
+                           on_event);
+        }
+        if (leaves == 0) return;
+        if (o.type == OrderType::Limit && o.tif == TimeInForce::GTC) {
+            rest(o, leaves);
+        } else {
+            on_event(MatchEvent{o.owner, o.cl_ord_id, o.md_event_id, ExecType::Cancel, 0, leaves, 0});
+        }
+    }
+
+    // Trades o against the best levels of book while they cross; returns o's leaves.
+    template <typename Book, typename Crosses, typename OnEvent>
+    int64_t match(Book& book, const MatchOrder& o, int64_t leaves, Crosses crosses, OnEvent& on_event) {
+        while (leaves > 0 && !book.empty() && crosses(book.begin()->first)) {
+            auto level_it = book.begin();
+            Level& level = level_it->second;
+            while (leaves > 0 && level.head != kNil) {
+                const uint32_t idx = level.head;
+                Resting& maker = pool_[idx];
+                const int64_t qty = std::min(leaves, maker.leaves);
+                const int64_t px = maker.order.px;
+                leaves -= qty;
+                maker.leaves -= qty;
+                on_event(MatchEvent{maker.order.owner, maker.order.cl_ord_id, maker.order.md_event_id,
+                                    maker.leaves == 0 ? ExecType::Fill : ExecType::PartialFill, px, qty,
+                                    maker.leaves});
+                on_event(MatchEvent{o.owner, o.cl_ord_id, o.md_event_id,
+                                    leaves == 0 ? ExecType::Fill : ExecType::PartialFill, px, qty, leaves});
+                if (maker.leaves == 0) {
+                    index_.erase(Key{maker.order.owner, maker.order.cl_ord_id});
+                    level.head = maker.next;
+                    if (level.head == kNil) {
+                        level.tail = kNil;
+                    } else {
+                        pool_[level.head].prev = kNil;
+                    }
+                    release(idx);
+                }
+            }
+            if (level.head == kNil) book.erase(level_it);
+        }
+        return leaves;
+    }
+
+    void rest(const MatchOrder& o, int64_t leaves) {
+        Level& level = o.side == Side::Buy ? bids_[o.px] : asks_[o.px];
+        const uint32_t idx = alloc();
+        pool_[idx] = Resting{o, leaves, level.tail, kNil};
+        if (level.tail == kNil) {
+            level.head = idx;
+        } else {
+            pool_[level.tail].next = idx;
+        }
+        level.tail = idx;
+        index_.emplace(Key{o.owner, o.cl_ord_id}, idx);
+    }
+
+    // Takes a resting order out of its level (dropping the level if it empties) and
+    // out of the index, and frees its node.
+    void unlink(uint32_t idx) {
+        const Resting& r = pool_[idx];
+        if (r.order.side == Side::Buy) {
+            unlink_from(bids_, idx);
+        } else {
+            unlink_from(asks_, idx);
+        }
+        index_.erase(Key{r.order.owner, r.order.cl_ord_id});
+        release(idx);
+    }
+
+    template <typename Book>
+    void unlink_from(Book& book, uint32_t idx) {
+        const Resting& r = pool_[idx];
+        const auto level_it = book.find(r.order.px);
+        Level& level = level_it->second;
+        if (r.prev == kNil) {
+            level.head = r.next;
+        } else {
+            pool_[r.prev].next = r.next;
+        }
+        if (r.next == kNil) {
+            level.tail = r.prev;
+        } else {
+            pool_[r.next].prev = r.prev;
+        }
+        if (level.head == kNil) book.erase(level_it);
+    }
+
+    uint32_t alloc() {
+        if (free_ != kNil) {
+            const uint32_t idx = free_;
+            free_ = pool_[idx].next;
+            return idx;
+        }
+        pool_.emplace_back();
+        return static_cast<uint32_t>(pool_.size() - 1);
+    }
+
+    void release(uint32_t idx) {
+        pool_[idx].next = free_;
+        free_ = idx;
+    }
+
+    std::map<int64_t, Level, std::greater<>> bids_;  // best (highest) first
+    std::map<int64_t, Level> asks_;                  // best (lowest) first
+    std::vector<Resting> pool_;
+    uint32_t free_ = kNil;
+    std::unordered_map<Key, uint32_t, KeyHash> index_;
+};
+
+}  // namespace hft
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace hft {
+
+// Preallocated open-addressing map from cl_ord_id to V, for the OMS's live orders.
+// Linear probing with backward-shift deletion: erasing an order moves later entries of
+// its probe run back instead of leaving a tombstone, so a finished order's slot is
+// reusable at once and lookups never degrade with churn. Key 0 marks an empty slot,
+// so cl_ord_id 0 is invalid. Inserts fail once a quarter of the slots would be left,
+// which bounds both memory and probe length; the caller rejects the order.
+template <typename V>
+class OrderTable {
+public:
+    // Room for max_live orders; the slot count is the next power of two >= 4/3 of that.
+    explicit OrderTable(size_t max_live)
+        : mask_(std::bit_ceil(max_live + max_live / 3 + 1) - 1),
+          limit_(max_live),
+          slots_(std::make_unique<Slot[]>(mask_ + 1)) {}
+
+    size_t size() const { return size_; }
+    size_t capacity() const { return limit_; }
+
+    V* find(uint64_t key) {
+        if (key == 0) return nullptr;
+        for (size_t i = home(key);; i = (i + 1) & mask_) {
+            if (slots_[i].key == key) return &slots_[i].value;
+            if (slots_[i].key == 0) return nullptr;
+        }
+    }
+
+    // A value-initialised V for a new key; nullptr if the key is taken or the table full.
+    V* insert(uint64_t key) {
+        if (key == 0 || size_ >= limit_) return nullptr;
+        size_t i = home(key);
+        for (; slots_[i].key != 0; i = (i + 1) & mask_) {
+            if (slots_[i].key == key) return nullptr;
+        }
+        slots_[i].key = key;
+        slots_[i].value = V{};
+        ++size_;
+        return &slots_[i].value;
+    }
+
+    bool erase(uint64_t key) {
+        if (key == 0) return false;
+        size_t i = home(key);
+        for (; slots_[i].key != key; i = (i + 1) & mask_) {
+            if (slots_[i].key == 0) return false;
+        }
+        // Shift back every later entry of the run that may live at i (its home is not
+        // cyclically within (i, j]), then clear the slot the run ends on.
+        for (size_t j = (i + 1) & mask_; slots_[j].key != 0; j = (j + 1) & mask_) {
+            const size_t h = home(slots_[j].key);
+            if (((j - h) & mask_) >= ((j - i) & mask_)) {
+                slots_[i] = slots_[j];
+                i = j;
+            }
+        }
+        slots_[i].key = 0;
+        --size_;
+        return true;
+    }
+
+private:
+    struct Slot {
+        uint64_t key = 0;
+        V value{};
+    };
+
+    // Fibonacci hashing: cl_ord_ids are sequential, this spreads them over the table.
+    size_t home(uint64_t key) const {
+        return static_cast<size_t>((key * 0x9E3779B97F4A7C15ull) >> 32) & mask_;
+    }
+
+    size_t mask_;
+    size_t limit_;
+    size_t size_ = 0;
+    std::unique_ptr<Slot[]> slots_;
+};
+
+}  // namespace hft
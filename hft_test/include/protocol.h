@@ -1,16 +1,21 @@
 #pragma once
 
 #include <arpa/inet.h>
+
+#include <array>
+#include <cstddef>
 #include <cstdint>
 #include <cstring>
-#include <string>
-#include <vector>
+#include <span>
+#include <type_traits>
 
 namespace hft {
 
 constexpr uint16_t kProtocolMagic = 0xA11C;
 constexpr uint8_t kMsgNewOrder = 1;
 constexpr uint8_t kMsgExecReport = 2;
+constexpr uint8_t kMsgCancel = 3;
+constexpr uint8_t kMsgReplace = 4;
 
 struct WireHeader {
     uint16_t magic = kProtocolMagic;
@@ -20,6 +25,7 @@ struct WireHeader {
 
 struct WireNewOrder {
     WireHeader hdr{.magic = kProtocolMagic, .msg_type = kMsgNewOrder, .reserved = 0};
+    uint32_t symbol_id = 0;
     uint64_t cl_ord_id = 0;
     uint64_t md_event_id = 0;
     uint8_t side = 0;
@@ -31,37 +37,156 @@ struct WireNewOrder {
     int64_t t_oms_send_ns = 0;
 };
 
+// Cancel and replace name the live order by its cl_ord_id, which a replace keeps.
+struct WireCancel {
+    WireHeader hdr{.magic = kProtocolMagic, .msg_type = kMsgCancel, .reserved = 0};
+    uint32_t symbol_id = 0;
+    uint64_t cl_ord_id = 0;
+    int64_t t_oms_send_ns = 0;
+};
+
+// New price and total quantity (filled included). Reducing quantity at the same price
+// keeps queue priority; anything else requeues the order and may trade at once.
+struct WireReplace {
+    WireHeader hdr{.magic = kProtocolMagic, .msg_type = kMsgReplace, .reserved = 0};
+    uint32_t symbol_id = 0;
+    uint64_t cl_ord_id = 0;
+    int64_t px = 0;
+    int64_t qty = 0;
+    int64_t t_oms_send_ns = 0;
+};
+
+// fill_px/fill_qty are the trade for fills, the new price/total quantity for Replaced,
+// and the cancelled quantity for Cancel.
 struct WireExecReport {
     WireHeader hdr{.magic = kProtocolMagic, .msg_type = kMsgExecReport, .reserved = 0};
+    uint32_t symbol_id = 0;
     uint64_t cl_ord_id = 0;
     uint64_t md_event_id = 0;
     uint8_t exec_type = 0;
     uint8_t _pad[3]{};
     int64_t fill_px = 0;
     int64_t fill_qty = 0;
+    int64_t leaves_qty = 0;
     int64_t t_sim_recv_ns = 0;
     int64_t t_sim_send_ns = 0;
     int32_t reason = 0;
     int32_t _pad2 = 0;
 };
 
-inline std::vector<uint8_t> pack_with_length(const void* data, size_t len) {
-    std::vector<uint8_t> out(sizeof(uint32_t) + len);
-    uint32_t be_len = htonl(static_cast<uint32_t>(len));
-    std::memcpy(out.data(), &be_len, sizeof(be_len));
-    std::memcpy(out.data() + sizeof(be_len), data, len);
-    return out;
+// Frames are a big-endian u32 payload length followed by the payload (one Wire* struct).
+constexpr size_t kFrameHeader = sizeof(uint32_t);
+
+// Fixed-capacity receive buffer that hands out whole frames as views into itself.
+// recv() straight into write_area(), commit() what arrived, then drain next_frame()
+// until it returns false; the views stay valid until the next write_area(). Only the
+// unread tail (less than one frame once drained) is ever moved, and only after the
+// write position passes the middle, so a max-size frame always fits after a compact.
+template <size_t Capacity>
+class FrameReader {
+public:
+    static_assert(Capacity >= 2 * (kFrameHeader + 256), "room for a couple of frames");
+
+    std::span<uint8_t> write_area() {
+        if (head_ == tail_) {
+            head_ = tail_ = 0;
+        } else if (head_ > 0 && tail_ > Capacity / 2) {
+            std::memmove(buf_.data(), buf_.data() + head_, tail_ - head_);
+            tail_ -= head_;
+            head_ = 0;
+        }
+        return {buf_.data() + tail_, Capacity - tail_};
+    }
+
+    void commit(size_t n) { tail_ += n; }
+
+    // Next complete frame's payload, or false when only a partial frame (or nothing)
+    // is buffered. A length that could never fit sets error() and stops the stream.
+    bool next_frame(std::span<const uint8_t>& payload) {
+        if (error_ || tail_ - head_ < kFrameHeader) return false;
+        uint32_t be_len = 0;
+        std::memcpy(&be_len, buf_.data() + head_, sizeof(be_len));
+        const size_t len = ntohl(be_len);
+        if (len > kMaxPayload) {
+            error_ = true;
+            return false;
+        }
+        if (tail_ - head_ < kFrameHeader + len) return false;
+        payload = {buf_.data() + head_ + kFrameHeader, len};
+        head_ += kFrameHeader + len;
+        return true;
+    }
+
+    bool error() const { return error_; }
+
+    void reset() {
+        head_ = tail_ = 0;
+        error_ = false;
+    }
+
+private:
+    static constexpr size_t kMaxPayload = Capacity / 2 - kFrameHeader;
+
+    std::array<uint8_t, Capacity> buf_{};
+    size_t head_ = 0;  // first unread byte
+    size_t tail_ = 0;  // one past the last received byte
+    bool error_ = false;
+};
+
+// Preallocated send buffer; messages are framed in place, never through a temporary.
+// Bytes leave from the front: consume() what the socket took, the rest stays queued.
+template <size_t Capacity>
+class FrameWriter {
+public:
+    template <typename Msg>
+    bool append(const Msg& msg) {
+        static_assert(std::is_trivially_copyable_v<Msg>);
+        constexpr size_t kFrame = kFrameHeader + sizeof(Msg);
+        if (Capacity - tail_ < kFrame) {
+            if (Capacity - (tail_ - head_) < kFrame) return false;
+            std::memmove(buf_.data(), buf_.data() + head_, tail_ - head_);
+            tail_ -= head_;
+            head_ = 0;
+        }
+        const uint32_t be_len = htonl(static_cast<uint32_t>(sizeof(Msg)));
+        std::memcpy(buf_.data() + tail_, &be_len, sizeof(be_len));
+        std::memcpy(buf_.data() + tail_ + kFrameHeader, &msg, sizeof(Msg));
+        tail_ += kFrame;
+        return true;
+    }
+
+    std::span<const uint8_t> pending() const { return {buf_.data() + head_, tail_ - head_}; }
+    bool empty() const { return head_ == tail_; }
+    // Whether a frame carrying a payload of this size fits, compacting if needed.
+    bool fits(size_t payload) const { return Capacity - (tail_ - head_) >= kFrameHeader + payload; }
+
+    void consume(size_t n) {
+        head_ += n;
+        if (head_ == tail_) head_ = tail_ = 0;
+    }
+
+    void clear() { head_ = tail_ = 0; }
+
+private:
+    std::array<uint8_t, Capacity> buf_{};
+    size_t head_ = 0;
+    size_t tail_ = 0;
+};
+
+// Message type of a payload, or 0 if it is too short or has the wrong magic.
+inline uint8_t frame_msg_type(std::span<const uint8_t> payload) {
+    WireHeader hdr;
+    if (payload.size() < sizeof(hdr)) return 0;
+    std::memcpy(&hdr, payload.data(), sizeof(hdr));
+    return hdr.magic == kProtocolMagic ? hdr.msg_type : 0;
 }
 
-inline bool unpack_frame(const std::vector<uint8_t>& buf, size_t& offset, std::vector<uint8_t>& payload) {
-    if (offset + sizeof(uint32_t) > buf.size()) return false;
-    uint32_t be_len = 0;
-    std::memcpy(&be_len, buf.data() + offset, sizeof(be_len));
-    uint32_t len = ntohl(be_len);
-    if (offset + sizeof(uint32_t) + len > buf.size()) return false;
-    payload.assign(buf.begin() + offset + sizeof(uint32_t), buf.begin() + offset + sizeof(uint32_t) + len);
-    offset += sizeof(uint32_t) + len;
-    return true;
+// Copies a payload into Msg if it is one, by size, magic and type.
+template <typename Msg>
+bool decode_frame(std::span<const uint8_t> payload, uint8_t msg_type, Msg& out) {
+    if (payload.size() < sizeof(Msg)) return false;
+    std::memcpy(&out, payload.data(), sizeof(Msg));
+    return out.hdr.magic == kProtocolMagic && out.hdr.msg_type == msg_type;
 }
 
 }  // namespace hft
@@ -0,0 +1,227 @@
+#pragma once
+
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <new>
+#include <span>
+
+namespace hft {
+
+constexpr size_t kCacheLine = 64;
+
+// One frame per slot: its payload length, then the payload. Two cache lines, so the
+// largest wire message fits and no two slots share a line.
+struct alignas(kCacheLine) ShmSlot {
+    static constexpr size_t kPayloadBytes = 2 * kCacheLine - sizeof(uint32_t);
+
+    uint32_t len;
+    uint8_t payload[kPayloadBytes];
+};
+static_assert(sizeof(ShmSlot) == 2 * kCacheLine);
+
+// Single-producer/single-consumer ring of frames living in memory shared by two
+// processes. The indices count slots ever written and read, each on its own line, so
+// the producer and consumer only share a line when one looks at the other's index.
+//
+// The doorbell is optional. A consumer about to sleep raises sleeping and waits on
+// bell as a futex; a producer that publishes while sleeping is raised bumps bell and
+// wakes it. Both sides fence between their store and their load of the other's flag,
+// so either the consumer sees the new frames or the producer sees it sleeping.
+struct ShmRing {
+    static constexpr uint64_t kSlots = 1024;  // power of two
+
+    alignas(kCacheLine) std::atomic<uint64_t> tail;  // written by the producer
+    alignas(kCacheLine) std::atomic<uint64_t> head;  // written by the consumer
+    alignas(kCacheLine) std::atomic<uint32_t> bell;
+    std::atomic<uint32_t> sleeping;
+    std::atomic<uint32_t> closed;  // the producer has gone
+    ShmSlot slots[kSlots];
+};
+static_assert(std::atomic<uint64_t>::is_always_lock_free && std::atomic<uint32_t>::is_always_lock_free,
+              "cross-process atomics must be lock-free");
+
+namespace detail {
+
+inline long futex(std::atomic<uint32_t>* word, int op, uint32_t val, const timespec* timeout) {
+    return ::syscall(__NR_futex, reinterpret_cast<uint32_t*>(word), op, val, timeout, nullptr, 0);
+}
+
+inline timespec to_timespec(int64_t ns) { return timespec{ns / 1'000'000'000, ns % 1'000'000'000}; }
+
+}  // namespace detail
+
+// A shared mapping holding one ShmRing, created under a POSIX shm name or opened by it.
+// The name only lives until the peer has mapped it; the mapping goes with the object.
+class ShmRegion {
+public:
+    ShmRegion() = default;
+    ~ShmRegion() {
+        if (ring_ != nullptr) ::munmap(ring_, sizeof(ShmRing));
+    }
+
+    ShmRegion(const ShmRegion&) = delete;
+    ShmRegion& operator=(const ShmRegion&) = delete;
+
+    bool create(const char* name) {
+        const int fd = ::shm_open(name, O_CREAT | O_EXCL | O_RDWR | O_CLOEXEC, 0600);
+        if (fd < 0) return false;
+        const bool sized = ::ftruncate(fd, sizeof(ShmRing)) == 0;
+        if (sized) map(fd);
+        ::close(fd);
+        if (ring_ == nullptr) {
+            ::shm_unlink(name);
+            return false;
+        }
+        new (ring_) ShmRing();
+        return true;
+    }
+
+    bool open(const char* name) {
+        const int fd = ::shm_open(name, O_RDWR | O_CLOEXEC, 0);
+        if (fd < 0) return false;
+        struct stat st {};
+        if (::fstat(fd, &st) == 0 && static_cast<size_t>(st.st_size) == sizeof(ShmRing)) map(fd);
+        ::close(fd);
+        return ring_ != nullptr;
+    }
+
+    ShmRing* ring() const { return ring_; }
+
+private:
+    void map(int fd) {
+        void* p = ::mmap(nullptr, sizeof(ShmRing), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (p != MAP_FAILED) ring_ = static_cast<ShmRing*>(p);
+    }
+
+    ShmRing* ring_ = nullptr;
+};
+
+// Producer end. Slots are claimed and filled locally and only become visible to the
+// consumer at publish(), so a burst goes over in one release store.
+class ShmProducer {
+public:
+    void attach(ShmRing* ring) { ring_ = ring; }
+
+    size_t free_slots() const {
+        if (tail_ - head_cache_ == ShmRing::kSlots) head_cache_ = ring_->head.load(std::memory_order_acquire);
+        return ShmRing::kSlots - (tail_ - head_cache_);
+    }
+
+    // Caller checks free_slots() first.
+    ShmSlot& claim() { return ring_->slots[tail_++ & (ShmRing::kSlots - 1)]; }
+
+    bool unpublished() const { return tail_ != published_; }
+
+    void publish(bool doorbell) {
+        published_ = tail_;
+        ring_->tail.store(tail_, std::memory_order_release);
+        if (!doorbell) return;
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (ring_->sleeping.load(std::memory_order_relaxed) != 0) ring();
+    }
+
+    // Tells the consumer the producer has gone; a no-op if never attached.
+    void close() {
+        if (ring_ == nullptr) return;
+        ring_->closed.store(1, std::memory_order_release);
+        ring();
+    }
+
+private:
+    void ring() {
+        ring_->bell.fetch_add(1, std::memory_order_release);
+        detail::futex(&ring_->bell, FUTEX_WAKE, 1, nullptr);
+    }
+
+    ShmRing* ring_ = nullptr;
+    uint64_t tail_ = 0;
+    uint64_t published_ = 0;
+    mutable uint64_t head_cache_ = 0;
+};
+
+// Consumer end.
+class ShmConsumer {
+public:
+    void attach(ShmRing* ring) { ring_ = ring; }
+
+    // Hands each published frame to on_frame(std::span<const uint8_t>) and frees the
+    // slots in one store. Returns the frames read, or -1 on a corrupt slot.
+    template <typename OnFrame>
+    long drain(OnFrame& on_frame) {
+        if (head_ == tail_cache_) {
+            tail_cache_ = ring_->tail.load(std::memory_order_acquire);
+            if (head_ == tail_cache_) return 0;
+        }
+        long frames = 0;
+        for (; head_ != tail_cache_; ++head_, ++frames) {
+            const ShmSlot& slot = ring_->slots[head_ & (ShmRing::kSlots - 1)];
+            if (slot.len > ShmSlot::kPayloadBytes) return -1;
+            on_frame(std::span<const uint8_t>(slot.payload, slot.len));
+        }
+        ring_->head.store(head_, std::memory_order_release);
+        return frames;
+    }
+
+    bool closed() const { return ring_->closed.load(std::memory_order_acquire) != 0; }
+
+    // Sleeps until the producer publishes or timeout_ns passes; returns at once if
+    // frames are already waiting.
+    void park(int64_t timeout_ns) {
+        const uint32_t bell = ring_->bell.load(std::memory_order_acquire);
+        ring_->sleeping.store(1, std::memory_order_seq_cst);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (ring_->tail.load(std::memory_order_relaxed) == head_ && !closed()) {
+            const timespec ts = detail::to_timespec(timeout_ns);
+            detail::futex(&ring_->bell, FUTEX_WAIT, bell, &ts);
+        }
+        ring_->sleeping.store(0, std::memory_order_relaxed);
+    }
+
+    // As park(), over several rings at once: until any of them is published to.
+    static void park_any(std::span<ShmConsumer* const> consumers, int64_t timeout_ns) {
+        // Past FUTEX_WAITV_MAX rings, the rest are only seen when this wait ends.
+        const size_t n = std::min<size_t>(consumers.size(), FUTEX_WAITV_MAX);
+        if (n == 0) return;
+        std::array<futex_waitv, FUTEX_WAITV_MAX> waiters{};
+        for (size_t i = 0; i < n; ++i) {
+            ShmRing* r = consumers[i]->ring_;
+            waiters[i].val = r->bell.load(std::memory_order_acquire);
+            waiters[i].uaddr = reinterpret_cast<uintptr_t>(&r->bell);
+            waiters[i].flags = FUTEX_32;
+            r->sleeping.store(1, std::memory_order_seq_cst);
+        }
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        bool ready = false;
+        for (size_t i = 0; i < n; ++i) {
+            const ShmConsumer* c = consumers[i];
+            ready = ready || c->ring_->tail.load(std::memory_order_relaxed) != c->head_ || c->closed();
+        }
+        if (!ready) {
+            timespec deadline{};
+            ::clock_gettime(CLOCK_MONOTONIC, &deadline);
+            const int64_t at = deadline.tv_sec * 1'000'000'000 + deadline.tv_nsec + timeout_ns;
+            deadline = detail::to_timespec(at);
+            ::syscall(__NR_futex_waitv, waiters.data(), n, 0, &deadline, CLOCK_MONOTONIC);
+        }
+        for (size_t i = 0; i < n; ++i) consumers[i]->ring_->sleeping.store(0, std::memory_order_relaxed);
+    }
+
+private:
+    ShmRing* ring_ = nullptr;
+    uint64_t head_ = 0;
+    uint64_t tail_cache_ = 0;
+};
+
+}  // namespace hft
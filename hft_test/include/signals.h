@@ -0,0 +1,85 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace hft {
+
+// Rolling signal primitives kept for many symbols at once. Each is structure-of-arrays:
+// one array per field, indexed by a dense symbol index in [0, symbols). Updating one
+// symbol is O(1) and touches one element per field; a pass over every symbol walks
+// each field at unit stride.
+
+// Mean and variance over each symbol's last Window samples, held in a ring per symbol.
+// Replacing the oldest sample moves mean and M2 in place (Welford's update in sliding
+// form), so there is no sum of squares of large prices to cancel. Until the window
+// fills, it covers the samples seen so far.
+template <size_t Window>
+class RollingWindow {
+public:
+    static_assert(Window >= 2 && (Window & (Window - 1)) == 0, "Window must be a power of two");
+
+    explicit RollingWindow(size_t symbols)
+        : samples_(symbols * Window), count_(symbols), mean_(symbols), m2_(symbols) {}
+
+    void update(size_t i, double x) {
+        double* ring = &samples_[i * Window];
+        const uint64_t n = count_[i]++;
+        if (n < Window) {
+            ring[n] = x;
+            const double d = x - mean_[i];
+            mean_[i] += d / static_cast<double>(n + 1);
+            m2_[i] += d * (x - mean_[i]);
+            return;
+        }
+        double& slot = ring[n & (Window - 1)];
+        const double old = slot;
+        slot = x;
+        const double mean = mean_[i] + (x - old) / static_cast<double>(Window);
+        m2_[i] = std::max(0.0, m2_[i] + (x - old) * (x - mean + old - mean_[i]));
+        mean_[i] = mean;
+    }
+
+    size_t samples(size_t i) const { return static_cast<size_t>(std::min<uint64_t>(count_[i], Window)); }
+    double mean(size_t i) const { return mean_[i]; }
+    double variance(size_t i) const {
+        const size_t n = samples(i);
+        return n < 2 ? 0.0 : m2_[i] / static_cast<double>(n - 1);
+    }
+    double stddev(size_t i) const { return std::sqrt(variance(i)); }
+
+private:
+    std::vector<double> samples_;  // [symbol][slot]
+    std::vector<uint64_t> count_;  // samples ever seen; the next slot is count % Window
+    std::vector<double> mean_;
+    std::vector<double> m2_;
+};
+
+// Best bid and ask of one book, the input to the book signals below.
+struct TopOfBook {
+    int64_t bid_px = 0;
+    int64_t bid_qty = 0;
+    int64_t ask_px = 0;
+    int64_t ask_qty = 0;
+};
+
+// (bid_qty - ask_qty) / (bid_qty + ask_qty), in [-1, 1]: positive when bids outweigh asks.
+inline double book_imbalance(const TopOfBook& top) {
+    const int64_t total = top.bid_qty + top.ask_qty;
+    return total > 0 ? static_cast<double>(top.bid_qty - top.ask_qty) / static_cast<double>(total) : 0.0;
+}
+
+// Mid weighted by the opposite side's size, so it leans toward the side likely to trade
+// through first. Equals the mid when both sides show the same size.
+inline double microprice(const TopOfBook& top) {
+    const int64_t total = top.bid_qty + top.ask_qty;
+    if (total <= 0) return (static_cast<double>(top.bid_px) + static_cast<double>(top.ask_px)) / 2.0;
+    return (static_cast<double>(top.bid_px) * static_cast<double>(top.ask_qty) +
+            static_cast<double>(top.ask_px) * static_cast<double>(top.bid_qty)) /
+           static_cast<double>(total);
+}
+
+}  // namespace hft
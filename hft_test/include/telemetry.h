@@ -0,0 +1,302 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <concepts>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "hft_common.h"
+
+namespace hft {
+
+// Instrumented stages. IDs are compile-time constants, so a probe indexes an array
+// instead of building and hashing a name.
+enum class Probe : uint8_t {
+    MdTotal,
+    MdRead,
+    MdAlign,
+    MdFeedLag,
+    StrategyTotal,
+    StrategyDecision,
+    StrategyExecDrain,
+    SendOrder,
+    SendOrderRingFull,
+    OrderRoundTrip,
+    // One new order's path to its Ack, stage by stage (see README).
+    OrderStrategy,
+    OrderRingToOms,
+    OrderOms,
+    OrderWireOut,
+    OrderSim,
+    OrderWireBack,
+    OrderRingToStrategy,
+    OrderTickToAck,
+    Count,
+};
+
+constexpr size_t kProbeCount = static_cast<size_t>(Probe::Count);
+
+constexpr const char* probe_name(Probe p) {
+    switch (p) {
+        case Probe::MdTotal: return "md_total";
+        case Probe::MdRead: return "md_read";
+        case Probe::MdAlign: return "md_align";
+        case Probe::MdFeedLag: return "md_feed_lag";
+        case Probe::StrategyTotal: return "strategy_total";
+        case Probe::StrategyDecision: return "strategy_decision";
+        case Probe::StrategyExecDrain: return "strategy_exec_drain";
+        case Probe::SendOrder: return "strategy_send_order";
+        case Probe::SendOrderRingFull: return "strategy_send_order_ring_full";
+        case Probe::OrderRoundTrip: return "oms_order_round_trip";
+        case Probe::OrderStrategy: return "order_strategy";
+        case Probe::OrderRingToOms: return "order_ring_to_oms";
+        case Probe::OrderOms: return "order_oms";
+        case Probe::OrderWireOut: return "order_wire_out";
+        case Probe::OrderSim: return "order_sim";
+        case Probe::OrderWireBack: return "order_wire_back";
+        case Probe::OrderRingToStrategy: return "order_ring_to_strategy";
+        case Probe::OrderTickToAck: return "order_tick_to_ack";
+        case Probe::Count: break;
+    }
+    return "?";
+}
+
+// Log-linear (HDR-style) bucketing of nanosecond samples: exact below 128 ns, then 64
+// buckets per power of two, so a quantile is reported within 1/64 (~1.6%). Anything
+// past 2^40 ns (~18 min) lands in the top bucket.
+struct HistogramLayout {
+    static constexpr unsigned kSubBits = 7;
+    static constexpr unsigned kMaxBits = 40;
+    static constexpr size_t kLinear = size_t{1} << kSubBits;
+    static constexpr size_t kHalf = kLinear / 2;
+    static constexpr size_t kBuckets = kLinear + (kMaxBits - kSubBits) * kHalf;
+
+    static size_t bucket(uint64_t v) {
+        if (v < kLinear) return static_cast<size_t>(v);
+        if (v >= (uint64_t{1} << kMaxBits)) return kBuckets - 1;
+        const unsigned shift = static_cast<unsigned>(std::bit_width(v)) - kSubBits;  // >= 1
+        return kLinear + (shift - 1) * kHalf + (static_cast<size_t>(v >> shift) - kHalf);
+    }
+
+    // Highest value that maps to bucket b.
+    static uint64_t upper(size_t b) {
+        if (b < kLinear) return b;
+        const size_t k = b - kLinear;
+        const unsigned shift = static_cast<unsigned>(k / kHalf) + 1;
+        return ((uint64_t{kHalf + k % kHalf} + 1) << shift) - 1;
+    }
+};
+
+// Merged, plain-integer view of one probe, owned by whoever asked for it.
+struct HistogramCounts {
+    std::vector<uint64_t> counts = std::vector<uint64_t>(HistogramLayout::kBuckets, 0);
+    uint64_t total = 0;
+    uint64_t max = 0;
+
+    // Upper edge of the bucket holding quantile q in [0, 1], capped at max; 0 when empty.
+    uint64_t quantile(double q) const {
+        if (total == 0) return 0;
+        const auto rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(q * static_cast<double>(total))));
+        uint64_t seen = 0;
+        for (size_t b = 0; b < counts.size(); ++b) {
+            seen += counts[b];
+            if (seen >= rank) return std::min(HistogramLayout::upper(b), max);
+        }
+        return max;
+    }
+};
+
+// One thread's histograms, one per probe. Only the owning thread writes: a record is a
+// relaxed load+store of one counter (no locked RMW, no allocation), and the aggregator
+// may read concurrently because every counter is an atomic.
+class TelemetryShard {
+public:
+    void record(Probe p, int64_t ns) {
+        auto& h = probes_[static_cast<size_t>(p)];
+        const uint64_t v = ns > 0 ? static_cast<uint64_t>(ns) : 0;
+        bump(h.counts[HistogramLayout::bucket(v)]);
+        bump(h.total);
+        if (v > h.max.load(std::memory_order_relaxed)) h.max.store(v, std::memory_order_relaxed);
+    }
+
+    void merge_into(Probe p, HistogramCounts& out) const {
+        const auto& h = probes_[static_cast<size_t>(p)];
+        for (size_t b = 0; b < HistogramLayout::kBuckets; ++b) {
+            out.counts[b] += h.counts[b].load(std::memory_order_relaxed);
+        }
+        out.total += h.total.load(std::memory_order_relaxed);
+        out.max = std::max(out.max, h.max.load(std::memory_order_relaxed));
+    }
+
+private:
+    struct Histogram {
+        std::array<std::atomic<uint64_t>, HistogramLayout::kBuckets> counts{};
+        std::atomic<uint64_t> total{0};
+        std::atomic<uint64_t> max{0};
+    };
+
+    static void bump(std::atomic<uint64_t>& c) {
+        c.store(c.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+    std::array<Histogram, kProbeCount> probes_{};
+};
+
+// Registry of per-thread shards. Memory is fixed once every recording thread has
+// registered; quantiles come from merging the shards, never from stored samples.
+class Telemetry {
+public:
+    using Snapshot = std::array<HistogramCounts, kProbeCount>;
+
+    // Setup-time, once per recording thread; takes a lock and allocates.
+    TelemetryShard& register_thread() {
+        std::lock_guard<std::mutex> lock(mu_);
+        shards_.push_back(std::make_unique<TelemetryShard>());
+        return *shards_.back();
+    }
+
+    // Merges every shard; safe while threads are recording.
+    Snapshot snapshot() const {
+        Snapshot snap;
+        std::lock_guard<std::mutex> lock(mu_);
+        for (const auto& shard : shards_) {
+            for (size_t i = 0; i < kProbeCount; ++i) {
+                shard->merge_into(static_cast<Probe>(i), snap[i]);
+            }
+        }
+        return snap;
+    }
+
+    static std::string format(const Snapshot& snap) {
+        std::string out;
+        const auto us = [](uint64_t ns) { return std::to_string(static_cast<double>(ns) / 1000.0); };
+        for (size_t i = 0; i < kProbeCount; ++i) {
+            const auto& h = snap[i];
+            if (h.total == 0) continue;
+            out += std::string(probe_name(static_cast<Probe>(i))) + ": n=" + std::to_string(h.total) +
+                   " p50=" + us(h.quantile(0.50)) + "us p90=" + us(h.quantile(0.90)) + "us p99=" +
+                   us(h.quantile(0.99)) + "us p99.9=" + us(h.quantile(0.999)) + "us max=" + us(h.max) + "us\n";
+        }
+        return out;
+    }
+
+    std::string summary() const { return format(snapshot()); }
+
+private:
+    mutable std::mutex mu_;
+    std::vector<std::unique_ptr<TelemetryShard>> shards_;
+};
+
+// Background thread that merges the shards every interval, so a live view of the
+// quantiles costs the recording threads nothing. latest() returns the last merge.
+class TelemetryAggregator {
+public:
+    TelemetryAggregator(const Telemetry& tele, std::chrono::milliseconds every)
+        : tele_(tele), every_(every), thread_([this] { run(); }) {}
+
+    ~TelemetryAggregator() { stop(); }
+
+    TelemetryAggregator(const TelemetryAggregator&) = delete;
+    TelemetryAggregator& operator=(const TelemetryAggregator&) = delete;
+
+    void stop() {
+        {
+            std::lock_guard<std::mutex> lock(mu_);
+            stopping_ = true;
+        }
+        cv_.notify_all();
+        if (thread_.joinable()) thread_.join();
+    }
+
+    std::shared_ptr<const Telemetry::Snapshot> latest() const {
+        std::lock_guard<std::mutex> lock(mu_);
+        return latest_;
+    }
+
+private:
+    void run() {
+        std::unique_lock<std::mutex> lock(mu_);
+        for (;;) {
+            const bool stopping = cv_.wait_for(lock, every_, [this] { return stopping_; });
+            lock.unlock();
+            auto snap = std::make_shared<const Telemetry::Snapshot>(tele_.snapshot());
+            lock.lock();
+            latest_ = std::move(snap);
+            if (stopping) return;
+        }
+    }
+
+    const Telemetry& tele_;
+    std::chrono::milliseconds every_;
+    mutable std::mutex mu_;
+    std::condition_variable cv_;
+    bool stopping_ = false;
+    std::shared_ptr<const Telemetry::Snapshot> latest_;
+    std::thread thread_;
+};
+
+// Sink policies: where stage timings go. Both are built over the recording thread's
+// shard; a policy with kEnabled == false compiles every probe down to nothing, clock
+// reads included.
+class TelemetrySink {
+public:
+    static constexpr bool kEnabled = true;
+
+    explicit TelemetrySink(TelemetryShard& shard) : shard_(&shard) {}
+    void record(Probe p, int64_t ns) { shard_->record(p, ns); }
+
+private:
+    TelemetryShard* shard_;
+};
+
+struct NullSink {
+    static constexpr bool kEnabled = false;
+
+    explicit NullSink(TelemetryShard&) {}
+    void record(Probe, int64_t) {}
+};
+
+#ifdef HFT_NO_TELEMETRY
+using ProbeSink = NullSink;
+#else
+using ProbeSink = TelemetrySink;
+#endif
+
+template <typename S>
+concept StageSink = requires(S s, Probe p, int64_t ns) {
+    { S::kEnabled } -> std::convertible_to<bool>;
+    s.record(p, ns);
+};
+
+// Times its scope into Sink under a fixed probe ID.
+template <Probe P, StageSink Sink>
+class ScopedProbe {
+public:
+    explicit ScopedProbe(Sink& sink) : sink_(sink) {
+        if constexpr (Sink::kEnabled) begin_ = Clock::now();
+    }
+
+    ~ScopedProbe() {
+        if constexpr (Sink::kEnabled) {
+            sink_.record(P, std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - begin_).count());
+        }
+    }
+
+    ScopedProbe(const ScopedProbe&) = delete;
+    ScopedProbe& operator=(const ScopedProbe&) = delete;
+
+private:
+    Sink& sink_;
+    TimePoint begin_{};
+};
+
+}  // namespace hft
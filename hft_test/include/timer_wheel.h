@@ -0,0 +1,129 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace hft {
+
+// Hashed timing wheel: schedule is O(1) and expiry touches one slot per elapsed tick.
+// A timer lands in slot (due_tick % Slots); delays longer than one revolution simply
+// stay in their slot until their tick comes round. Payloads live in pooled nodes, so
+// once the pool has grown to the peak number of pending timers nothing allocates.
+// Timers due on the same tick fire in the order they were scheduled.
+template <typename T, size_t Slots = 4096>
+class TimerWheel {
+public:
+    static_assert((Slots & (Slots - 1)) == 0, "Slots must be a power of two");
+
+    TimerWheel(int64_t tick_ns, int64_t now_ns)
+        : tick_ns_(tick_ns), current_(static_cast<uint64_t>(now_ns / tick_ns)) {
+        heads_.fill(kNil);
+        tails_.fill(kNil);
+    }
+
+    bool empty() const { return size_ == 0; }
+    size_t size() const { return size_; }
+
+    // Fires no earlier than due_ns (rounded up to a tick), and no earlier than the next
+    // advance() for anything already due.
+    void schedule(int64_t due_ns, const T& value) {
+        const uint64_t tick = std::max(static_cast<uint64_t>((due_ns + tick_ns_ - 1) / tick_ns_), current_);
+        const uint32_t idx = alloc();
+        nodes_[idx].value = value;
+        nodes_[idx].tick = tick;
+        nodes_[idx].next = kNil;
+        const size_t slot = tick & (Slots - 1);
+        if (tails_[slot] == kNil) {
+            heads_[slot] = idx;
+        } else {
+            nodes_[tails_[slot]].next = idx;
+        }
+        tails_[slot] = idx;
+        ++size_;
+    }
+
+    // Fires everything due at or before now_ns. fire may schedule new timers.
+    template <typename Fire>
+    void advance(int64_t now_ns, Fire&& fire) {
+        const uint64_t target = static_cast<uint64_t>(now_ns / tick_ns_);
+        for (size_t visited = 0; current_ <= target; ++visited) {
+            if (size_ == 0 || visited == Slots) {  // one revolution has seen every slot
+                current_ = target + 1;
+                return;
+            }
+            // Step first: anything fire() schedules for "now" lands on the next tick.
+            const uint64_t tick = current_++;
+            expire(tick & (Slots - 1), target, fire);
+        }
+    }
+
+    // When the caller should next call advance(): the first tick within a short
+    // look-ahead whose slot is occupied, else the end of the look-ahead. -1 if empty.
+    int64_t next_due_ns() const {
+        if (size_ == 0) return -1;
+        constexpr uint64_t kLookahead = 64;
+        uint64_t tick = current_;
+        for (; tick < current_ + kLookahead; ++tick) {
+            if (heads_[tick & (Slots - 1)] != kNil) break;
+        }
+        return static_cast<int64_t>(tick) * tick_ns_;
+    }
+
+private:
+    static constexpr uint32_t kNil = UINT32_MAX;
+
+    struct Node {
+        T value;
+        uint64_t tick = 0;
+        uint32_t next = kNil;
+    };
+
+    uint32_t alloc() {
+        if (free_ != kNil) {
+            const uint32_t idx = free_;
+            free_ = nodes_[idx].next;
+            return idx;
+        }
+        nodes_.emplace_back();
+        return static_cast<uint32_t>(nodes_.size() - 1);
+    }
+
+    // Detaches the slot first so fire() can schedule into it without disturbing the walk.
+    template <typename Fire>
+    void expire(size_t slot, uint64_t target, Fire& fire) {
+        uint32_t idx = heads_[slot];
+        heads_[slot] = tails_[slot] = kNil;
+        while (idx != kNil) {
+            const uint32_t next = nodes_[idx].next;
+            if (nodes_[idx].tick <= target) {
+                --size_;
+                const T value = nodes_[idx].value;  // fire() may grow nodes_
+                nodes_[idx].next = free_;
+                free_ = idx;
+                fire(value);
+            } else {
+                nodes_[idx].next = kNil;
+                if (tails_[slot] == kNil) {
+                    heads_[slot] = idx;
+                } else {
+                    nodes_[tails_[slot]].next = idx;
+                }
+                tails_[slot] = idx;
+            }
+            idx = next;
+        }
+    }
+
+    int64_t tick_ns_;
+    uint64_t current_;  // next tick to expire
+    size_t size_ = 0;
+    uint32_t free_ = kNil;
+    std::vector<Node> nodes_;
+    std::array<uint32_t, Slots> heads_;
+    std::array<uint32_t, Slots> tails_;
+};
+
+}  // namespace hft
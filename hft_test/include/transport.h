@@ -0,0 +1,694 @@
+#pragma once
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+#include "protocol.h"
+#include "shm_ring.h"
+#include "uring.h"
+
+namespace hft {
+
+// Byte transport under OmsEngine and SimExServer. Every connection type has the same
+// shape, so both are templates over it and the choice is made once, at startup:
+//
+//   bool attach(int fd, int doorbell_fd = -1)  adopt a connected socket (owned from here)
+//   bool established()                         attach() has finished setting up; until
+//                                              then poll() only advances the setup and
+//                                              can_send() is false
+//   int wait_fd()                              readable whenever poll(0) has work, so
+//                                              many connections can share one epoll
+//   bool poll(int timeout_ms, OnFrame)         wait up to timeout_ms (-1: forever) for
+//                                              input, hand each whole inbound frame to
+//                                              OnFrame(std::span<const uint8_t>); false
+//                                              once the peer is gone
+//   bool can_send(size_t payload) / send(msg)  room for payload bytes of frames / queue one
+//   bool empty() / flushable() / flush()       nothing queued / a flush would write now /
+//                                              start writing what is queued
+//   static constexpr bool kBusyPoll            wait_fd() does not signal frames: the
+//                                              caller must keep calling poll()
+//
+// A doorbell eventfd, if given, only wakes poll(); the caller checks its own queues.
+enum class TransportKind : uint8_t {
+    Epoll,        // non-blocking socket, a syscall per read and write, epoll readiness
+    Uring,        // io_uring: multishot recv, provided buffers, fixed-buffer linked sends
+    UringSqpoll,  // as Uring, with a kernel SQ thread so submission needs no syscall
+    Shm,          // shared-memory rings, busy-polled: no syscalls at all
+    ShmFutex,     // as Shm, but an idle reader sleeps on a futex until written to
+};
+
+inline bool parse_transport(std::string_view s, TransportKind& out) {
+    if (s == "epoll") {
+        out = TransportKind::Epoll;
+    } else if (s == "uring") {
+        out = TransportKind::Uring;
+    } else if (s == "uring-sqpoll") {
+        out = TransportKind::UringSqpoll;
+    } else if (s == "shm") {
+        out = TransportKind::Shm;
+    } else if (s == "shm-futex") {
+        out = TransportKind::ShmFutex;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+struct TransportOptions {
+    bool sqpoll = false;
+    bool futex = false;  // shm: futex doorbells
+};
+
+constexpr size_t kSocketBufBytes = 64 * 1024;  // per direction, per connection
+
+// Blocking connect to 127.0.0.1:port; the socket or -1.
+inline int connect_loopback(int port) {
+    int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        perror("socket");
+        return -1;
+    }
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(static_cast<uint16_t>(port));
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+        perror("connect");
+        ::close(fd);
+        return -1;
+    }
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    return fd;
+}
+
+namespace detail {
+
+// Feeds received bytes through a FrameReader; false if the peer sent garbage.
+template <size_t Capacity, typename OnFrame>
+bool feed_frames(FrameReader<Capacity>& rx, std::span<const uint8_t> data, OnFrame& on_frame) {
+    while (!data.empty()) {
+        auto area = rx.write_area();
+        const size_t n = std::min(area.size(), data.size());
+        std::memcpy(area.data(), data.data(), n);
+        rx.commit(n);
+        data = data.subspan(n);
+        std::span<const uint8_t> payload;
+        while (rx.next_frame(payload)) on_frame(payload);
+        if (rx.error()) return false;
+    }
+    return true;
+}
+
+}  // namespace detail
+
+// Non-blocking socket under edge-triggered epoll. Unsent bytes stay queued until
+// EPOLLOUT; nothing ever sleeps on the socket.
+class EpollConnection {
+public:
+    static constexpr bool kBusyPoll = false;
+
+    explicit EpollConnection(TransportOptions = {}) {}
+    ~EpollConnection() {
+        if (fd_ >= 0) ::close(fd_);
+        if (epoll_fd_ >= 0) ::close(epoll_fd_);
+    }
+
+    EpollConnection(const EpollConnection&) = delete;
+    EpollConnection& operator=(const EpollConnection&) = delete;
+
+    bool attach(int fd, int doorbell_fd = -1) {
+        fd_ = fd;
+        ::fcntl(fd_, F_SETFL, ::fcntl(fd_, F_GETFL, 0) | O_NONBLOCK);
+        epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+        if (epoll_fd_ < 0) {
+            perror("epoll_create1");
+            return false;
+        }
+        doorbell_fd_ = doorbell_fd;
+        if (doorbell_fd_ >= 0) {
+            epoll_event ev{};
+            ev.events = EPOLLIN;
+            ev.data.fd = doorbell_fd_;
+            epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, doorbell_fd_, &ev);
+        }
+        epoll_event sev{};
+        sev.events = EPOLLIN | EPOLLOUT | EPOLLET;
+        sev.data.fd = fd_;
+        epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd_, &sev);
+        return true;
+    }
+
+    bool established() const { return true; }
+    int wait_fd() const { return epoll_fd_; }
+
+    template <typename OnFrame>
+    bool poll(int timeout_ms, OnFrame&& on_frame) {
+        constexpr int kMaxEvents = 8;
+        epoll_event events[kMaxEvents];
+        int nfds = epoll_wait(epoll_fd_, events, kMaxEvents, timeout_ms);
+        if (nfds < 0) {
+            if (errno == EINTR) return true;
+            perror("epoll_wait");
+            return false;
+        }
+        for (int i = 0; i < nfds; ++i) {
+            if (events[i].data.fd == doorbell_fd_) {
+                eventfd_t v;
+                while (eventfd_read(doorbell_fd_, &v) == 0) {
+                }
+            } else {
+                if (events[i].events & EPOLLIN) read_frames(on_frame);
+                if (events[i].events & EPOLLOUT) blocked_ = false;
+            }
+        }
+        return !closed_;
+    }
+
+    bool can_send(size_t payload) const { return tx_.fits(payload); }
+    template <typename Msg>
+    void send(const Msg& msg) {
+        tx_.append(msg);
+    }
+    bool empty() const { return tx_.empty(); }
+    bool flushable() const { return !tx_.empty() && !blocked_; }
+
+    // Writes until the buffer is empty or the socket is full. Partial writes just
+    // advance the buffer; EAGAIN parks the rest until EPOLLOUT.
+    void flush() {
+        while (!tx_.empty()) {
+            auto out = tx_.pending();
+            ssize_t n = ::send(fd_, out.data(), out.size(), MSG_NOSIGNAL);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                    blocked_ = true;
+                    return;
+                }
+                perror("send");
+                tx_.clear();
+                closed_ = true;
+                return;
+            }
+            tx_.consume(static_cast<size_t>(n));
+        }
+    }
+
+private:
+    template <typename OnFrame>
+    void read_frames(OnFrame& on_frame) {
+        for (;;) {
+            auto area = rx_.write_area();
+            ssize_t n = ::recv(fd_, area.data(), area.size(), 0);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                if (errno == EAGAIN || errno == EWOULDBLOCK) return;
+                perror("recv");
+                closed_ = true;
+                return;
+            }
+            if (n == 0) {
+                closed_ = true;
+                return;
+            }
+            rx_.commit(static_cast<size_t>(n));
+            std::span<const uint8_t> payload;
+            while (rx_.next_frame(payload)) on_frame(payload);
+            if (rx_.error()) {
+                std::cerr << "oversized frame from peer\n";
+                closed_ = true;
+                return;
+            }
+        }
+    }
+
+    int fd_ = -1;
+    int epoll_fd_ = -1;
+    int doorbell_fd_ = -1;
+    bool blocked_ = false;  // socket returned EAGAIN; wait for EPOLLOUT
+    bool closed_ = false;
+    FrameReader<kSocketBufBytes> rx_;
+    FrameWriter<kSocketBufBytes> tx_;
+};
+
+// io_uring connection. Receive is one multishot recv drawing from a provided-buffer
+// ring, so it is armed once and every arrival is just a CQE. Sends are framed straight
+// into slots of a registered buffer and written with WRITE_FIXED, one linked chain at a
+// time so the bytes stay in order; a short write cancels the rest of the chain, which is
+// resubmitted from where the socket stopped. With SQPOLL and traffic flowing, neither
+// direction makes a syscall.
+class UringConnection {
+public:
+    static constexpr bool kBusyPoll = false;
+
+    explicit UringConnection(TransportOptions opts = {}) : sqpoll_(opts.sqpoll) {}
+    ~UringConnection() {
+        ring_.close();
+        if (fd_ >= 0) ::close(fd_);
+    }
+
+    UringConnection(const UringConnection&) = delete;
+    UringConnection& operator=(const UringConnection&) = delete;
+
+    bool attach(int fd, int doorbell_fd = -1) {
+        fd_ = fd;
+        if (!ring_.init(kRingEntries, sqpoll_)) {
+            perror("io_uring_setup");
+            return false;
+        }
+        tx_mem_ = std::make_unique<uint8_t[]>(kSlots * kSlotBytes);
+        const iovec iov{tx_mem_.get(), kSlots * kSlotBytes};
+        if (int rc = ring_.register_buffers({&iov, 1}); rc < 0) {
+            std::cerr << "io_uring register buffers: " << std::strerror(-rc) << "\n";
+            return false;
+        }
+        if (!bufs_.init(ring_, kBufGroup, kRecvBufs, kRecvBufBytes)) {
+            perror("io_uring provided buffers");
+            return false;
+        }
+        arm_recv();
+        doorbell_fd_ = doorbell_fd;
+        if (doorbell_fd_ >= 0) arm_doorbell();
+        return ring_.submit() >= 0;
+    }
+
+    bool established() const { return true; }
+    int wait_fd() const { return ring_.fd(); }
+
+    template <typename OnFrame>
+    bool poll(int timeout_ms, OnFrame&& on_frame) {
+        if (reap(on_frame) == 0 && timeout_ms != 0 && !closed_) {
+            ring_.submit(1, timeout_ms);
+            reap(on_frame);
+        }
+        ring_.submit();  // anything re-armed or resubmitted while reaping
+        return !closed_;
+    }
+
+    bool can_send(size_t payload) const {
+        const size_t frame = kFrameHeader + payload;
+        const size_t spare_slots = kSlots - (tail_ - head_);
+        if (frame <= kSlotBytes) return fill().len + frame <= kSlotBytes || spare_slots > 0;
+        return kSlotBytes - fill().len + spare_slots * kSlotBytes >= frame;  // headroom query
+    }
+
+    template <typename Msg>
+    void send(const Msg& msg) {
+        static_assert(std::is_trivially_copyable_v<Msg>);
+        constexpr size_t kFrame = kFrameHeader + sizeof(Msg);
+        static_assert(kFrame <= kSlotBytes);
+        if (fill().len + kFrame > kSlotBytes) {
+            ++tail_;
+            fill() = {};
+        }
+        Slot& s = fill();
+        uint8_t* p = slot_data(tail_ - 1) + s.len;
+        const uint32_t be_len = htonl(static_cast<uint32_t>(sizeof(Msg)));
+        std::memcpy(p, &be_len, sizeof(be_len));
+        std::memcpy(p + kFrameHeader, &msg, sizeof(Msg));
+        s.len += kFrame;
+        unsent_ += kFrame;
+    }
+
+    bool empty() const { return unsent_ == 0; }
+    bool flushable() const { return unsent_ > 0 && inflight_ == 0 && !closed_; }
+
+    // Submits every unsent byte as one linked chain of WRITE_FIXEDs, one per slot.
+    // Bytes appended to a slot while it is in flight go out in the next chain.
+    void flush() {
+        if (!flushable()) return;
+        io_uring_sqe* prev = nullptr;
+        for (unsigned i = head_; i != tail_; ++i) {
+            Slot& s = slot(i);
+            if (s.sent == s.len) continue;
+            io_uring_sqe* sqe = ring_.get_sqe();
+            if (sqe == nullptr) break;  // the rest follows once this chain completes
+            sqe->opcode = IORING_OP_WRITE_FIXED;
+            sqe->fd = fd_;
+            sqe->addr = reinterpret_cast<uint64_t>(slot_data(i) + s.sent);
+            sqe->len = s.len - s.sent;
+            sqe->buf_index = 0;
+            sqe->user_data = i & (kSlots - 1);
+            s.submitted = s.len;
+            if (prev != nullptr) prev->flags |= IOSQE_IO_LINK;
+            prev = sqe;
+            ++inflight_;
+        }
+        ring_.submit();
+    }
+
+private:
+    static constexpr unsigned kRingEntries = 64;
+    static constexpr unsigned kSlots = 16;  // power of two
+    static constexpr size_t kSlotBytes = 4096;
+    static constexpr uint16_t kBufGroup = 0;
+    static constexpr unsigned kRecvBufs = 64;  // power of two
+    static constexpr unsigned kRecvBufBytes = 4096;
+    static constexpr uint64_t kTagRecv = uint64_t{1} << 32;
+    static constexpr uint64_t kTagDoorbell = uint64_t{2} << 32;
+
+    struct Slot {
+        uint32_t len = 0;        // bytes framed into the slot
+        uint32_t sent = 0;       // bytes the socket has taken
+        uint32_t submitted = 0;  // len when last submitted
+    };
+
+    Slot& slot(unsigned i) { return slots_[i & (kSlots - 1)]; }
+    const Slot& slot(unsigned i) const { return slots_[i & (kSlots - 1)]; }
+    Slot& fill() { return slot(tail_ - 1); }
+    const Slot& fill() const { return slot(tail_ - 1); }
+    uint8_t* slot_data(unsigned i) { return tx_mem_.get() + (i & (kSlots - 1)) * kSlotBytes; }
+
+    void arm_recv() {
+        io_uring_sqe* sqe = ring_.get_sqe();
+        if (sqe == nullptr) {
+            ring_.submit();
+            sqe = ring_.get_sqe();
+        }
+        sqe->opcode = IORING_OP_RECV;
+        sqe->fd = fd_;
+        sqe->flags = IOSQE_BUFFER_SELECT;
+        sqe->buf_group = kBufGroup;
+        sqe->ioprio = IORING_RECV_MULTISHOT;
+        sqe->user_data = kTagRecv;
+    }
+
+    // Multishot poll: the eventfd is drained with a plain read only after it fired.
+    void arm_doorbell() {
+        io_uring_sqe* sqe = ring_.get_sqe();
+        if (sqe == nullptr) {
+            ring_.submit();
+            sqe = ring_.get_sqe();
+        }
+        sqe->opcode = IORING_OP_POLL_ADD;
+        sqe->fd = doorbell_fd_;
+        sqe->poll32_events = POLLIN;
+        sqe->len = IORING_POLL_ADD_MULTI;
+        sqe->user_data = kTagDoorbell;
+    }
+
+    template <typename OnFrame>
+    unsigned reap(OnFrame& on_frame) {
+        return ring_.reap([&](const io_uring_cqe& cqe) {
+            if (cqe.user_data == kTagRecv) {
+                on_recv(cqe, on_frame);
+            } else if (cqe.user_data == kTagDoorbell) {
+                eventfd_t v;
+                while (eventfd_read(doorbell_fd_, &v) == 0) {
+                }
+                if (!(cqe.flags & IORING_CQE_F_MORE)) arm_doorbell();
+            } else {
+                on_sent(static_cast<unsigned>(cqe.user_data), cqe.res);
+            }
+        });
+    }
+
+    template <typename OnFrame>
+    void on_recv(const io_uring_cqe& cqe, OnFrame& on_frame) {
+        if (cqe.res > 0 && (cqe.flags & IORING_CQE_F_BUFFER)) {
+            const auto bid = static_cast<uint16_t>(cqe.flags >> IORING_CQE_BUFFER_SHIFT);
+            if (!detail::feed_frames(rx_, bufs_.buffer(bid, static_cast<size_t>(cqe.res)), on_frame)) {
+                std::cerr << "oversized frame from peer\n";
+                closed_ = true;
+            }
+            bufs_.recycle(bid);
+        } else if (cqe.res == 0) {
+            closed_ = true;
+        } else if (cqe.res < 0 && cqe.res != -ENOBUFS) {
+            std::cerr << "io_uring recv: " << std::strerror(-cqe.res) << "\n";
+            closed_ = true;
+        }
+        if (!closed_ && !(cqe.flags & IORING_CQE_F_MORE)) arm_recv();
+    }
+
+    void on_sent(unsigned slot_index, int res) {
+        --inflight_;
+        Slot& s = slots_[slot_index];
+        if (res > 0) {
+            s.sent += static_cast<uint32_t>(res);
+            unsent_ -= static_cast<size_t>(res);
+        } else if (res != -ECANCELED && res != -EAGAIN && res != -EINTR) {
+            std::cerr << "io_uring send: " << std::strerror(-res) << "\n";
+            closed_ = true;
+        }
+        if (s.sent < s.submitted) chain_cut_ = true;
+        if (inflight_ != 0) return;
+        while (tail_ - head_ > 1 && slot(head_).sent == slot(head_).len) ++head_;
+        if (tail_ - head_ == 1 && fill().sent == fill().len) fill() = {};
+        // A short write cancels the rest of the chain: finish what flush() was asked to
+        // send. Bytes framed while the chain was in flight wait for the owner's flush().
+        if (chain_cut_) {
+            chain_cut_ = false;
+            flush();
+        }
+    }
+
+    bool sqpoll_;
+    int fd_ = -1;
+    int doorbell_fd_ = -1;
+    bool closed_ = false;
+    ProvidedBuffers bufs_;
+    Uring ring_;
+    FrameReader<kSocketBufBytes> rx_;
+    std::unique_ptr<uint8_t[]> tx_mem_;
+    std::array<Slot, kSlots> slots_{};
+    unsigned head_ = 0;  // oldest slot with bytes not yet taken by the socket
+    unsigned tail_ = 1;  // one past the slot being filled
+    unsigned inflight_ = 0;
+    bool chain_cut_ = false;
+    size_t unsent_ = 0;
+};
+
+// Shared-memory connection: frames go through a pair of ShmRings, one per direction,
+// with no kernel on the path. The connected socket is only used to set them up and,
+// after that, to notice the peer going away. Each side creates the ring it reads from,
+// sends its name, and maps the ring named by the peer; once both have mapped, the
+// names are removed, so nothing is left in /dev/shm. The exchange never blocks:
+// attach() starts it and poll() moves it on as the peer's bytes arrive, so a server
+// can set up many clients from one event loop. Setup that takes longer than
+// kSetupTimeoutNs fails.
+//
+// Busy-polled: poll() returns at once and the caller loops. With futex doorbells, a
+// reader that has found nothing for kSpinNs sleeps on its ring until the peer
+// publishes. A doorbell eventfd cannot wake a futex, so with one attached the sleep is
+// cut to kDoorbellSliceNs and the caller's queues are seen that late at worst.
+class ShmConnection {
+public:
+    static constexpr bool kBusyPoll = true;
+
+    explicit ShmConnection(TransportOptions opts = {}) : futex_(opts.futex) {}
+    ~ShmConnection() {
+        tx_.close();
+        if (!name_.empty()) ::shm_unlink(name_.c_str());
+        if (fd_ >= 0) ::close(fd_);
+    }
+
+    ShmConnection(const ShmConnection&) = delete;
+    ShmConnection& operator=(const ShmConnection&) = delete;
+
+    // False if setup fails before it has to wait on the peer.
+    bool attach(int fd, int doorbell_fd = -1) {
+        fd_ = fd;
+        doorbell_fd_ = doorbell_fd;
+        ::fcntl(fd_, F_SETFL, ::fcntl(fd_, F_GETFL, 0) | O_NONBLOCK);
+        static std::atomic<uint32_t> next_region{0};
+        std::string name = "/hft_shm." + std::to_string(::getpid()) + "." + std::to_string(next_region.fetch_add(1));
+        if (!rx_region_.create(name.c_str())) {
+            perror("shm_open");
+            return false;
+        }
+        name_ = std::move(name);
+        rx_.attach(rx_region_.ring());
+        setup_out_.push_back(static_cast<char>(name_.size()));
+        setup_out_ += name_;
+        setup_deadline_ns_ = clock_ns() + kSetupTimeoutNs;
+        return advance_setup();
+    }
+
+    bool established() const { return tx_region_.ring() != nullptr && peer_mapped_ && setup_out_.empty(); }
+
+    // Readable while the peer's setup bytes arrive, then only once it hangs up.
+    int wait_fd() const { return fd_; }
+
+    template <typename OnFrame>
+    bool poll(int timeout_ms, OnFrame&& on_frame) {
+        if (!established()) {
+            // Nothing else to do until setup is done, so wait on the socket, not spin.
+            if (timeout_ms != 0 && !closed_) {
+                pollfd pfd{fd_, POLLIN, 0};
+                const int64_t left_ms = (setup_deadline_ns_ - clock_ns()) / 1'000'000 + 1;
+                const int64_t wait_ms = timeout_ms < 0 ? left_ms : std::min<int64_t>(timeout_ms, left_ms);
+                ::poll(&pfd, 1, static_cast<int>(std::max<int64_t>(wait_ms, 0)));
+            }
+            if (!closed_ && !advance_setup()) closed_ = true;
+            return !closed_;
+        }
+        long frames = rx_.drain(on_frame);
+        if (frames == 0 && futex_ && timeout_ms != 0) {
+            const int64_t now = clock_ns();
+            if (idle_since_ns_ == 0) idle_since_ns_ = now;
+            if (now - idle_since_ns_ >= kSpinNs) {
+                int64_t sleep_ns = timeout_ms < 0 ? kLivenessCheckNs : int64_t{timeout_ms} * 1'000'000;
+                if (doorbell_fd_ >= 0) sleep_ns = std::min(sleep_ns, kDoorbellSliceNs);
+                rx_.park(sleep_ns);
+                frames = rx_.drain(on_frame);
+            }
+        }
+        if (frames < 0) {
+            std::cerr << "corrupt frame from peer\n";
+            closed_ = true;
+        } else if (frames > 0) {
+            idle_since_ns_ = 0;
+        } else {
+            check_peer();
+        }
+        return !closed_;
+    }
+
+    bool can_send(size_t payload) const {
+        if (!established()) return false;
+        const size_t spare = tx_.free_slots();
+        if (payload <= ShmSlot::kPayloadBytes) return spare > 0;
+        return spare * ShmSlot::kPayloadBytes >= payload;  // headroom query
+    }
+
+    template <typename Msg>
+    void send(const Msg& msg) {
+        static_assert(std::is_trivially_copyable_v<Msg>);
+        static_assert(sizeof(Msg) <= ShmSlot::kPayloadBytes);
+        ShmSlot& slot = tx_.claim();
+        slot.len = sizeof(Msg);
+        std::memcpy(slot.payload, &msg, sizeof(Msg));
+    }
+
+    bool empty() const { return !tx_.unpublished(); }
+    bool flushable() const { return tx_.unpublished() && !closed_; }
+    void flush() { tx_.publish(futex_); }
+
+    // Sleeps until any of conns is written to, for at most timeout_ns. For a caller
+    // serving many connections that found all of them idle; a no-op without futexes.
+    static void park_any(std::span<ShmConnection* const> conns, int64_t timeout_ns) {
+        if (conns.empty() || !conns.front()->futex_) return;
+        std::array<ShmConsumer*, FUTEX_WAITV_MAX> rx{};
+        const size_t n = std::min<size_t>(conns.size(), rx.size());
+        for (size_t i = 0; i < n; ++i) rx[i] = &conns[i]->rx_;
+        ShmConsumer::park_any(std::span<ShmConsumer* const>(rx.data(), n), timeout_ns);
+    }
+
+private:
+    static constexpr int64_t kSpinNs = 50'000;
+    static constexpr int64_t kDoorbellSliceNs = 100'000;
+    static constexpr int64_t kLivenessCheckNs = 1'000'000;
+    static constexpr int64_t kSetupTimeoutNs = 2'000'000'000;
+
+    static int64_t clock_ns() {
+        timespec ts{};
+        ::clock_gettime(CLOCK_MONOTONIC, &ts);
+        return ts.tv_sec * 1'000'000'000 + ts.tv_nsec;
+    }
+
+    // Setup, as far as the socket allows without blocking. Each side sends its ring's
+    // name, maps the peer's ring once its name is in, and acks that with one byte;
+    // the peer's ack means ours is mapped, so our name can go. False on failure.
+    bool advance_setup() {
+        char buf[256];
+        for (;;) {
+            const ssize_t r = ::recv(fd_, buf, sizeof(buf), 0);
+            if (r < 0 && errno == EINTR) continue;
+            if (r < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+            if (r <= 0) return fail_setup();
+            setup_in_.append(buf, static_cast<size_t>(r));
+        }
+        if (tx_region_.ring() == nullptr && !setup_in_.empty()) {
+            const auto len = static_cast<uint8_t>(setup_in_.front());
+            if (len == 0) return fail_setup();
+            if (setup_in_.size() > len) {
+                const std::string peer = setup_in_.substr(1, len);
+                setup_in_.erase(0, size_t{len} + 1);
+                if (peer.front() != '/' || !tx_region_.open(peer.c_str())) {
+                    perror("shm_open peer");
+                    return fail_setup();
+                }
+                // Attached as soon as it is mapped, so the peer sees the close if setup fails.
+                tx_.attach(tx_region_.ring());
+                setup_out_.push_back(1);
+            }
+        }
+        if (tx_region_.ring() != nullptr && !peer_mapped_ && !setup_in_.empty()) {
+            if (setup_in_.front() != 1) return fail_setup();
+            setup_in_.erase(0, 1);
+            peer_mapped_ = true;
+            ::shm_unlink(name_.c_str());
+            name_.clear();
+        }
+        while (!setup_out_.empty()) {
+            const ssize_t w = ::send(fd_, setup_out_.data(), setup_out_.size(), MSG_NOSIGNAL);
+            if (w < 0 && errno == EINTR) continue;
+            if (w < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+            if (w <= 0) return fail_setup();
+            setup_out_.erase(0, static_cast<size_t>(w));
+        }
+        if (!established() && clock_ns() >= setup_deadline_ns_) return fail_setup();
+        return true;
+    }
+
+    bool fail_setup() {
+        std::cerr << "shm handshake with peer failed\n";
+        return false;
+    }
+
+    // A clean close marks the ring; a crash only shows on the socket, which costs a
+    // syscall, so that is looked at once per kLivenessCheckNs while idle.
+    void check_peer() {
+        if (rx_.closed()) {
+            closed_ = true;
+            return;
+        }
+        const int64_t now = clock_ns();
+        if (now < next_liveness_check_ns_) return;
+        next_liveness_check_ns_ = now + kLivenessCheckNs;
+        uint8_t b;
+        const ssize_t r = ::recv(fd_, &b, 1, MSG_PEEK | MSG_DONTWAIT);
+        if (r == 0 || (r < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) closed_ = true;
+    }
+
+    bool futex_;
+    int fd_ = -1;
+    int doorbell_fd_ = -1;
+    bool closed_ = false;
+    ShmRegion rx_region_;
+    ShmRegion tx_region_;
+    ShmConsumer rx_;
+    ShmProducer tx_;
+    int64_t idle_since_ns_ = 0;
+    int64_t next_liveness_check_ns_ = 0;
+    // Setup: our ring's name until the peer has mapped it, and the bytes either way.
+    std::string name_;
+    std::string setup_out_;
+    std::string setup_in_;
+    bool peer_mapped_ = false;
+    int64_t setup_deadline_ns_ = 0;
+};
+
+}  // namespace hft
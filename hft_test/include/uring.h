@@ -0,0 +1,267 @@
+#pragma once
+
+#include <linux/io_uring.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+#include <span>
+
+namespace hft {
+
+// Minimal io_uring over the raw syscalls, so hft_test keeps building with no liburing:
+// ring setup and mapping, SQE allocation, submit/wait, CQE reaping, and the buffer
+// registrations the transports use. One thread owns a ring.
+class Uring {
+public:
+    Uring() = default;
+    ~Uring() { close(); }
+
+    Uring(const Uring&) = delete;
+    Uring& operator=(const Uring&) = delete;
+
+    // entries SQEs, 8x that many CQEs (multishot recv posts many per SQE). With sqpoll
+    // a kernel thread consumes the SQ, so submissions need no syscall while it is awake.
+    bool init(unsigned entries, bool sqpoll) {
+        io_uring_params p{};
+        p.flags = IORING_SETUP_CQSIZE;
+        p.cq_entries = entries * 8;
+        if (sqpoll) {
+            p.flags |= IORING_SETUP_SQPOLL;
+            p.sq_thread_idle = 2000;  // ms before the SQ thread sleeps and needs a wakeup
+        }
+        fd_ = static_cast<int>(::syscall(__NR_io_uring_setup, entries, &p));
+        if (fd_ < 0) return false;
+        sqpoll_ = sqpoll;
+
+        sq_map_len_ = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+        cq_map_len_ = p.cq_off.cqes + p.cq_entries * sizeof(io_uring_cqe);
+        const bool single = (p.features & IORING_FEAT_SINGLE_MMAP) != 0;
+        if (single) sq_map_len_ = cq_map_len_ = std::max(sq_map_len_, cq_map_len_);
+        sq_map_ = map(sq_map_len_, IORING_OFF_SQ_RING);
+        cq_map_ = single ? sq_map_ : map(cq_map_len_, IORING_OFF_CQ_RING);
+        sqes_len_ = p.sq_entries * sizeof(io_uring_sqe);
+        sqes_ = static_cast<io_uring_sqe*>(map(sqes_len_, IORING_OFF_SQES));
+        if (sq_map_ == nullptr || cq_map_ == nullptr || sqes_ == nullptr) {
+            close();
+            return false;
+        }
+
+        auto* sq = static_cast<uint8_t*>(sq_map_);
+        sq_head_ = reinterpret_cast<unsigned*>(sq + p.sq_off.head);
+        sq_tail_ = reinterpret_cast<unsigned*>(sq + p.sq_off.tail);
+        sq_flags_ = reinterpret_cast<unsigned*>(sq + p.sq_off.flags);
+        sq_mask_ = *reinterpret_cast<unsigned*>(sq + p.sq_off.ring_mask);
+        sq_entries_ = p.sq_entries;
+        auto* array = reinterpret_cast<unsigned*>(sq + p.sq_off.array);
+        for (unsigned i = 0; i < p.sq_entries; ++i) array[i] = i;
+        sqe_tail_ = published_ = *sq_tail_;
+
+        auto* cq = static_cast<uint8_t*>(cq_map_);
+        cq_head_ = reinterpret_cast<unsigned*>(cq + p.cq_off.head);
+        cq_tail_ = reinterpret_cast<unsigned*>(cq + p.cq_off.tail);
+        cq_mask_ = *reinterpret_cast<unsigned*>(cq + p.cq_off.ring_mask);
+        cqes_ = reinterpret_cast<io_uring_cqe*>(cq + p.cq_off.cqes);
+        return true;
+    }
+
+    void close() {
+        if (sqes_ != nullptr) ::munmap(sqes_, sqes_len_);
+        if (cq_map_ != nullptr && cq_map_ != sq_map_) ::munmap(cq_map_, cq_map_len_);
+        if (sq_map_ != nullptr) ::munmap(sq_map_, sq_map_len_);
+        if (fd_ >= 0) ::close(fd_);
+        sqes_ = nullptr;
+        sq_map_ = cq_map_ = nullptr;
+        fd_ = -1;
+    }
+
+    int fd() const { return fd_; }
+
+    // Zeroed SQE, or nullptr when the SQ is full (submit() and retry).
+    io_uring_sqe* get_sqe() {
+        const unsigned head = std::atomic_ref<unsigned>(*sq_head_).load(std::memory_order_acquire);
+        if (sqe_tail_ - head >= sq_entries_) return nullptr;
+        io_uring_sqe* sqe = &sqes_[sqe_tail_ & sq_mask_];
+        ++sqe_tail_;
+        std::memset(sqe, 0, sizeof(*sqe));
+        return sqe;
+    }
+
+    // Publishes queued SQEs and, if wait_nr > 0, blocks for that many CQEs or timeout_ms.
+    // Enters the kernel only when it has to: always without SQPOLL if there is something
+    // to submit, with SQPOLL only to wake a sleeping SQ thread or to wait.
+    int submit(unsigned wait_nr = 0, int timeout_ms = -1) {
+        const unsigned to_submit = sqe_tail_ - published_;
+        std::atomic_ref<unsigned>(*sq_tail_).store(sqe_tail_, std::memory_order_release);
+        published_ = sqe_tail_;
+
+        unsigned flags = 0;
+        if (sqpoll_) {
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (std::atomic_ref<unsigned>(*sq_flags_).load(std::memory_order_relaxed) & IORING_SQ_NEED_WAKEUP) {
+                flags |= IORING_ENTER_SQ_WAKEUP;
+            }
+        }
+        const bool overflow =
+            (std::atomic_ref<unsigned>(*sq_flags_).load(std::memory_order_relaxed) & IORING_SQ_CQ_OVERFLOW) != 0;
+        if (wait_nr > 0 || overflow) flags |= IORING_ENTER_GETEVENTS;
+        const bool need_enter = flags != 0 || (!sqpoll_ && to_submit > 0);
+        if (!need_enter) return 0;
+
+        long ret;
+        if (wait_nr > 0 && timeout_ms >= 0) {
+            __kernel_timespec ts{};
+            ts.tv_sec = timeout_ms / 1000;
+            ts.tv_nsec = static_cast<long long>(timeout_ms % 1000) * 1'000'000;
+            io_uring_getevents_arg arg{};
+            arg.sigmask_sz = _NSIG / 8;
+            arg.ts = reinterpret_cast<uint64_t>(&ts);
+            ret = ::syscall(__NR_io_uring_enter, fd_, to_submit, wait_nr, flags | IORING_ENTER_EXT_ARG, &arg,
+                            sizeof(arg));
+        } else {
+            ret = ::syscall(__NR_io_uring_enter, fd_, to_submit, wait_nr, flags, nullptr, 0);
+        }
+        if (ret < 0) {
+            if (errno == ETIME || errno == EINTR || errno == EBUSY) return 0;
+            return -errno;
+        }
+        return static_cast<int>(ret);
+    }
+
+    // Hands every available CQE to fn, then releases them together. Returns the count.
+    template <typename Fn>
+    unsigned reap(Fn&& fn) {
+        unsigned head = std::atomic_ref<unsigned>(*cq_head_).load(std::memory_order_relaxed);
+        const unsigned tail = std::atomic_ref<unsigned>(*cq_tail_).load(std::memory_order_acquire);
+        const unsigned n = tail - head;
+        for (; head != tail; ++head) {
+            fn(cqes_[head & cq_mask_]);
+        }
+        std::atomic_ref<unsigned>(*cq_head_).store(head, std::memory_order_release);
+        return n;
+    }
+
+    // Fixed buffers for IORING_OP_{READ,WRITE}_FIXED: pinned once, not per operation.
+    int register_buffers(std::span<const iovec> iov) {
+        return register_op(IORING_REGISTER_BUFFERS, iov.data(), static_cast<unsigned>(iov.size()));
+    }
+
+    int register_op(unsigned op, const void* arg, unsigned nr) {
+        return ::syscall(__NR_io_uring_register, fd_, op, arg, nr) < 0 ? -errno : 0;
+    }
+
+private:
+    void* map(size_t len, off_t offset) {
+        void* p = ::mmap(nullptr, len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd_, offset);
+        return p == MAP_FAILED ? nullptr : p;
+    }
+
+    int fd_ = -1;
+    bool sqpoll_ = false;
+    void* sq_map_ = nullptr;
+    void* cq_map_ = nullptr;
+    size_t sq_map_len_ = 0;
+    size_t cq_map_len_ = 0;
+    io_uring_sqe* sqes_ = nullptr;
+    size_t sqes_len_ = 0;
+    unsigned* sq_head_ = nullptr;
+    unsigned* sq_tail_ = nullptr;
+    unsigned* sq_flags_ = nullptr;
+    unsigned sq_mask_ = 0;
+    unsigned sq_entries_ = 0;
+    unsigned sqe_tail_ = 0;   // next SQE to hand out
+    unsigned published_ = 0;  // SQ tail the kernel has seen
+    unsigned* cq_head_ = nullptr;
+    unsigned* cq_tail_ = nullptr;
+    unsigned cq_mask_ = 0;
+    io_uring_cqe* cqes_ = nullptr;
+};
+
+// Provided-buffer ring (IORING_REGISTER_PBUF_RING): the kernel picks a buffer for each
+// recv completion from this pool, and the owner hands it back once the bytes are used,
+// so a multishot recv never waits on the application to post a buffer.
+class ProvidedBuffers {
+public:
+    ProvidedBuffers() = default;
+    ~ProvidedBuffers() { release(); }
+
+    ProvidedBuffers(const ProvidedBuffers&) = delete;
+    ProvidedBuffers& operator=(const ProvidedBuffers&) = delete;
+
+    // count must be a power of two.
+    bool init(Uring& ring, uint16_t group, unsigned count, unsigned size) {
+        count_ = count;
+        size_ = size;
+        ring_len_ = count * sizeof(io_uring_buf);
+        data_len_ = static_cast<size_t>(count) * size;
+        void* r = ::mmap(nullptr, ring_len_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        void* d = ::mmap(nullptr, data_len_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (r == MAP_FAILED || d == MAP_FAILED) {
+            if (r != MAP_FAILED) ::munmap(r, ring_len_);
+            if (d != MAP_FAILED) ::munmap(d, data_len_);
+            return false;
+        }
+        bufs_ = static_cast<io_uring_buf_ring*>(r);
+        data_ = static_cast<uint8_t*>(d);
+
+        io_uring_buf_reg reg{};
+        reg.ring_addr = reinterpret_cast<uint64_t>(bufs_);
+        reg.ring_entries = count;
+        reg.bgid = group;
+        if (ring.register_op(IORING_REGISTER_PBUF_RING, &reg, 1) < 0) {
+            release();
+            return false;
+        }
+        for (unsigned i = 0; i < count; ++i) add(static_cast<uint16_t>(i));
+        publish();
+        return true;
+    }
+
+    std::span<const uint8_t> buffer(uint16_t bid, size_t len) const {
+        return {data_ + static_cast<size_t>(bid) * size_, len};
+    }
+
+    // Returns a buffer to the kernel.
+    void recycle(uint16_t bid) {
+        add(bid);
+        publish();
+    }
+
+private:
+    void add(uint16_t bid) {
+        // Not bufs_->bufs[]: in C++ the uapi flex-array wrapper shifts it by 8 bytes.
+        io_uring_buf& b = reinterpret_cast<io_uring_buf*>(bufs_)[tail_ & (count_ - 1)];
+        b.addr = reinterpret_cast<uint64_t>(data_ + static_cast<size_t>(bid) * size_);
+        b.len = size_;
+        b.bid = bid;
+        ++tail_;
+    }
+
+    void publish() { std::atomic_ref<uint16_t>(bufs_->tail).store(tail_, std::memory_order_release); }
+
+    void release() {
+        if (bufs_ != nullptr) ::munmap(bufs_, ring_len_);
+        if (data_ != nullptr) ::munmap(data_, data_len_);
+        bufs_ = nullptr;
+        data_ = nullptr;
+    }
+
+    io_uring_buf_ring* bufs_ = nullptr;
+    uint8_t* data_ = nullptr;
+    size_t ring_len_ = 0;
+    size_t data_len_ = 0;
+    unsigned count_ = 0;
+    unsigned size_ = 0;
+    uint16_t tail_ = 0;
+};
+
+}  // namespace hft
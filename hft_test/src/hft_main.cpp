@@ -1,240 +1,422 @@
-#include <arpa/inet.h>
-#include <errno.h>
-#include <fcntl.h>
-#include <netinet/in.h>
-#include <sys/epoll.h>
 #include <sys/eventfd.h>
-#include <sys/socket.h>
 #include <unistd.h>
 
+#include <algorithm>
+#include <array>
+#include <bit>
 #include <chrono>
+#include <cmath>
 #include <cstring>
 #include <functional>
 #include <iostream>
-#include <map>
+#include <memory>
 #include <optional>
-#include <random>
+#include <span>
 #include <string>
 #include <thread>
-#include <unordered_map>
 #include <vector>
 
+#include "affinity.h"
 #include "hft_common.h"
+#include "market_data.h"
+#include "order_table.h"
 #include "protocol.h"
+#include "signals.h"
 #include "spsc_ring.h"
+#include "telemetry.h"
+#include "transport.h"
 
 namespace hft {
 
 constexpr int kRingDepth = 1024;
-constexpr const char* kSymbol = "BTCUSDT";
-
+// Top kBookDepth levels a side, best first, in inline arrays: a symbol's book is one
+// contiguous block and an update is a short scan and shift. A level pushed below the
+// depth is dropped, as a depth-limited feed would drop it.
 class OrderBook {
 public:
+    static constexpr uint32_t kBookDepth = 16;
+
     void apply(const BookDelta& delta) {
-        for (const auto& lvl : delta.levels) {
-            auto& book = lvl.side == Side::Buy ? bids_ : asks_;
-            if (lvl.qty == 0) {
-                book.erase(lvl.px);
+        for (const auto& lvl : delta.view()) {
+            if (lvl.side == Side::Buy) {
+                bids_.apply(lvl.px, lvl.qty, std::greater<>{});
             } else {
-                book[lvl.px] = lvl.qty;
+                asks_.apply(lvl.px, lvl.qty, std::less<>{});
             }
         }
     }
 
     std::optional<double> mid() const {
-        auto best_bid = best_bid_px();
-        auto best_ask = best_ask_px();
-        if (!best_bid || !best_ask) return std::nullopt;
-        return (static_cast<double>(*best_bid) + static_cast<double>(*best_ask)) / 2.0;
+        if (bids_.count == 0 || asks_.count == 0) return std::nullopt;
+        return (static_cast<double>(bids_.levels[0].px) + static_cast<double>(asks_.levels[0].px)) / 2.0;
     }
 
     std::optional<int64_t> spread() const {
-        auto bid = best_bid_px();
-        auto ask = best_ask_px();
-        if (!bid || !ask) return std::nullopt;
-        return *ask - *bid;
+        if (bids_.count == 0 || asks_.count == 0) return std::nullopt;
+        return asks_.levels[0].px - bids_.levels[0].px;
     }
 
-private:
-    std::optional<int64_t> best_bid_px() const {
-        if (bids_.empty()) return std::nullopt;
-        return bids_.rbegin()->first;
-    }
-    std::optional<int64_t> best_ask_px() const {
-        if (asks_.empty()) return std::nullopt;
-        return asks_.begin()->first;
+    std::optional<TopOfBook> top() const {
+        if (bids_.count == 0 || asks_.count == 0) return std::nullopt;
+        return TopOfBook{bids_.levels[0].px, bids_.levels[0].qty, asks_.levels[0].px, asks_.levels[0].qty};
     }
 
-    std::map<int64_t, int64_t> bids_;  // descending via reverse iteration
-    std::map<int64_t, int64_t> asks_;  // ascending
+private:
+    struct Level {
+        int64_t px = 0;
+        int64_t qty = 0;
+    };
+
+    struct Ladder {
+        std::array<Level, kBookDepth> levels{};
+        uint32_t count = 0;
+
+        // qty 0 deletes the level. Better orders prices best first.
+        template <typename Better>
+        void apply(int64_t px, int64_t qty, Better better) {
+            uint32_t i = 0;
+            while (i < count && better(levels[i].px, px)) ++i;
+            if (i < count && levels[i].px == px) {
+                if (qty == 0) {
+                    std::move(levels.begin() + i + 1, levels.begin() + count, levels.begin() + i);
+                    --count;
+                } else {
+                    levels[i].qty = qty;
+                }
+                return;
+            }
+            if (qty == 0 || i == kBookDepth) return;
+            const uint32_t last = std::min(count, kBookDepth - 1);
+            std::move_backward(levels.begin() + i, levels.begin() + last, levels.begin() + last + 1);
+            levels[i] = Level{px, qty};
+            count = last + 1;
+        }
+    };
+
+    Ladder bids_;
+    Ladder asks_;
 };
 
+// Most resting quotes the strategy keeps per side of a symbol, so at most twice this
+// many orders per symbol are ever live at the OMS.
+constexpr int kMaxQuoteLevels = 4;
+
 struct StrategyConfig {
-    double z_enter = 1.5;
-    double z_exit = 0.2;
-    double tp_ticks = 150;
-    double sl_ticks = -150;
-    int64_t pos_limit = 1;
+    int quote_levels = 3;                   // resting quotes per side
+    int64_t quote_qty = 1;
+    int64_t edge_ticks = 1;                 // first level's distance from fair value
+    int64_t level_step_ticks = 1;           // between levels
+    double skew_ticks_per_z = 1.0;          // shade quotes against fair value's rolling z-score
+    double skew_ticks_per_imbalance = 1.0;  // and toward the heavier side of the book
+    int64_t requote_ticks = 1;              // amend a quote once its target moves this far
+    int64_t pos_limit = 5;                  // stop quoting the side that would go beyond this
     int64_t tick_size = 10;
 };
 
+// Where the strategy's orders go; send() returns false when the order was not taken.
+template <typename G>
+concept OrderGateway = requires(G g, const OrderRequest& req) {
+    { g.send(req) } -> std::same_as<bool>;
+};
+
+// Market maker: quote_levels bids and asks around each symbol's fair value (the
+// microprice), shaded against its z-score over the last kZWindow updates and toward
+// the top-of-book imbalance. Each quote is a slot owning at most one live order, which is placed when the
+// slot is empty, amended in place (replace) when its target price moves, and cancelled
+// while its side would breach the position limit. Fills, cancels and rejects free it.
+//
+// One instance serves a partition of symbols, [first_symbol, first_symbol + count).
+// Each symbol's book and strategy state sit together in one dense array indexed by
+// symbol_id - first_symbol, so an update touches one contiguous block. cl_ord_ids are
+// first_cl_ord_id, + id_stride, ..., so partitions sharing an OMS never collide.
+//
+// Gateway and sink are template parameters so sending and timing inline into the
+// decision path; with NullSink the strategy carries no instrumentation at all.
+template <OrderGateway Gateway, StageSink Sink>
 class Strategy {
 public:
-    Strategy(const StrategyConfig& cfg, std::function<bool(const OrderRequest&)> send_fn)
-        : cfg_(cfg), send_order_(std::move(send_fn)) {}
-
-    void on_book(const BookDelta& delta, OrderBook& ob, Telemetry& tele) {
-        ScopedTimer t("strategy_total", [&](const std::string& name, int64_t ns) { tele.record(name, ns); });
-        ob.apply(delta);
-        auto mid_opt = ob.mid();
-        auto spread_opt = ob.spread();
-        if (!mid_opt || !spread_opt) return;
-
-        double mid = *mid_opt;
-        stats_.add(mid);
+    static constexpr int kMaxLevels = kMaxQuoteLevels;
+    static constexpr size_t kZWindow = 256;  // book updates per symbol
+
+    Strategy(const StrategyConfig& cfg,
+             uint32_t first_symbol,
+             uint32_t symbol_count,
+             uint64_t first_cl_ord_id,
+             uint64_t id_stride,
+             Gateway gateway,
+             Sink sink)
+        : cfg_(cfg),
+          first_symbol_(first_symbol),
+          symbols_(symbol_count),
+          fair_window_(symbol_count),
+          next_cl_ord_id_(first_cl_ord_id),
+          id_stride_(id_stride),
+          gateway_(std::move(gateway)),
+          sink_(sink) {
+        cfg_.quote_levels = std::clamp(cfg_.quote_levels, 1, kMaxLevels);
+    }
+
+    // md_recv_ns: when Thread A took the update, carried on the orders it leads to.
+    void on_book(const BookDelta& delta, int64_t md_recv_ns = 0) {
+        ScopedProbe<Probe::StrategyTotal, Sink> t(sink_);
+        md_recv_ns_ = md_recv_ns;
+        SymbolState* sym = lookup(delta.symbol_id);
+        if (sym == nullptr) return;
+        sym->book.apply(delta);
+        auto top = sym->book.top();
+        if (!top) return;
+
+        const size_t i = delta.symbol_id - first_symbol_;
+        const double fair = microprice(*top);
+        fair_window_.update(i, fair);
         double z = 0.0;
-        double stdev = stats_.stddev();
+        double stdev = fair_window_.stddev(i);
         if (stdev > 0.0) {
-            z = (mid - stats_.mean) / stdev;
+            z = (fair - fair_window_.mean(i)) / stdev;
         }
 
-        strategy_decision(delta.md_event_id, mid, z, *spread_opt, tele);
-        drain_execs(tele);
+        drain_execs();
+        strategy_decision(*sym, delta.symbol_id, delta.md_event_id, fair, z, book_imbalance(*top));
     }
 
     void on_exec(const ExecUpdate& exec) {
         pending_execs_.push_back(exec);
     }
 
-private:
-    void strategy_decision(uint64_t md_event_id, double mid, double z, int64_t spread, Telemetry& tele) {
-        ScopedTimer decision_timer("strategy_decision", [&](const std::string& n, int64_t ns) { tele.record(n, ns); });
-        const int64_t px = static_cast<int64_t>(mid);
-
-        // Exit conditions
-        if (position_ != 0) {
-            double unrealized = (position_ > 0 ? (mid - avg_px_) : (avg_px_ - mid)) * std::abs(position_);
-            bool hit_tp = unrealized >= cfg_.tp_ticks;
-            bool hit_sl = unrealized <= cfg_.sl_ticks;
-            bool revert = std::abs(z) < cfg_.z_exit;
-            if (hit_tp || hit_sl || revert) {
-                send_close(md_event_id, px, z);
-                return;
-            }
-        }
+    // Summed over the partition.
+    int64_t position() const {
+        int64_t pos = 0;
+        for (const auto& sym : symbols_) pos += sym.position;
+        return pos;
+    }
+    double realized_pnl() const {
+        double pnl = 0.0;
+        for (const auto& sym : symbols_) pnl += sym.realized_pnl;
+        return pnl;
+    }
 
-        // Entry conditions
-        if (active_order_) return;
-        if (std::abs(z) < cfg_.z_enter) return;
-        if (spread > cfg_.tick_size * 5) return;
-        if (std::abs(position_) >= cfg_.pos_limit) return;
+private:
+    struct Quote {
+        uint64_t cl_ord_id = 0;  // 0: slot empty
+        int64_t px = 0;          // last price asked for
+        int64_t filled = 0;
+        bool cancel_sent = false;
+    };
+
+    struct SymbolState {
+        OrderBook book;
+        int64_t position = 0;
+        double avg_px = 0.0;
+        double realized_pnl = 0.0;
+        std::array<Quote, kMaxLevels> bids{};
+        std::array<Quote, kMaxLevels> asks{};
+    };
+
+    SymbolState* lookup(uint32_t symbol_id) {
+        const uint32_t i = symbol_id - first_symbol_;  // wraps below the partition
+        return i < symbols_.size() ? &symbols_[i] : nullptr;
+    }
 
-        OrderRequest req;
-        req.req_id = md_event_id;
-        req.md_event_id = md_event_id;
-        req.side = z > 0 ? Side::Sell : Side::Buy;
-        req.px = px;
-        req.qty = 1;
-        req.signal_z = z;
-        if (send_order_(req)) {
-            active_order_ = true;
-            last_req_id_ = req.req_id;
+    void strategy_decision(SymbolState& sym,
+                           uint32_t symbol_id,
+                           uint64_t md_event_id,
+                           double fair,
+                           double z,
+                           double imbalance) {
+        ScopedProbe<Probe::StrategyDecision, Sink> decision_timer(sink_);
+        const double tick = static_cast<double>(cfg_.tick_size);
+        // Rich fair value or heavy asks: lean both quotes down.
+        const double skew = z * cfg_.skew_ticks_per_z - imbalance * cfg_.skew_ticks_per_imbalance;
+        for (int i = 0; i < cfg_.quote_levels; ++i) {
+            const double offset = static_cast<double>(cfg_.edge_ticks + i * cfg_.level_step_ticks);
+            const auto bid = static_cast<int64_t>(std::floor((fair - (offset + skew) * tick) / tick)) * cfg_.tick_size;
+            const auto ask = static_cast<int64_t>(std::ceil((fair + (offset - skew) * tick) / tick)) * cfg_.tick_size;
+            update_quote(sym.bids[i], symbol_id, Side::Buy, bid, sym.position < cfg_.pos_limit, md_event_id);
+            update_quote(sym.asks[i], symbol_id, Side::Sell, ask, sym.position > -cfg_.pos_limit, md_event_id);
         }
     }
 
-    void send_close(uint64_t md_event_id, int64_t px, double z) {
-        if (active_order_) return;
+    void update_quote(Quote& q, uint32_t symbol_id, Side side, int64_t target, bool allowed, uint64_t md_event_id) {
         OrderRequest req;
-        req.req_id = md_event_id;
         req.md_event_id = md_event_id;
-        req.side = position_ > 0 ? Side::Sell : Side::Buy;
-        req.px = px;
-        req.qty = std::abs(position_);
-        req.signal_z = z;
-        if (send_order_(req)) {
-            active_order_ = true;
-            last_req_id_ = req.req_id;
+        req.symbol_id = symbol_id;
+        req.side = side;
+        req.ts_md_recv_ns = md_recv_ns_;
+        if (!allowed) {
+            if (q.cl_ord_id == 0 || q.cancel_sent) return;
+            req.action = OrderAction::Cancel;
+            req.cl_ord_id = q.cl_ord_id;
+            q.cancel_sent = gateway_.send(req);
+            return;
+        }
+        if (q.cl_ord_id == 0) {
+            req.action = OrderAction::New;
+            req.cl_ord_id = next_cl_ord_id_;
+            req.px = target;
+            req.qty = cfg_.quote_qty;
+            if (gateway_.send(req)) {
+                q = Quote{next_cl_ord_id_, target, 0, false};
+                next_cl_ord_id_ += id_stride_;
+            }
+            return;
         }
+        if (q.cancel_sent || std::abs(target - q.px) < cfg_.requote_ticks * cfg_.tick_size) return;
+        req.action = OrderAction::Replace;
+        req.cl_ord_id = q.cl_ord_id;
+        req.px = target;
+        req.qty = q.filled + cfg_.quote_qty;
+        if (gateway_.send(req)) q.px = target;
     }
 
-    void drain_execs(Telemetry& tele) {
-        ScopedTimer timer("strategy_exec_drain", [&](const std::string& n, int64_t ns) { tele.record(n, ns); });
+    void drain_execs() {
+        ScopedProbe<Probe::StrategyExecDrain, Sink> timer(sink_);
         if (pending_execs_.empty()) return;
         for (auto& ex : pending_execs_) {
-            if (ex.exec_type == ExecType::Ack) {
-                active_order_ = false;
-            } else if (ex.exec_type == ExecType::Fill || ex.exec_type == ExecType::PartialFill) {
-                apply_fill(ex);
-                active_order_ = false;
-            } else if (ex.exec_type == ExecType::Reject || ex.exec_type == ExecType::Cancel) {
-                active_order_ = false;
+            SymbolState* sym = lookup(ex.symbol_id);
+            if (sym == nullptr) continue;
+            Side side;
+            Quote* q = find_quote(*sym, ex.cl_ord_id, side);
+            if (q == nullptr) continue;
+            switch (ex.exec_type) {
+                case ExecType::PartialFill:
+                    apply_fill(*sym, side, ex);
+                    q->filled += ex.fill_qty;
+                    break;
+                case ExecType::Fill:
+                    apply_fill(*sym, side, ex);
+                    *q = Quote{};
+                    break;
+                case ExecType::Cancel:
+                case ExecType::Reject:
+                    *q = Quote{};
+                    break;
+                case ExecType::CancelReject:
+                    // The order is unchanged; forget the price asked for so it is amended again.
+                    q->cancel_sent = false;
+                    q->px = 0;
+                    break;
+                case ExecType::Ack:
+                case ExecType::Replaced:
+                    break;
             }
         }
         pending_execs_.clear();
     }
 
-    void apply_fill(const ExecUpdate& ex) {
-        const int64_t signed_qty = (side_for_cloid(ex.cl_ord_id) == Side::Buy) ? ex.fill_qty : -ex.fill_qty;
-        int64_t new_pos = position_ + signed_qty;
-        if ((position_ > 0 && signed_qty > 0) || (position_ < 0 && signed_qty < 0)) {
-            // adding to position: update avg
-            avg_px_ = ((avg_px_ * std::abs(position_)) + (ex.fill_px * std::abs(signed_qty))) /
-                      static_cast<double>(std::abs(new_pos));
-        } else if (new_pos == 0) {
-            realized_pnl_ += (position_ > 0 ? (ex.fill_px - avg_px_) : (avg_px_ - ex.fill_px)) * std::abs(position_);
-            avg_px_ = 0.0;
+    Quote* find_quote(SymbolState& sym, uint64_t cl_ord_id, Side& side) {
+        for (int i = 0; i < cfg_.quote_levels; ++i) {
+            if (sym.bids[i].cl_ord_id == cl_ord_id) {
+                side = Side::Buy;
+                return &sym.bids[i];
+            }
+            if (sym.asks[i].cl_ord_id == cl_ord_id) {
+                side = Side::Sell;
+                return &sym.asks[i];
+            }
         }
-        position_ = new_pos;
+        return nullptr;
     }
 
-    Side side_for_cloid(uint64_t clordid) const {
-        // Parity to determine side (even -> buy, odd -> sell) purely for demo.
-        return (clordid % 2 == 0) ? Side::Buy : Side::Sell;
+    static void apply_fill(SymbolState& sym, Side side, const ExecUpdate& ex) {
+        const int64_t signed_qty = side == Side::Buy ? ex.fill_qty : -ex.fill_qty;
+        int64_t new_pos = sym.position + signed_qty;
+        if ((sym.position >= 0 && signed_qty > 0) || (sym.position <= 0 && signed_qty < 0)) {
+            // adding to position: update avg
+            sym.avg_px = ((sym.avg_px * std::abs(sym.position)) + (ex.fill_px * std::abs(signed_qty))) /
+                         static_cast<double>(std::abs(new_pos));
+        } else {
+            // reducing: realize on the closed part; a flip opens the rest at the fill price
+            const int64_t closed = std::min(std::abs(signed_qty), std::abs(sym.position));
+            sym.realized_pnl += (sym.position > 0 ? (ex.fill_px - sym.avg_px) : (sym.avg_px - ex.fill_px)) * closed;
+            if (new_pos == 0) {
+                sym.avg_px = 0.0;
+            } else if ((new_pos > 0) != (sym.position > 0)) {
+                sym.avg_px = static_cast<double>(ex.fill_px);
+            }
+        }
+        sym.position = new_pos;
     }
 
     StrategyConfig cfg_;
-    RollingStats stats_;
-    std::function<bool(const OrderRequest&)> send_order_;
-    int64_t position_ = 0;
-    double avg_px_ = 0.0;
-    double realized_pnl_ = 0.0;
-    bool active_order_ = false;
-    uint64_t last_req_id_ = 0;
+    uint32_t first_symbol_;
+    std::vector<SymbolState> symbols_;
+    RollingWindow<kZWindow> fair_window_;  // per symbol, indexed as symbols_
+    uint64_t next_cl_ord_id_;
+    uint64_t id_stride_;
+    Gateway gateway_;
+    Sink sink_;
     std::vector<ExecUpdate> pending_execs_;
+    int64_t md_recv_ns_ = 0;
 };
 
-class MarketDataGenerator {
+// Single-threaded FIFO in a ring allocated once, at least min_capacity long. push()
+// fails when full, leaving the caller to decide what overflow means.
+template <typename T>
+class FixedFifo {
 public:
-    MarketDataGenerator(int64_t px, int64_t tick) : px_(px), tick_(tick), rng_(42), dist_(-tick, tick) {}
+    explicit FixedFifo(size_t min_capacity) : slots_(std::bit_ceil(std::max<size_t>(min_capacity, 1))) {}
 
-    BookDelta next(uint64_t md_event_id) {
-        px_ += dist_(rng_);
-        BookDelta delta;
-        delta.md_event_id = md_event_id;
-        delta.symbol = kSymbol;
-        delta.exch_update_id_begin = md_event_id * 2;
-        delta.exch_update_id_end = delta.exch_update_id_begin + 1;
-        delta.levels.push_back(LevelDelta{Side::Buy, px_ - tick_, 1});
-        delta.levels.push_back(LevelDelta{Side::Sell, px_ + tick_, 1});
-        return delta;
+    bool push(const T& v) {
+        if (size() == slots_.size()) return false;
+        slots_[tail_++ & (slots_.size() - 1)] = v;
+        return true;
     }
+    T& front() { return slots_[head_ & (slots_.size() - 1)]; }
+    void pop() { ++head_; }
+    bool empty() const { return head_ == tail_; }
+    size_t size() const { return tail_ - head_; }
+    size_t capacity() const { return slots_.size(); }
 
 private:
-    int64_t px_;
-    int64_t tick_;
-    std::mt19937 rng_;
-    std::uniform_int_distribution<int64_t> dist_;
+    std::vector<T> slots_;
+    size_t head_ = 0;
+    size_t tail_ = 0;
+};
+
+// One Thread A's pair of rings to and from the OMS, and the doorbell B rings on pushing
+// to A. A's doorbell to B is shared by every partition.
+struct PartitionLink {
+    SPSCRing<OrderRequest, kRingDepth> to_oms;
+    SPSCRing<ExecUpdate, kRingDepth> from_oms;
+    int eventfd_from_oms = -1;
 };
 
+// Thread B. Orders are framed into the connection's send buffer and written without
+// ever blocking: whatever the socket does not take stays queued, so exec reports keep
+// being read while SimEx is slow to drain. With a coalescing budget, frames wait up to
+// that long so a burst leaves in one write. Conn is the transport (see transport.h).
+// Requests are taken round-robin from every partition's ring; reports go back to the
+// partition owning the symbol, symbols_per_partition symbols to each in order. The
+// order table holds max_live_orders; a new order past that is rejected locally.
+template <typename Conn>
 class OmsEngine {
 public:
-    OmsEngine(SPSCRing<OrderRequest, kRingDepth>& in_ring,
-              SPSCRing<ExecUpdate, kRingDepth>& out_ring,
+    OmsEngine(std::span<PartitionLink> links,
+              uint32_t symbols_per_partition,
+              size_t max_live_orders,
               int eventfd_in,
-              int eventfd_out)
-        : inbound_(in_ring), outbound_(out_ring), eventfd_in_(eventfd_in), eventfd_out_(eventfd_out) {}
+              TelemetryShard& shard,
+              TransportOptions transport = {},
+              std::chrono::microseconds coalesce_budget = std::chrono::microseconds(0))
+        : links_(links),
+          symbols_per_partition_(symbols_per_partition),
+          eventfd_in_(eventfd_in),
+          sink_(shard),
+          conn_(transport),
+          coalesce_ns_(std::chrono::duration_cast<std::chrono::nanoseconds>(coalesce_budget).count()),
+          orders_(max_live_orders),
+          deferred_(max_live_orders) {
+        backlogs_.reserve(links.size());
+        for (size_t p = 0; p < links.size(); ++p) backlogs_.emplace_back(kBacklogDepth);
+    }
 
-    void start() { thread_ = std::thread([this]() { run(); }); }
+    // cpu < 0 leaves the thread unpinned.
+    void start(int cpu = -1) {
+        thread_ = std::thread([this, cpu]() {
+            if (!pin_current_thread(cpu)) std::cerr << "Thread B: cannot pin to cpu " << cpu << "\n";
+            run();
+        });
+    }
 
     void join() {
         running_ = false;
@@ -243,82 +425,95 @@ public:
 
 private:
     void run() {
-        setup_socket();
-        setup_epoll();
+        // attach() owns fd from the call on, failed or not.
+        int fd = connect_loopback(kSimPort);
+        if (fd < 0 || !conn_.attach(fd, eventfd_in_)) return;
         loop();
-        cleanup();
-    }
-
-    void setup_socket() {
-        sock_fd_ = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
-        if (sock_fd_ < 0) {
-            perror("socket");
-            return;
-        }
-        sockaddr_in addr{};
-        addr.sin_family = AF_INET;
-        addr.sin_port = htons(kSimPort);
-        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
-        if (::connect(sock_fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
-            if (errno != EINPROGRESS) {
-                perror("connect");
-            }
-        }
-    }
-
-    void setup_epoll() {
-        epoll_fd_ = epoll_create1(0);
-        if (epoll_fd_ < 0) {
-            perror("epoll_create1");
-            return;
-        }
-        epoll_event ev{};
-        ev.events = EPOLLIN;
-        ev.data.fd = eventfd_in_;
-        epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, eventfd_in_, &ev);
-
-        if (sock_fd_ >= 0) {
-            epoll_event sev{};
-            sev.events = EPOLLIN | EPOLLOUT | EPOLLET;
-            sev.data.fd = sock_fd_;
-            epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, sock_fd_, &sev);
+        if (dropped_reports_ > 0) {
+            std::cerr << "Thread B: " << dropped_reports_ << " exec reports dropped on a full partition backlog\n";
         }
     }
 
     void loop() {
-        constexpr int kMaxEvents = 8;
-        epoll_event events[kMaxEvents];
+        const auto on_frame = [this](std::span<const uint8_t> payload) { on_exec_frame(payload); };
         while (running_) {
-            int nfds = epoll_wait(epoll_fd_, events, kMaxEvents, 50);
-            if (nfds < 0) {
-                if (errno == EINTR) continue;
-                perror("epoll_wait");
+            // A held batch is flushed within microseconds, below the ms timeout: poll.
+            // While a partition is not keeping up with its reports, leave them unread so
+            // the transport pushes back on SimEx instead of the backlog filling.
+            const bool holding = conn_.flushable();
+            if (backlogs_congested()) {
+                std::this_thread::yield();
+            } else if (!conn_.poll(holding ? 0 : 50, on_frame)) {
+                std::cerr << "SimEx disconnected\n";
+                running_ = false;
                 break;
             }
-            for (int i = 0; i < nfds; ++i) {
-                if (events[i].data.fd == eventfd_in_) {
-                    handle_ring();
-                } else if (events[i].data.fd == sock_fd_) {
-                    if (events[i].events & EPOLLIN) handle_socket_read();
-                }
-            }
             // periodic drain of ring even without doorbell
+            drain_backlogs();
             handle_ring();
+            maybe_flush();
         }
     }
 
     void handle_ring() {
-        eventfd_t v;
-        while (eventfd_read(eventfd_in_, &v) == 0) {
+        // Requests held back by a full send buffer go first, in the order they queued.
+        while (!deferred_.empty() && conn_.can_send(kMaxRequestBytes)) {
+            const uint64_t cl_ord_id = deferred_.front();
+            deferred_.pop();
+            if (OrderState* o = orders_.find(cl_ord_id)) {
+                o->deferred = false;
+                send_queued(cl_ord_id, *o);
+            }
+        }
+        if (!deferred_.empty()) return;
+
+        // A full send buffer leaves orders on the rings, which pushes back on Thread A.
+        for (bool more = true; more;) {
+            more = false;
+            for (auto& link : links_) {
+                if (!conn_.can_send(kMaxRequestBytes)) return;
+                auto req = link.to_oms.pop();
+                if (!req) continue;
+                on_request(*req, now_ns());
+                more = true;
+            }
+        }
+    }
+
+    void on_request(const OrderRequest& req, int64_t popped_ns) {
+        if (req.action == OrderAction::New) {
+            OrderState* o = orders_.insert(req.cl_ord_id);
+            if (o == nullptr) {  // duplicate id or table full: never leaves the process
+                ExecUpdate ex{};
+                ex.cl_ord_id = req.cl_ord_id;
+                ex.md_event_id = req.md_event_id;
+                ex.symbol_id = req.symbol_id;
+                ex.exec_type = ExecType::Reject;
+                ex.ts_oms_recv_ns = now_ns();
+                forward(ex);
+                return;
+            }
+            *o = OrderState{req.md_event_id, req.symbol_id, req.side, req.px, req.qty};
+            o->md_recv_ns = req.ts_md_recv_ns;
+            send_new_order(req, *o);
+            if (req.ts_send_ns > 0) sink_.record(Probe::OrderRingToOms, popped_ns - req.ts_send_ns);
+            sink_.record(Probe::OrderOms, o->sent_ns - popped_ns);
+            return;
         }
-        while (auto req = inbound_.pop()) {
-            send_new_order(*req);
+        // Unknown: the order is done and its final report is on its way to Thread A.
+        OrderState* o = orders_.find(req.cl_ord_id);
+        if (o == nullptr) return;
+        if (req.action == OrderAction::Cancel) {
+            request_cancel(req.cl_ord_id, *o);
+        } else {
+            request_replace(req.cl_ord_id, *o, req.px, req.qty);
         }
     }
 
-    void send_new_order(const OrderRequest& req) {
+    void send_new_order(const OrderRequest& req, OrderState& o) {
         WireNewOrder w;
-        w.cl_ord_id = next_clordid_++;
+        w.symbol_id = req.symbol_id;
+        w.cl_ord_id = req.cl_ord_id;
         w.md_event_id = req.md_event_id;
         w.side = req.side == Side::Buy ? 0 : 1;
         w.ord_type = static_cast<uint8_t>(req.type);
@@ -326,159 +521,436 @@ private:
         w.px = req.px;
         w.qty = req.qty;
         w.t_oms_send_ns = now_ns();
-        orders_[w.cl_ord_id] = OrderState{req.md_event_id, req.side, req.px, req.qty, ExecType::Ack, 0};
-
-        auto frame = pack_with_length(&w, sizeof(w));
-        send_all(frame);
+        o.sent_ns = w.t_oms_send_ns;
+        send(w);
     }
 
-    void handle_socket_read() {
-        uint8_t buf[2048];
-        for (;;) {
-            ssize_t n = ::recv(sock_fd_, buf, sizeof(buf), 0);
-            if (n < 0) {
-                if (errno == EAGAIN || errno == EWOULDBLOCK) break;
-                perror("recv");
-                break;
-            }
-            if (n == 0) {
-                std::cerr << "SimEx disconnected\n";
-                running_ = false;
-                break;
+    // One request in flight per order: while one is, or the order is not yet acked,
+    // the ask is queued. A cancel supersedes anything queued; nothing follows a cancel.
+    void request_cancel(uint64_t cl_ord_id, OrderState& o) {
+        switch (o.status) {
+            case OrdStatus::PendingNew:
+            case OrdStatus::PendingReplace:
+                o.queued = OrderAction::Cancel;
+                return;
+            case OrdStatus::Live:
+            case OrdStatus::PartiallyFilled: {
+                WireCancel w;
+                w.symbol_id = o.symbol_id;
+                w.cl_ord_id = cl_ord_id;
+                w.t_oms_send_ns = now_ns();
+                o.status = OrdStatus::PendingCancel;
+                send(w);
+                return;
             }
-            rx_buffer_.insert(rx_buffer_.end(), buf, buf + n);
-            parse_exec_reports();
+            case OrdStatus::PendingCancel:
+            case OrdStatus::Done:
+                return;
         }
     }
 
-    void parse_exec_reports() {
-        size_t offset = 0;
-        std::vector<uint8_t> payload;
-        while (unpack_frame(rx_buffer_, offset, payload)) {
-            if (payload.size() < sizeof(WireExecReport)) continue;
-            WireExecReport w{};
-            std::memcpy(&w, payload.data(), sizeof(WireExecReport));
-            if (w.hdr.magic != kProtocolMagic || w.hdr.msg_type != kMsgExecReport) continue;
-            ExecUpdate ex{};
-            ex.cl_ord_id = w.cl_ord_id;
-            ex.md_event_id = w.md_event_id;
-            ex.exec_type = static_cast<ExecType>(w.exec_type);
-            ex.fill_px = w.fill_px;
-            ex.fill_qty = w.fill_qty;
-            ex.ts_oms_recv_ns = now_ns();
-            outbound_.push(ex);
-            eventfd_write(eventfd_out_, 1);
-            if (auto it = orders_.find(w.cl_ord_id); it != orders_.end()) {
-                it->second.state = ex.exec_type;
-                it->second.filled += ex.fill_qty;
+    void request_replace(uint64_t cl_ord_id, OrderState& o, int64_t px, int64_t qty) {
+        switch (o.status) {
+            case OrdStatus::PendingNew:
+            case OrdStatus::PendingReplace:
+                if (o.queued == OrderAction::Cancel) return;
+                o.queued = OrderAction::Replace;
+                o.queued_px = px;
+                o.queued_qty = qty;
+                return;
+            case OrdStatus::Live:
+            case OrdStatus::PartiallyFilled: {
+                WireReplace w;
+                w.symbol_id = o.symbol_id;
+                w.cl_ord_id = cl_ord_id;
+                w.px = px;
+                w.qty = qty;
+                w.t_oms_send_ns = now_ns();
+                o.status = OrdStatus::PendingReplace;
+                send(w);
+                return;
             }
+            case OrdStatus::PendingCancel:
+            case OrdStatus::Done:
+                return;
         }
-        rx_buffer_.erase(rx_buffer_.begin(), rx_buffer_.begin() + offset);
     }
 
-    void send_all(const std::vector<uint8_t>& frame) {
-        size_t sent = 0;
-        while (sent < frame.size()) {
-            ssize_t n = ::send(sock_fd_, frame.data() + sent, frame.size() - sent, 0);
-            if (n < 0) {
-                if (errno == EAGAIN || errno == EWOULDBLOCK) {
-                    std::this_thread::sleep_for(std::chrono::microseconds(50));
-                    continue;
+    // Once the request in flight resolves, sends whatever was queued behind it. Reports
+    // arrive regardless of send room, so without room the order waits on deferred_.
+    // Each order is there at most once, and no new order is taken while it is
+    // non-empty, so it never holds more than the table does and the push cannot fail.
+    void send_queued(uint64_t cl_ord_id, OrderState& o) {
+        if (o.queued == OrderAction::New || o.deferred) return;
+        if (!conn_.can_send(kMaxRequestBytes)) {
+            o.deferred = deferred_.push(cl_ord_id);
+            return;
+        }
+        const OrderAction queued = o.queued;
+        o.queued = OrderAction::New;
+        if (queued == OrderAction::Cancel) {
+            request_cancel(cl_ord_id, o);
+        } else if (queued == OrderAction::Replace) {
+            request_replace(cl_ord_id, o, o.queued_px, o.queued_qty);
+        }
+    }
+
+    template <typename Msg>
+    void send(const Msg& w) {
+        if (conn_.empty()) flush_at_ns_ = w.t_oms_send_ns + coalesce_ns_;
+        conn_.send(w);
+    }
+
+    void on_exec_frame(std::span<const uint8_t> payload) {
+        WireExecReport w;
+        if (!decode_frame(payload, kMsgExecReport, w)) return;
+        ExecUpdate ex{};
+        ex.cl_ord_id = w.cl_ord_id;
+        ex.md_event_id = w.md_event_id;
+        ex.symbol_id = w.symbol_id;
+        ex.exec_type = static_cast<ExecType>(w.exec_type);
+        ex.fill_px = w.fill_px;
+        ex.fill_qty = w.fill_qty;
+        ex.leaves_qty = w.leaves_qty;
+        ex.ts_oms_recv_ns = now_ns();
+        OrderState* o = orders_.find(w.cl_ord_id);
+        if (o != nullptr && ex.exec_type == ExecType::Ack) record_ack(w, *o, ex);
+        forward(ex);
+        if (o != nullptr) on_exec(w.cl_ord_id, *o, ex);
+    }
+
+    // A new order's time out to SimEx, inside it, and back, from SimEx's stamps on the
+    // report; every process reads the same CLOCK_MONOTONIC. The Ack carries the order's
+    // md receive time on to Thread A, which closes tick-to-ack.
+    void record_ack(const WireExecReport& w, const OrderState& o, ExecUpdate& ex) {
+        sink_.record(Probe::OrderRoundTrip, ex.ts_oms_recv_ns - o.sent_ns);
+        ex.ts_md_recv_ns = o.md_recv_ns;
+        if (w.t_sim_recv_ns == 0) return;
+        sink_.record(Probe::OrderWireOut, w.t_sim_recv_ns - o.sent_ns);
+        sink_.record(Probe::OrderSim, w.t_sim_send_ns - w.t_sim_recv_ns);
+        sink_.record(Probe::OrderWireBack, ex.ts_oms_recv_ns - w.t_sim_send_ns);
+    }
+
+    void on_exec(uint64_t cl_ord_id, OrderState& o, const ExecUpdate& ex) {
+        switch (ex.exec_type) {
+            case ExecType::Ack:
+                o.status = OrdStatus::Live;
+                send_queued(cl_ord_id, o);
+                return;
+            case ExecType::PartialFill:
+                o.filled += ex.fill_qty;
+                if (o.status == OrdStatus::Live) o.status = OrdStatus::PartiallyFilled;
+                return;
+            case ExecType::Replaced:
+                o.px = ex.fill_px;
+                o.qty = ex.fill_qty;
+                o.status = resting_status(o);
+                send_queued(cl_ord_id, o);
+                return;
+            case ExecType::CancelReject:
+                if (o.status == OrdStatus::PendingCancel || o.status == OrdStatus::PendingReplace) {
+                    o.status = resting_status(o);
                 }
-                perror("send");
-                break;
-            }
-            sent += static_cast<size_t>(n);
+                send_queued(cl_ord_id, o);
+                return;
+            case ExecType::Fill:
+            case ExecType::Cancel:
+            case ExecType::Reject:
+                o.status = OrdStatus::Done;
+                orders_.erase(cl_ord_id);
+                return;
+        }
+    }
+
+    static OrdStatus resting_status(const OrderState& o) {
+        return o.filled > 0 ? OrdStatus::PartiallyFilled : OrdStatus::Live;
+    }
+
+    // A report that does not fit on its partition's ring waits in that partition's
+    // backlog, behind any already there. The connection is no longer read once a backlog
+    // is half full, so only a single read bigger than the other half can overflow it;
+    // such reports are dropped and counted.
+    void forward(const ExecUpdate& ex) {
+        const size_t partition = std::min<size_t>(ex.symbol_id / symbols_per_partition_, links_.size() - 1);
+        PartitionLink& link = links_[partition];
+        FixedFifo<ExecUpdate>& backlog = backlogs_[partition];
+        if (!backlog.empty() || !link.from_oms.push(ex)) {
+            if (!backlog.push(ex)) ++dropped_reports_;
+            return;
         }
+        eventfd_write(link.eventfd_from_oms, 1);
     }
 
-    void cleanup() {
-        if (sock_fd_ >= 0) ::close(sock_fd_);
-        if (epoll_fd_ >= 0) ::close(epoll_fd_);
+    void drain_backlogs() {
+        for (size_t p = 0; p < links_.size(); ++p) {
+            FixedFifo<ExecUpdate>& backlog = backlogs_[p];
+            if (backlog.empty()) continue;
+            size_t pushed = 0;
+            for (; !backlog.empty() && links_[p].from_oms.push(backlog.front()); ++pushed) backlog.pop();
+            if (pushed > 0) eventfd_write(links_[p].eventfd_from_oms, 1);
+        }
+    }
+
+    bool backlogs_congested() const {
+        for (const auto& backlog : backlogs_) {
+            if (backlog.size() > backlog.capacity() / 2) return true;
+        }
+        return false;
     }
 
-    SPSCRing<OrderRequest, kRingDepth>& inbound_;
-    SPSCRing<ExecUpdate, kRingDepth>& outbound_;
+    void maybe_flush() {
+        if (!conn_.flushable()) return;
+        if (coalesce_ns_ > 0 && now_ns() < flush_at_ns_ && conn_.can_send(kCoalesceHeadroom)) return;
+        conn_.flush();
+    }
+
+    std::span<PartitionLink> links_;
+    uint32_t symbols_per_partition_;
     int eventfd_in_;
-    int eventfd_out_;
-    int sock_fd_ = -1;
-    int epoll_fd_ = -1;
+    std::vector<FixedFifo<ExecUpdate>> backlogs_;  // per partition, waiting for ring room
+    int64_t dropped_reports_ = 0;
+    ProbeSink sink_;
+    Conn conn_;
     std::thread thread_;
     std::atomic<bool> running_{true};
-    uint64_t next_clordid_ = 1;
-    std::vector<uint8_t> rx_buffer_;
-    std::unordered_map<uint64_t, OrderState> orders_;
+    static constexpr size_t kBacklogDepth = 4 * kRingDepth;  // reports per partition
+    // Stop holding a batch once it would leave less than this much room.
+    static constexpr size_t kCoalesceHeadroom = kSocketBufBytes / 2;
+    static constexpr size_t kMaxRequestBytes = std::max({sizeof(WireNewOrder), sizeof(WireCancel), sizeof(WireReplace)});
+
+    int64_t coalesce_ns_;
+    int64_t flush_at_ns_ = 0;
+    OrderTable<OrderState> orders_;
+    FixedFifo<uint64_t> deferred_;  // cl_ord_ids with a request queued behind a full buffer
 };
 
-void run_thread_a(SPSCRing<OrderRequest, kRingDepth>& a_to_b,
-                  SPSCRing<ExecUpdate, kRingDepth>& b_to_a,
-                  int eventfd_a_to_b,
-                  int eventfd_b_to_a) {
-    Telemetry telemetry;
-    OrderBook ob;
-    MarketDataGenerator md_gen(28'000'000, 50);
-    StrategyConfig cfg;
-
-    Strategy strat(cfg, [&](const OrderRequest& req) {
-        if (a_to_b.push(req)) {
-            eventfd_write(eventfd_a_to_b, 1);
-            telemetry.record("strategy_send_order", 0);
+// Thread A -> B: push onto the SPSC ring and ring B's eventfd.
+template <StageSink Sink>
+class RingGateway {
+public:
+    RingGateway(SPSCRing<OrderRequest, kRingDepth>& ring, int eventfd, Sink sink)
+        : ring_(ring), eventfd_(eventfd), sink_(sink) {}
+
+    bool send(const OrderRequest& req) {
+        OrderRequest stamped = req;
+        if constexpr (Sink::kEnabled) stamped.ts_send_ns = now_ns();
+        if (ring_.push(stamped)) {
+            eventfd_write(eventfd_, 1);
+            sink_.record(Probe::SendOrder, 0);
+            if (req.action == OrderAction::New && req.ts_md_recv_ns > 0) {
+                sink_.record(Probe::OrderStrategy, stamped.ts_send_ns - req.ts_md_recv_ns);
+            }
             return true;
         }
-        telemetry.record("strategy_send_order_ring_full", 0);
+        sink_.record(Probe::SendOrderRingFull, 0);
         return false;
-    });
+    }
 
-    constexpr int kEvents = 2000;
-    for (int i = 0; i < kEvents; ++i) {
+private:
+    SPSCRing<OrderRequest, kRingDepth>& ring_;
+    int eventfd_;
+    Sink sink_;
+};
+
+// One Thread A: market data, books and strategy for symbols
+// [first_symbol, first_symbol + symbol_count), over its own rings to the OMS.
+void run_thread_a(PartitionLink& link,
+                  int eventfd_to_oms,
+                  uint32_t partition,
+                  uint32_t partitions,
+                  uint32_t first_symbol,
+                  uint32_t symbol_count,
+                  const FeedConfig& feed,
+                  Telemetry& telemetry,
+                  int events,
+                  int cpu) {
+    if (!pin_current_thread(cpu)) std::cerr << "Thread A " << partition << ": cannot pin to cpu " << cpu << "\n";
+    MarketDataGenerator md_gen(feed, first_symbol, symbol_count, 42 + partition);
+    StrategyConfig cfg;
+    ProbeSink sink(telemetry.register_thread());
+
+    Strategy strat(cfg, first_symbol, symbol_count, partition + 1, partitions,
+                   RingGateway(link.to_oms, eventfd_to_oms, sink), sink);
+
+    // Reports are taken as soon as they are seen, including while waiting for the next
+    // message; the strategy acts on them before its next book update.
+    const auto drain_execs = [&]() {
+        eventfd_t v;
+        while (eventfd_read(link.eventfd_from_oms, &v) == 0) {
+        }
+        while (auto ex = link.from_oms.pop()) {
+            if (ex->exec_type == ExecType::Ack && ex->ts_md_recv_ns > 0) {
+                const int64_t t = now_ns();
+                sink.record(Probe::OrderRingToStrategy, t - ex->ts_oms_recv_ns);
+                sink.record(Probe::OrderTickToAck, t - ex->ts_md_recv_ns);
+            }
+            strat.on_exec(*ex);
+        }
+    };
+
+    int64_t feed_start_ns = 0;  // local clock at feed time 0
+    uint64_t last_update_id = 0;
+    uint64_t gaps = 0;
+    for (int i = 0; i < events; ++i) {
         uint64_t md_event_id = i + 1;
+        BookDelta delta;
         {
-            ScopedTimer t("md_total", [&](const std::string& n, int64_t ns) { telemetry.record(n, ns); });
-            ScopedTimer read_t("md_read", [&](const std::string& n, int64_t ns) { telemetry.record(n, ns); });
+            ScopedProbe<Probe::MdRead, ProbeSink> read_t(sink);
+            delta = md_gen.next(md_event_id);
         }
-        {
-            ScopedTimer parse_t("md_parse", [&](const std::string& n, int64_t ns) { telemetry.record(n, ns); });
+        if (delta.event_time_ns > 0) {
+            // A scheduled feed: hold each message until its event time comes round.
+            if (feed_start_ns == 0) feed_start_ns = now_ns() - delta.event_time_ns;
+            while (now_ns() < feed_start_ns + delta.event_time_ns) {
+                drain_execs();
+                std::this_thread::yield();
+            }
         }
-        BookDelta delta = md_gen.next(md_event_id);
+        const int64_t md_recv_ns = now_ns();
+        if (delta.event_time_ns > 0) sink.record(Probe::MdFeedLag, md_recv_ns - (feed_start_ns + delta.event_time_ns));
+
+        ScopedProbe<Probe::MdTotal, ProbeSink> t(sink);
         {
-            ScopedTimer align_t("md_align", [&](const std::string& n, int64_t ns) { telemetry.record(n, ns); });
+            // Each message's first update id follows the last one's final id; a gap
+            // means updates were lost and the book should be rebuilt from a snapshot.
+            ScopedProbe<Probe::MdAlign, ProbeSink> align_t(sink);
+            if (last_update_id != 0 && delta.exch_update_id_begin != last_update_id + 1) ++gaps;
+            last_update_id = delta.exch_update_id_end;
         }
 
-        // Drain any exec updates before applying strategy decisions.
-        eventfd_t v;
-        while (eventfd_read(eventfd_b_to_a, &v) == 0) {
-        }
-        while (auto ex = b_to_a.pop()) {
-            strat.on_exec(*ex);
+        drain_execs();
+        strat.on_book(delta, md_recv_ns);
+    }
+    std::string summary = "Strategy partition " + std::to_string(partition) + " (" + std::to_string(symbol_count) +
+                          " symbols): position " + std::to_string(strat.position()) + ", realized pnl " +
+                          std::to_string(strat.realized_pnl()) + ", feed gaps " + std::to_string(gaps) + "\n";
+    std::cout << summary;
+}
+
+// symbols split over a_threads Thread As in contiguous partitions, all feeding one
+// Thread B over one transport; B's shard is registered before it starts. events and
+// the feed's rate are totals across partitions. cpus, if given, pins B to the first
+// and the Thread As in turn to the rest.
+template <typename Conn>
+int run_pipeline(Telemetry& telemetry,
+                 TransportOptions transport,
+                 std::chrono::microseconds coalesce,
+                 int events,
+                 uint32_t symbols,
+                 uint32_t a_threads,
+                 const FeedConfig& feed,
+                 const std::vector<int>& cpus) {
+    symbols = std::max(symbols, 1u);
+    a_threads = std::clamp(a_threads, 1u, symbols);
+    const uint32_t per_partition = (symbols + a_threads - 1) / a_threads;
+    const uint32_t partitions = (symbols + per_partition - 1) / per_partition;
+
+    auto links = std::make_unique<PartitionLink[]>(partitions);
+    int eventfd_to_oms = eventfd(0, EFD_NONBLOCK | EFD_SEMAPHORE);
+    bool ok = eventfd_to_oms >= 0;
+    for (uint32_t p = 0; p < partitions; ++p) {
+        links[p].eventfd_from_oms = eventfd(0, EFD_NONBLOCK | EFD_SEMAPHORE);
+        ok = ok && links[p].eventfd_from_oms >= 0;
+    }
+    const auto close_fds = [&]() {
+        if (eventfd_to_oms >= 0) close(eventfd_to_oms);
+        for (uint32_t p = 0; p < partitions; ++p) {
+            if (links[p].eventfd_from_oms >= 0) close(links[p].eventfd_from_oms);
         }
+    };
+    if (!ok) {
+        perror("eventfd");
+        close_fds();
+        return 1;
+    }
 
-        strat.on_book(delta, ob, telemetry);
+    // Every quote slot of every symbol live at once.
+    const size_t max_live_orders = size_t{symbols} * kMaxQuoteLevels * 2;
+    OmsEngine<Conn> oms(std::span<PartitionLink>(links.get(), partitions), per_partition, max_live_orders,
+                        eventfd_to_oms, telemetry.register_thread(), transport, coalesce);
+    const auto cpu_for = [&](size_t k) { return k < cpus.size() ? cpus[k] : -1; };
+    oms.start(cpu_for(0));
+
+    const int64_t feed_begin_ns = now_ns();
+    FeedConfig partition_feed = feed;
+    partition_feed.rate = feed.rate / partitions;
+    std::vector<std::thread> threads;
+    for (uint32_t p = 0; p < partitions; ++p) {
+        const uint32_t first = p * per_partition;
+        const uint32_t count = std::min(per_partition, symbols - first);
+        const int share = events / static_cast<int>(partitions) + (p < events % partitions ? 1 : 0);
+        threads.emplace_back([&, p, first, count, share]() {
+            run_thread_a(links[p], eventfd_to_oms, p, partitions, first, count, partition_feed, telemetry, share,
+                         cpu_for(p + 1));
+        });
     }
+    for (auto& t : threads) t.join();
+    const double feed_s = static_cast<double>(now_ns() - feed_begin_ns) / 1e9;
+    std::cout << "Feed: " << events << " messages in " << feed_s << " s, "
+              << static_cast<uint64_t>(static_cast<double>(events) / feed_s) << " msg/s\n";
 
-    std::cout << "=== Telemetry ===\n" << telemetry.summary() << std::endl;
+    // Let the last orders' reports arrive before stopping B.
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    oms.join();
+    close_fds();
+    return 0;
 }
 
 }  // namespace hft
 
-int main() {
+int main(int argc, char* argv[]) {
     using namespace hft;
-    SPSCRing<OrderRequest, kRingDepth> a_to_b_ring;
-    SPSCRing<ExecUpdate, kRingDepth> b_to_a_ring;
-
-    int eventfd_a_to_b = eventfd(0, EFD_NONBLOCK | EFD_SEMAPHORE);
-    int eventfd_b_to_a = eventfd(0, EFD_NONBLOCK | EFD_SEMAPHORE);
-    if (eventfd_a_to_b < 0 || eventfd_b_to_a < 0) {
-        perror("eventfd");
+    int coalesce_us = 0;
+    TransportKind kind = TransportKind::Epoll;
+    int events = 2000;
+    if (argc > 1) coalesce_us = std::stoi(argv[1]);
+    if (argc > 2 && !parse_transport(argv[2], kind)) {
+        std::cerr << "transport must be epoll, uring, uring-sqpoll, shm or shm-futex\n";
+        return 1;
+    }
+    if (argc > 3) events = std::stoi(argv[3]);
+    uint32_t symbols = 1;
+    uint32_t a_threads = 1;
+    if (argc > 4) symbols = static_cast<uint32_t>(std::stoul(argv[4]));
+    if (argc > 5) a_threads = static_cast<uint32_t>(std::stoul(argv[5]));
+    FeedConfig feed;
+    if (argc > 6) feed.rate = std::stod(argv[6]);
+    if (argc > 7 && !parse_arrivals(argv[7], feed.arrivals)) {
+        std::cerr << "arrivals must be poisson or hawkes\n";
         return 1;
     }
 
-    OmsEngine oms(a_to_b_ring, b_to_a_ring, eventfd_a_to_b, eventfd_b_to_a);
-    oms.start();
+    std::vector<int> cpus;
+    if (argc > 8 && !parse_cpu_list(argv[8], cpus)) {
+        std::cerr << "cpus must be a comma-separated list: Thread B's, then each Thread A's\n";
+        return 1;
+    }
 
-    run_thread_a(a_to_b_ring, b_to_a_ring, eventfd_a_to_b, eventfd_b_to_a);
+    Telemetry telemetry;
+    TelemetryAggregator aggregator(telemetry, std::chrono::milliseconds(100));
+    const auto coalesce = std::chrono::microseconds(coalesce_us);
+    int rc = 0;
+    switch (kind) {
+        case TransportKind::Epoll:
+            rc = run_pipeline<EpollConnection>(telemetry, {}, coalesce, events, symbols, a_threads, feed, cpus);
+            break;
+        case TransportKind::Uring:
+            rc = run_pipeline<UringConnection>(telemetry, {}, coalesce, events, symbols, a_threads, feed, cpus);
+            break;
+        case TransportKind::UringSqpoll:
+            rc = run_pipeline<UringConnection>(telemetry, {.sqpoll = true}, coalesce, events, symbols, a_threads, feed,
+                                               cpus);
+            break;
+        case TransportKind::Shm:
+            rc = run_pipeline<ShmConnection>(telemetry, {}, coalesce, events, symbols, a_threads, feed, cpus);
+            break;
+        case TransportKind::ShmFutex:
+            rc = run_pipeline<ShmConnection>(telemetry, {.futex = true}, coalesce, events, symbols, a_threads, feed,
+                                             cpus);
+            break;
+    }
 
-    oms.join();
-    close(eventfd_a_to_b);
-    close(eventfd_b_to_a);
-    return 0;
+    aggregator.stop();
+    std::cout << "=== Telemetry ===\n" << Telemetry::format(*aggregator.latest()) << std::endl;
+    return rc;
 }
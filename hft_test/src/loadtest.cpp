@@ -0,0 +1,313 @@
+#include <sched.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "affinity.h"
+#include "market_data.h"
+#include "transport.h"
+
+// Closed-loop load test: for each target rate, starts simex_server, runs hft_main
+// against it for a fixed time at that rate, and reads hft_main's telemetry back. Both
+// binaries are expected next to this one. Prints each run's new-order path split into
+// stages, then latency against achieved throughput across the runs.
+
+namespace hft {
+
+struct LoadTestConfig {
+    std::vector<double> rates{1000, 5000, 20000, 50000};  // feed messages/s, one run each
+    double seconds = 2.0;
+    uint32_t symbols = 8;
+    uint32_t a_threads = 2;
+    std::string transport = "epoll";
+    std::string arrivals = "poisson";
+    int ack_us = 50;
+    int fill_us = 100;
+    // SimEx, Thread B, then each Thread A. Empty: one CPU each if there are enough.
+    std::vector<int> cpus;
+};
+
+// One probe's line of hft_main's telemetry, in microseconds.
+struct StageStats {
+    uint64_t n = 0;
+    double p50 = 0.0;
+    double p90 = 0.0;
+    double p99 = 0.0;
+    double p999 = 0.0;
+    double max = 0.0;
+};
+
+struct RunResult {
+    double target_rate = 0.0;
+    uint64_t messages = 0;
+    double feed_s = 0.0;
+    std::map<std::string, StageStats> stages;  // by probe name
+    bool ok = false;
+};
+
+// The new-order stages in path order; their latencies are measured separately, so
+// percentiles do not add up to tick-to-ack's.
+constexpr const char* kOrderStages[][2] = {
+    {"order_strategy", "strategy: md recv -> order on ring"},
+    {"order_ring_to_oms", "ring A->B"},
+    {"order_oms", "OMS: ring pop -> framed"},
+    {"order_wire_out", "wire out: framed -> SimEx recv"},
+    {"order_sim", "SimEx: recv -> Ack sent"},
+    {"order_wire_back", "wire back: Ack sent -> OMS recv"},
+    {"order_ring_to_strategy", "ring B->A: OMS recv -> Thread A"},
+    {"order_tick_to_ack", "tick-to-ack"},
+};
+
+struct Child {
+    pid_t pid = -1;
+    int out_fd = -1;  // the child's stdout
+};
+
+// fork/exec with stdout on a pipe; pinned to cpu before exec when cpu >= 0, which
+// also pins every thread the child starts unless it repins them.
+Child spawn(const std::string& path, const std::vector<std::string>& args, int cpu) {
+    int fds[2];
+    if (pipe(fds) < 0) {
+        perror("pipe");
+        return {};
+    }
+    const pid_t pid = fork();
+    if (pid < 0) {
+        perror("fork");
+        close(fds[0]);
+        close(fds[1]);
+        return {};
+    }
+    if (pid == 0) {
+        if (cpu >= 0) {
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            CPU_SET(cpu, &set);
+            sched_setaffinity(0, sizeof(set), &set);
+        }
+        dup2(fds[1], STDOUT_FILENO);
+        close(fds[0]);
+        close(fds[1]);
+        std::vector<char*> argv;
+        argv.push_back(const_cast<char*>(path.c_str()));
+        for (const auto& a : args) argv.push_back(const_cast<char*>(a.c_str()));
+        argv.push_back(nullptr);
+        execv(path.c_str(), argv.data());
+        perror("execv");
+        _exit(127);
+    }
+    close(fds[1]);
+    return Child{pid, fds[0]};
+}
+
+// Reads one line from fd; false at end of stream.
+bool read_line(int fd, std::string& line) {
+    line.clear();
+    char c;
+    while (true) {
+        const ssize_t n = read(fd, &c, 1);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return !line.empty();
+        if (c == '\n') return true;
+        line += c;
+    }
+}
+
+std::string read_all(int fd) {
+    std::string out;
+    char buf[4096];
+    while (true) {
+        const ssize_t n = read(fd, buf, sizeof(buf));
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return out;
+        out.append(buf, static_cast<size_t>(n));
+    }
+}
+
+// "md_total: n=4000 p50=1.5us p90=... max=...us"
+bool parse_stage_line(const std::string& line, std::string& name, StageStats& s) {
+    const size_t colon = line.find(": n=");
+    if (colon == std::string::npos) return false;
+    name = line.substr(0, colon);
+    return std::sscanf(line.c_str() + colon, ": n=%lu p50=%lfus p90=%lfus p99=%lfus p99.9=%lfus max=%lfus", &s.n,
+                       &s.p50, &s.p90, &s.p99, &s.p999, &s.max) == 6;
+}
+
+void parse_output(const std::string& out, RunResult& r) {
+    std::istringstream in(out);
+    std::string line;
+    while (std::getline(in, line)) {
+        unsigned long messages = 0;
+        double secs = 0.0;
+        if (std::sscanf(line.c_str(), "Feed: %lu messages in %lf s", &messages, &secs) == 2) {
+            r.messages = messages;
+            r.feed_s = secs;
+            continue;
+        }
+        std::string name;
+        StageStats s;
+        if (parse_stage_line(line, name, s)) r.stages[name] = s;
+    }
+}
+
+RunResult run_once(const std::filesystem::path& bin_dir, const LoadTestConfig& cfg, double rate) {
+    RunResult r;
+    r.target_rate = rate;
+    const auto cpu = [&](size_t k) { return k < cfg.cpus.size() ? cfg.cpus[k] : -1; };
+
+    Child sim = spawn(bin_dir / "simex_server",
+                      {std::to_string(cfg.ack_us), std::to_string(cfg.fill_us), cfg.transport}, cpu(0));
+    if (sim.pid < 0) return r;
+    std::string line;
+    bool listening = false;
+    while (!listening && read_line(sim.out_fd, line)) listening = line.find("listening") != std::string::npos;
+    if (!listening) {
+        std::cerr << "simex_server did not start\n";
+        kill(sim.pid, SIGTERM);
+        waitpid(sim.pid, nullptr, 0);
+        close(sim.out_fd);
+        return r;
+    }
+    // Keep SimEx's stats lines flowing so it never blocks on a full pipe.
+    std::thread sim_drain([fd = sim.out_fd]() { read_all(fd); });
+
+    const auto events = static_cast<long>(rate * cfg.seconds);
+    std::string cpus_arg;
+    for (size_t k = 1; k < cfg.cpus.size(); ++k) {
+        cpus_arg += (cpus_arg.empty() ? "" : ",") + std::to_string(cfg.cpus[k]);
+    }
+    std::vector<std::string> args{"0",
+                                  cfg.transport,
+                                  std::to_string(events),
+                                  std::to_string(cfg.symbols),
+                                  std::to_string(cfg.a_threads),
+                                  std::to_string(rate),
+                                  cfg.arrivals};
+    if (!cpus_arg.empty()) args.push_back(cpus_arg);
+    Child hft = spawn(bin_dir / "hft_main", args, -1);
+    if (hft.pid >= 0) {
+        const std::string out = read_all(hft.out_fd);
+        close(hft.out_fd);
+        int status = 0;
+        waitpid(hft.pid, &status, 0);
+        parse_output(out, r);
+        r.ok = WIFEXITED(status) && WEXITSTATUS(status) == 0 && r.messages > 0;
+        if (!r.ok) std::cerr << "hft_main failed at " << rate << " msg/s:\n" << out;
+    }
+
+    kill(sim.pid, SIGTERM);
+    waitpid(sim.pid, nullptr, 0);
+    sim_drain.join();
+    close(sim.out_fd);
+    return r;
+}
+
+void print_stages(const RunResult& r) {
+    std::printf("\n=== target %.0f msg/s: %lu messages in %.2f s (%.0f msg/s) ===\n", r.target_rate, r.messages,
+                r.feed_s, r.feed_s > 0 ? static_cast<double>(r.messages) / r.feed_s : 0.0);
+    std::printf("%-36s %8s %10s %10s %10s %10s  (us)\n", "stage", "n", "p50", "p90", "p99", "p99.9");
+    for (const auto& [probe, label] : kOrderStages) {
+        const auto it = r.stages.find(probe);
+        if (it == r.stages.end()) continue;
+        const StageStats& s = it->second;
+        std::printf("%-36s %8lu %10.2f %10.2f %10.2f %10.2f\n", label, s.n, s.p50, s.p90, s.p99, s.p999);
+    }
+}
+
+void print_curve(const std::vector<RunResult>& results) {
+    std::printf("\n=== throughput vs latency (us) ===\n");
+    std::printf("%10s %10s %8s %10s %10s %10s %12s\n", "target", "achieved", "acks", "t2a_p50", "t2a_p99",
+                "t2a_p99.9", "feed_lag_p99");
+    for (const auto& r : results) {
+        const auto get = [&](const char* probe) {
+            const auto it = r.stages.find(probe);
+            return it == r.stages.end() ? StageStats{} : it->second;
+        };
+        const StageStats t2a = get("order_tick_to_ack");
+        const StageStats lag = get("md_feed_lag");
+        std::printf("%10.0f %10.0f %8lu %10.2f %10.2f %10.2f %12.2f\n", r.target_rate,
+                    r.feed_s > 0 ? static_cast<double>(r.messages) / r.feed_s : 0.0, t2a.n, t2a.p50, t2a.p99,
+                    t2a.p999, lag.p99);
+    }
+}
+
+bool parse_rates(std::string_view s, std::vector<double>& out) {
+    out.clear();
+    std::istringstream in{std::string(s)};
+    std::string item;
+    while (std::getline(in, item, ',')) {
+        char* end = nullptr;
+        const double rate = std::strtod(item.c_str(), &end);
+        if (end == item.c_str() || *end != '\0' || rate <= 0.0) return false;
+        out.push_back(rate);
+    }
+    return !out.empty();
+}
+
+}  // namespace hft
+
+int main(int argc, char* argv[]) {
+    using namespace hft;
+    LoadTestConfig cfg;
+    if (argc > 1 && !parse_rates(argv[1], cfg.rates)) {
+        std::cerr << "rates must be a comma-separated list of positive messages/s\n";
+        return 1;
+    }
+    if (argc > 2) cfg.seconds = std::stod(argv[2]);
+    if (argc > 3) cfg.symbols = static_cast<uint32_t>(std::stoul(argv[3]));
+    if (argc > 4) cfg.a_threads = static_cast<uint32_t>(std::stoul(argv[4]));
+    TransportKind kind;
+    if (argc > 5) cfg.transport = argv[5];
+    if (!parse_transport(cfg.transport, kind)) {
+        std::cerr << "transport must be epoll, uring, uring-sqpoll, shm or shm-futex\n";
+        return 1;
+    }
+    Arrivals arrivals;
+    if (argc > 6) cfg.arrivals = argv[6];
+    if (!parse_arrivals(cfg.arrivals, arrivals)) {
+        std::cerr << "arrivals must be poisson or hawkes\n";
+        return 1;
+    }
+    if (argc > 7) cfg.ack_us = std::stoi(argv[7]);
+    if (argc > 8) cfg.fill_us = std::stoi(argv[8]);
+    if (argc > 9 && !parse_cpu_list(argv[9], cfg.cpus)) {
+        std::cerr << "cpus must be a comma-separated list: SimEx's, Thread B's, then each Thread A's\n";
+        return 1;
+    }
+    if (argc <= 9) {
+        const uint32_t wanted = cfg.a_threads + 2;
+        if (std::thread::hardware_concurrency() >= wanted) {
+            for (uint32_t k = 0; k < wanted; ++k) cfg.cpus.push_back(static_cast<int>(k));
+        } else {
+            std::cerr << "Fewer than " << wanted << " CPUs: running unpinned\n";
+        }
+    }
+
+    std::error_code ec;
+    const std::filesystem::path bin_dir = std::filesystem::read_symlink("/proc/self/exe", ec).parent_path();
+    if (ec) {
+        std::cerr << "cannot locate binaries: " << ec.message() << "\n";
+        return 1;
+    }
+
+    std::vector<RunResult> results;
+    for (const double rate : cfg.rates) {
+        RunResult r = run_once(bin_dir, cfg, rate);
+        if (!r.ok) return 1;
+        print_stages(r);
+        results.push_back(std::move(r));
+    }
+    print_curve(results);
+    return 0;
+}
@@ -0,0 +1,70 @@
+#include <cmath>
+#include <cstdio>
+#include <deque>
+#include <random>
+#include <vector>
+
+#include "signals.h"
+
+// Feeds RollingWindow random walks for several symbols at once, interleaved, and after
+// every update compares each symbol's mean and variance with a two-pass recompute over
+// the same samples. Prices sit far from zero, where a running sum of squares would lose
+// the variance to cancellation. Exits non-zero on the first mismatch.
+
+namespace hft {
+namespace {
+
+constexpr size_t kWindow = 64;
+constexpr size_t kSymbols = 5;
+constexpr int kUpdates = 20000;  // per symbol, so the ring wraps many times
+
+// Sliding updates round against the price, not the spread, so the variance may drift
+// by a small multiple of mean^2 * epsilon over many wraps but no more.
+bool mean_close(double got, double want) { return std::abs(got - want) <= 1e-12 * std::abs(want); }
+bool variance_close(double got, double want, double mean) {
+    return std::abs(got - want) <= 1e-9 * want + 1e-14 * mean * mean;
+}
+
+int run() {
+    RollingWindow<kWindow> window(kSymbols);
+    std::vector<std::deque<double>> naive(kSymbols);
+    std::vector<double> price(kSymbols);
+    std::mt19937_64 rng(12345);
+    std::normal_distribution<double> step(0.0, 25.0);
+    std::uniform_int_distribution<size_t> pick(0, kSymbols - 1);
+    for (size_t i = 0; i < kSymbols; ++i) price[i] = 1e7 * static_cast<double>(i + 1);
+
+    for (int u = 0; u < kUpdates * static_cast<int>(kSymbols); ++u) {
+        const size_t i = pick(rng);
+        price[i] += step(rng);
+        window.update(i, price[i]);
+        auto& q = naive[i];
+        q.push_back(price[i]);
+        if (q.size() > kWindow) q.pop_front();
+
+        double mean = 0.0;
+        for (double x : q) mean += x;
+        mean /= static_cast<double>(q.size());
+        double ss = 0.0;
+        for (double x : q) ss += (x - mean) * (x - mean);
+        const double var = q.size() < 2 ? 0.0 : ss / static_cast<double>(q.size() - 1);
+
+        if (window.samples(i) != q.size() || !mean_close(window.mean(i), mean) ||
+            !variance_close(window.variance(i), var, mean)) {
+            std::printf("RollingWindow mismatch at update %d, symbol %zu: samples %zu/%zu mean %.9f/%.9f "
+                        "variance %.9f/%.9f\n",
+                        u, i, window.samples(i), q.size(), window.mean(i), mean, window.variance(i), var);
+            return 1;
+        }
+    }
+    std::printf("RollingWindow<%zu>: %zu symbols x %d updates match the naive recompute\n", kWindow, kSymbols,
+                kUpdates);
+    return 0;
+}
+
+}  // namespace
+}  // namespace hft
+
+int main() {
+    return hft::run();
+}
@@ -1,29 +1,56 @@
 #include <arpa/inet.h>
 #include <errno.h>
 #include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
 #include <sys/socket.h>
 #include <unistd.h>
 
+#include <algorithm>
 #include <chrono>
 #include <cstring>
+#include <ctime>
+#include <deque>
 #include <iostream>
-#include <optional>
+#include <memory>
+#include <random>
+#include <span>
 #include <string>
-#include <thread>
 #include <vector>
 
 #include "hft_common.h"
+#include "matching_engine.h"
 #include "protocol.h"
+#include "timer_wheel.h"
+#include "transport.h"
 
 using namespace hft;
 
+struct SimExConfig {
+    int64_t ack_delay_ns = 0;   // receipt -> order reaches the book (Ack, immediate fills)
+    int64_t fill_delay_ns = 0;  // match -> fill report leaves
+    int64_t taker_gap_ns = 0;   // mean gap between synthetic taker orders; 0: none
+    int64_t taker_qty = 1;
+};
+
+// Exchange simulator. One event-loop thread serves any number of OMS connections:
+// every connection's wait_fd() sits in one epoll, orders go through a price-time
+// priority book per symbol (new, cancel and replace), and latency is injected by
+// parking work on a timer wheel rather than sleeping, so a slow order never holds up
+// another. Reports produced in one loop iteration leave in one write per connection.
+//
+// The books otherwise only ever hold the clients' own orders, so SimEx can also play
+// the rest of the market: at Poisson-spaced times a synthetic taker steps a per-symbol
+// price walk around a random book's mid and sends an IOC at the walk price whenever it
+// crosses the touch, filling whatever resting quotes it reaches.
+template <typename Conn>
 class SimExServer {
 public:
-    SimExServer(int port, int ack_delay_us, int fill_delay_us)
-        : port_(port), ack_delay_us_(ack_delay_us), fill_delay_us_(fill_delay_us) {}
+    SimExServer(int port, SimExConfig cfg, TransportOptions transport)
+        : port_(port), cfg_(cfg), transport_(transport), timers_(kTimerTickNs, now_ns()) {}
 
     void run() {
-        int listen_fd = ::socket(AF_INET, SOCK_STREAM, 0);
+        int listen_fd = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
         if (listen_fd < 0) {
             perror("socket");
             return;
@@ -40,94 +67,505 @@ public:
             close(listen_fd);
             return;
         }
-        if (listen(listen_fd, 8) < 0) {
+        if (listen(listen_fd, 128) < 0) {
             perror("listen");
             close(listen_fd);
             return;
         }
-        std::cout << "SimEx listening on " << port_ << " ack_delay_us=" << ack_delay_us_
-                  << " fill_delay_us=" << fill_delay_us_ << std::endl;
+        epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+        if (epoll_fd_ < 0) {
+            perror("epoll_create1");
+            close(listen_fd);
+            return;
+        }
+        epoll_event lev{};
+        lev.events = EPOLLIN;
+        lev.data.u64 = kListenTag;
+        epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, listen_fd, &lev);
+
+        if (cfg_.taker_gap_ns > 0) schedule_taker(now_ns());
+        std::cout << "SimEx listening on " << port_ << " ack_delay_us=" << cfg_.ack_delay_ns / 1000
+                  << " fill_delay_us=" << cfg_.fill_delay_ns / 1000 << " taker_us=" << cfg_.taker_gap_ns / 1000
+                  << std::endl;
+        loop(listen_fd);
+        close(epoll_fd_);
+        close(listen_fd);
+    }
+
+private:
+    static constexpr uint64_t kListenTag = UINT64_MAX;
+    static constexpr int64_t kTimerTickNs = 1'000;
+    // Busy-polled transports: how often the listening socket and hang-ups are checked,
+    // and how long every session must be idle before SimEx may sleep.
+    static constexpr int64_t kFdCheckNs = 1'000'000;
+    static constexpr int64_t kSpinNs = 50'000;
+    static constexpr uint32_t kMaxSymbols = 16384;
+    // Reports queued behind a full connection before the client is cut off.
+    static constexpr size_t kMaxBacklog = size_t{1} << 20;
+    // How long a client's connection may take to set up (shm) before it is dropped.
+    static constexpr int64_t kSetupTimeoutNs = 2'000'000'000;
+    // Owner of the synthetic taker's orders; no session handle has slot UINT32_MAX - 1,
+    // so their reports find no session and are dropped.
+    static constexpr uint64_t kTakerOwner = UINT64_MAX - 1;
+    // How far the taker's walk may stray from a book's mid, in steps of half its spread.
+    static constexpr int64_t kTakerMaxSteps = 4;
+
+    struct Session {
+        explicit Session(TransportOptions opts) : conn(opts) {}
 
+        Conn conn;
+        std::vector<WireExecReport> backlog;  // waiting for room in conn, in order
+        bool dirty = false;                   // on dirty_, has something to write
+        uint64_t orders = 0;
+        // Latest due time of a report parked for this session. Later reports never
+        // leave before it, so a delayed fill cannot be overtaken by the cancel after it.
+        int64_t reports_due_ns = 0;
+    };
+
+    // An inbound new/cancel/replace, decoded once.
+    struct Request {
+        OrderAction action = OrderAction::New;
+        uint32_t symbol_id = 0;
+        MatchOrder order;  // cancel: owner and cl_ord_id; replace: also px and qty
+    };
+
+    struct PendingSetup {
+        uint64_t handle = 0;
+        int64_t deadline_ns = 0;
+    };
+
+    // The synthetic taker's price walk for one symbol; zeros until the book first has
+    // both sides.
+    struct TakerWalk {
+        int64_t px = 0;
+        int64_t mid = 0;
+        int64_t step = 0;  // half the spread
+    };
+
+    // Work parked on the wheel: a request on its way to the book, a report on its way
+    // back, or the synthetic taker's next order.
+    struct Timer {
+        enum class Kind : uint8_t { Arrive, Deliver, Taker } kind = Kind::Arrive;
+        uint32_t symbol_id = 0;
+        int64_t recv_ns = 0;
+        Request request{};
+        MatchEvent event{};
+    };
+
+    void loop(int listen_fd) {
+        int64_t stats_at_ns = now_ns() + 1'000'000'000;
+        int64_t fds_at_ns = 0;
+        int64_t idle_since_ns = 0;
         for (;;) {
-            int client_fd = accept(listen_fd, nullptr, nullptr);
-            if (client_fd < 0) {
-                if (errno == EINTR) continue;
-                perror("accept");
-                break;
+            if constexpr (Conn::kBusyPoll) {
+                // Frames do not wake epoll: every session is polled each pass, and the
+                // listening socket and hang-ups are looked at every kFdCheckNs.
+                const bool got_frames = poll_sessions();
+                const int64_t now = now_ns();
+                if (now >= fds_at_ns) {
+                    fds_at_ns = now + kFdCheckNs;
+                    timespec zero{};
+                    if (!wait_fds(listen_fd, &zero)) return;
+                }
+                if (got_frames || !dirty_.empty()) {
+                    idle_since_ns = 0;
+                } else if (idle_since_ns == 0) {
+                    idle_since_ns = now;
+                } else if (now - idle_since_ns >= kSpinNs) {
+                    const int64_t due = timers_.next_due_ns();
+                    const int64_t until = due >= 0 ? std::min(due, fds_at_ns) : fds_at_ns;
+                    if (until > now) Conn::park_any(live_conns_, until - now);
+                }
+            } else {
+                timespec ts{};
+                timespec* timeout = nullptr;
+                int64_t due = timers_.next_due_ns();
+                if (!setups_.empty() && (due < 0 || setups_.front().deadline_ns < due)) {
+                    due = setups_.front().deadline_ns;
+                }
+                if (due >= 0) {
+                    const int64_t wait = std::max<int64_t>(0, due - now_ns());
+                    ts.tv_sec = wait / 1'000'000'000;
+                    ts.tv_nsec = wait % 1'000'000'000;
+                    timeout = &ts;
+                }
+                if (!wait_fds(listen_fd, timeout)) return;
+            }
+            timers_.advance(now_ns(), [this](const Timer& t) { on_timer(t); });
+            expire_setups(now_ns());
+            flush_sessions();
+
+            if (const int64_t now = now_ns(); now >= stats_at_ns) {
+                print_stats(now - stats_at_ns + 1'000'000'000);
+                stats_at_ns = now + 1'000'000'000;
             }
-            handle_client(client_fd);
-            close(client_fd);
         }
-        close(listen_fd);
     }
 
-private:
-    void handle_client(int fd) {
-        std::cout << "Client connected\n";
-        std::vector<uint8_t> buf;
-        uint8_t tmp[2048];
-        while (true) {
-            ssize_t n = recv(fd, tmp, sizeof(tmp), 0);
-            if (n < 0) {
+    // Waits up to timeout (nullptr: forever) for new clients or session activity and
+    // handles it; false on an epoll failure.
+    bool wait_fds(int listen_fd, timespec* timeout) {
+        constexpr int kMaxEvents = 64;
+        epoll_event events[kMaxEvents];
+        int nfds = epoll_pwait2(epoll_fd_, events, kMaxEvents, timeout, nullptr);
+        if (nfds < 0) {
+            if (errno == EINTR) return true;
+            perror("epoll_pwait2");
+            return false;
+        }
+        for (int i = 0; i < nfds; ++i) {
+            const uint64_t handle = events[i].data.u64;
+            if (handle == kListenTag) {
+                accept_clients(listen_fd);
+            } else if (Session* s = lookup(handle)) {
+                poll_session(handle, *s);
+            }
+        }
+        return true;
+    }
+
+    // Busy-polled transports: polls every set-up session once; true if any had frames.
+    // Also collects the live connections, for parking on them all. Sessions still
+    // setting up are moved on by wait_fds() as their sockets become readable.
+    bool poll_sessions() {
+        const uint64_t orders = orders_;
+        live_conns_.clear();
+        for (uint32_t slot = 0; slot < sessions_.size(); ++slot) {
+            if (!sessions_[slot] || !sessions_[slot]->conn.established()) continue;
+            const uint64_t handle = (uint64_t{generations_[slot]} << 32) | slot;
+            if (poll_session(handle, *sessions_[slot])) live_conns_.push_back(&sessions_[slot]->conn);
+        }
+        return orders_ != orders;
+    }
+
+    // False if the session was closed.
+    bool poll_session(uint64_t handle, Session& s) {
+        const auto on_frame = [&](std::span<const uint8_t> payload) { on_order(handle, s, payload); };
+        if (s.conn.poll(0, on_frame)) return true;
+        close_session(handle);
+        return false;
+    }
+
+    void accept_clients(int listen_fd) {
+        for (;;) {
+            int fd = accept4(listen_fd, nullptr, nullptr, SOCK_CLOEXEC);
+            if (fd < 0) {
                 if (errno == EINTR) continue;
-                perror("recv");
+                if (errno != EAGAIN && errno != EWOULDBLOCK) perror("accept4");
+                return;
+            }
+            int one = 1;
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+            uint32_t slot;
+            if (!free_slots_.empty()) {
+                slot = free_slots_.back();
+                free_slots_.pop_back();
+            } else {
+                slot = static_cast<uint32_t>(sessions_.size());
+                sessions_.emplace_back();
+                generations_.push_back(0);
+            }
+            sessions_[slot] = std::make_unique<Session>(transport_);
+            const uint64_t handle = (uint64_t{generations_[slot]} << 32) | slot;
+            Session& s = *sessions_[slot];
+            if (!s.conn.attach(fd)) {
+                release_slot(slot);
+                continue;
+            }
+            epoll_event ev{};
+            ev.events = EPOLLIN;
+            ev.data.u64 = handle;
+            epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, s.conn.wait_fd(), &ev);
+            if (!s.conn.established()) setups_.push_back(PendingSetup{handle, now_ns() + kSetupTimeoutNs});
+            std::cout << "Client connected (" << ++connected_ << " connected)\n";
+        }
+    }
+
+    // Drops clients whose connections are still not set up by their deadline. Deadlines
+    // are in accept order, so only the front needs looking at.
+    void expire_setups(int64_t now) {
+        while (!setups_.empty()) {
+            const PendingSetup p = setups_.front();
+            Session* s = lookup(p.handle);
+            if (s != nullptr && !s->conn.established()) {
+                if (now < p.deadline_ns) return;
+                std::cerr << "client connection not set up in time, dropping it\n";
+                close_session(p.handle);
+            }
+            setups_.pop_front();
+        }
+    }
+
+    // Handles carry the slot's generation, so a report for a client that has gone
+    // (and whose slot was reused) is dropped instead of misdelivered.
+    Session* lookup(uint64_t handle) {
+        const auto slot = static_cast<uint32_t>(handle);
+        if (slot >= sessions_.size() || generations_[slot] != static_cast<uint32_t>(handle >> 32)) return nullptr;
+        return sessions_[slot].get();
+    }
+
+    void close_session(uint64_t handle) {
+        const auto slot = static_cast<uint32_t>(handle);
+        Session& s = *sessions_[slot];
+        epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, s.conn.wait_fd(), nullptr);
+        // Its quotes go with it, so nobody trades against an owner who cannot hear.
+        size_t pulled = 0;
+        for (auto& book : books_) pulled += book.cancel_owner(handle);
+        std::cout << "Client disconnected after " << s.orders << " orders, " << pulled << " resting pulled ("
+                  << --connected_ << " connected)\n";
+        release_slot(slot);
+    }
+
+    void release_slot(uint32_t slot) {
+        sessions_[slot].reset();
+        ++generations_[slot];
+        free_slots_.push_back(slot);
+    }
+
+    void on_order(uint64_t handle, Session& s, std::span<const uint8_t> payload) {
+        Request req;
+        req.order.owner = handle;
+        switch (frame_msg_type(payload)) {
+            case kMsgNewOrder: {
+                WireNewOrder w;
+                if (!decode_frame(payload, kMsgNewOrder, w)) return;
+                req.action = OrderAction::New;
+                req.symbol_id = w.symbol_id;
+                req.order.cl_ord_id = w.cl_ord_id;
+                req.order.md_event_id = w.md_event_id;
+                req.order.side = w.side == 0 ? Side::Buy : Side::Sell;
+                req.order.type = static_cast<OrderType>(w.ord_type);
+                req.order.tif = static_cast<TimeInForce>(w.tif);
+                req.order.px = w.px;
+                req.order.qty = w.qty;
+                if (w.ord_type > static_cast<uint8_t>(OrderType::Market) ||
+                    w.tif > static_cast<uint8_t>(TimeInForce::IOC)) {
+                    req.order.qty = 0;  // rejected by the book
+                }
                 break;
             }
-            if (n == 0) break;
-            buf.insert(buf.end(), tmp, tmp + n);
-            parse_messages(fd, buf);
+            case kMsgCancel: {
+                WireCancel w;
+                if (!decode_frame(payload, kMsgCancel, w)) return;
+                req.action = OrderAction::Cancel;
+                req.symbol_id = w.symbol_id;
+                req.order.cl_ord_id = w.cl_ord_id;
+                break;
+            }
+            case kMsgReplace: {
+                WireReplace w;
+                if (!decode_frame(payload, kMsgReplace, w)) return;
+                req.action = OrderAction::Replace;
+                req.symbol_id = w.symbol_id;
+                req.order.cl_ord_id = w.cl_ord_id;
+                req.order.px = w.px;
+                req.order.qty = w.qty;
+                break;
+            }
+            default:
+                return;
+        }
+        ++s.orders;
+        ++orders_;
+        const int64_t now = now_ns();
+        if (cfg_.ack_delay_ns > 0) {
+            Timer t;
+            t.kind = Timer::Kind::Arrive;
+            t.recv_ns = now;
+            t.request = req;
+            timers_.schedule(now + cfg_.ack_delay_ns, t);
+        } else {
+            arrive(req, now);
         }
-        std::cout << "Client disconnected\n";
     }
 
-    void parse_messages(int fd, std::vector<uint8_t>& buf) {
-        size_t offset = 0;
-        std::vector<uint8_t> payload;
-        while (unpack_frame(buf, offset, payload)) {
-            if (payload.size() < sizeof(WireNewOrder)) continue;
-            WireNewOrder w{};
-            std::memcpy(&w, payload.data(), sizeof(WireNewOrder));
-            if (w.hdr.magic != kProtocolMagic || w.hdr.msg_type != kMsgNewOrder) continue;
-            handle_new_order(fd, w);
+    void on_timer(const Timer& t) {
+        switch (t.kind) {
+            case Timer::Kind::Arrive: arrive(t.request, t.recv_ns); break;
+            case Timer::Kind::Deliver: deliver(t.symbol_id, t.event, t.recv_ns); break;
+            case Timer::Kind::Taker:
+                take(static_cast<uint32_t>(rng_() % std::max<size_t>(books_.size(), 1)));
+                schedule_taker(now_ns());
+                break;
         }
-        buf.erase(buf.begin(), buf.begin() + offset);
     }
 
-    void handle_new_order(int fd, const WireNewOrder& w) {
-        int64_t recv_ts = now_ns();
-        if (ack_delay_us_ > 0) std::this_thread::sleep_for(std::chrono::microseconds(ack_delay_us_));
-        send_report(fd, w, ExecType::Ack, 0, 0, recv_ts);
-        if (fill_delay_us_ > 0) std::this_thread::sleep_for(std::chrono::microseconds(fill_delay_us_));
-        send_report(fd, w, ExecType::Fill, w.px, w.qty, recv_ts);
+    void schedule_taker(int64_t now) {
+        std::exponential_distribution<double> gap(1.0 / static_cast<double>(cfg_.taker_gap_ns));
+        Timer t;
+        t.kind = Timer::Kind::Taker;
+        timers_.schedule(now + static_cast<int64_t>(gap(rng_)), t);
+    }
+
+    // One step of the symbol's walk; an IOC at the walk price if it is through the touch.
+    // The walk stays around the mid of the last time the book had both sides, so a
+    // client that pulls one side still gets hit on the other. Until then it is skipped.
+    void take(uint32_t symbol_id) {
+        if (symbol_id >= books_.size()) return;
+        MatchingBook& book = books_[symbol_id];
+        const int64_t bid = book.best_bid();
+        const int64_t ask = book.best_ask();
+        TakerWalk& w = taker_walks_[symbol_id];
+        if (bid != 0 && ask != 0) {
+            w.mid = (bid + ask) / 2;
+            w.step = std::max<int64_t>(1, (ask - bid) / 2);
+            if (w.px == 0) w.px = w.mid;
+        }
+        if (w.px == 0 || (bid == 0 && ask == 0)) return;
+        w.px += (rng_() & 1) != 0 ? w.step : -w.step;
+        w.px = std::clamp(w.px, w.mid - kTakerMaxSteps * w.step, w.mid + kTakerMaxSteps * w.step);
+        const bool buy = ask != 0 && w.px >= ask;
+        const bool sell = bid != 0 && w.px <= bid;
+        if (!buy && !sell) return;
+
+        MatchOrder o;
+        o.owner = kTakerOwner;
+        o.cl_ord_id = ++taker_orders_;
+        o.side = buy ? Side::Buy : Side::Sell;
+        o.tif = TimeInForce::IOC;
+        o.px = w.px;
+        o.qty = cfg_.taker_qty;
+        const int64_t now = now_ns();
+        book.submit(o, [&](const MatchEvent& ev) {
+            if (ev.owner == kTakerOwner) {
+                if (ev.type == ExecType::Fill || ev.type == ExecType::PartialFill) taker_filled_ += ev.qty;
+                return;
+            }
+            report(symbol_id, ev, now);
+        });
     }
 
-    void send_report(int fd, const WireNewOrder& w, ExecType type, int64_t fill_px, int64_t fill_qty, int64_t t_recv) {
+    // The request reaches its book; every resulting event becomes a report. One still
+    // on the wheel when its client went is dropped, so it cannot rest orphaned.
+    void arrive(const Request& req, int64_t recv_ns) {
+        const MatchOrder& o = req.order;
+        if (lookup(o.owner) == nullptr) return;
+        if (req.symbol_id >= kMaxSymbols) {
+            const ExecType type = req.action == OrderAction::New ? ExecType::Reject : ExecType::CancelReject;
+            report(req.symbol_id, MatchEvent{o.owner, o.cl_ord_id, o.md_event_id, type, 0, 0, 0}, recv_ns);
+            return;
+        }
+        if (req.symbol_id >= books_.size()) {
+            books_.resize(req.symbol_id + 1);
+            taker_walks_.resize(req.symbol_id + 1);
+        }
+        MatchingBook& book = books_[req.symbol_id];
+        const auto on_event = [&](const MatchEvent& ev) { report(req.symbol_id, ev, recv_ns); };
+        switch (req.action) {
+            case OrderAction::New: book.submit(o, on_event); break;
+            case OrderAction::Cancel: book.cancel(o.owner, o.cl_ord_id, on_event); break;
+            case OrderAction::Replace: book.replace(o.owner, o.cl_ord_id, o.px, o.qty, on_event); break;
+        }
+    }
+
+    // Fill reports wait fill_delay; everything else goes now, unless an earlier report
+    // for the same session is still parked, in which case it queues behind it.
+    void report(uint32_t symbol_id, const MatchEvent& ev, int64_t recv_ns) {
+        Session* s = lookup(ev.owner);
+        if (s == nullptr) return;
+        const bool fill = ev.type == ExecType::Fill || ev.type == ExecType::PartialFill;
+        const int64_t now = now_ns();
+        const int64_t due = std::max(now + (fill ? cfg_.fill_delay_ns : 0), s->reports_due_ns);
+        if (due <= now) {
+            deliver(symbol_id, ev, recv_ns);
+            return;
+        }
+        s->reports_due_ns = due;
+        Timer t;
+        t.kind = Timer::Kind::Deliver;
+        t.symbol_id = symbol_id;
+        t.recv_ns = recv_ns;
+        t.event = ev;
+        timers_.schedule(due, t);
+    }
+
+    void deliver(uint32_t symbol_id, const MatchEvent& ev, int64_t recv_ns) {
+        Session* s = lookup(ev.owner);
+        if (s == nullptr) return;
         WireExecReport rep{};
-        rep.hdr.msg_type = kMsgExecReport;
-        rep.hdr.magic = kProtocolMagic;
-        rep.cl_ord_id = w.cl_ord_id;
-        rep.md_event_id = w.md_event_id;
-        rep.exec_type = static_cast<uint8_t>(type);
-        rep.fill_px = fill_px;
-        rep.fill_qty = fill_qty;
-        rep.t_sim_recv_ns = t_recv;
+        rep.symbol_id = symbol_id;
+        rep.cl_ord_id = ev.cl_ord_id;
+        rep.md_event_id = ev.md_event_id;
+        rep.exec_type = static_cast<uint8_t>(ev.type);
+        rep.fill_px = ev.px;
+        rep.fill_qty = ev.qty;
+        rep.leaves_qty = ev.leaves;
+        rep.t_sim_recv_ns = recv_ns;
         rep.t_sim_send_ns = now_ns();
-        auto frame = pack_with_length(&rep, sizeof(rep));
-        size_t sent = 0;
-        while (sent < frame.size()) {
-            ssize_t n = send(fd, frame.data() + sent, frame.size() - sent, 0);
-            if (n < 0) {
-                if (errno == EINTR) continue;
-                perror("send");
-                break;
+        if (s->backlog.empty() && s->conn.can_send(sizeof(rep))) {
+            s->conn.send(rep);
+        } else {
+            s->backlog.push_back(rep);
+        }
+        ++reports_;
+        if (!s->dirty) {
+            s->dirty = true;
+            dirty_.push_back(ev.owner);
+        }
+    }
+
+    // Writes each connection touched this iteration; keeps the ones with bytes still
+    // pending (socket full, or an io_uring write in flight) for the next pass.
+    void flush_sessions() {
+        size_t keep = 0;
+        for (const uint64_t handle : dirty_) {
+            Session* s = lookup(handle);
+            if (s == nullptr) continue;
+            size_t moved = 0;
+            while (moved < s->backlog.size() && s->conn.can_send(sizeof(WireExecReport))) {
+                s->conn.send(s->backlog[moved++]);
+            }
+            s->backlog.erase(s->backlog.begin(), s->backlog.begin() + static_cast<std::ptrdiff_t>(moved));
+            if (s->conn.flushable()) s->conn.flush();
+            if (s->backlog.size() > kMaxBacklog) {
+                std::cerr << "slow consumer, dropping client\n";
+                close_session(handle);
+                continue;
             }
-            sent += static_cast<size_t>(n);
+            s->dirty = !s->backlog.empty() || !s->conn.empty();
+            if (s->dirty) dirty_[keep++] = handle;
         }
+        dirty_.resize(keep);
+    }
+
+    void print_stats(int64_t window_ns) {
+        if (orders_ == last_orders_) return;
+        const double secs = static_cast<double>(window_ns) / 1e9;
+        size_t resting = 0;
+        for (const auto& book : books_) resting += book.resting();
+        std::cout << "orders/s=" << static_cast<uint64_t>(static_cast<double>(orders_ - last_orders_) / secs)
+                  << " reports/s=" << static_cast<uint64_t>(static_cast<double>(reports_ - last_reports_) / secs)
+                  << " resting=" << resting << " timers=" << timers_.size();
+        if (cfg_.taker_gap_ns > 0) std::cout << " taker_filled=" << taker_filled_ - last_taker_filled_;
+        std::cout << std::endl;
+        last_orders_ = orders_;
+        last_reports_ = reports_;
+        last_taker_filled_ = taker_filled_;
     }
 
     int port_;
-    int ack_delay_us_;
-    int fill_delay_us_;
+    SimExConfig cfg_;
+    TransportOptions transport_;
+    int epoll_fd_ = -1;
+    std::vector<std::unique_ptr<Session>> sessions_;
+    std::vector<uint32_t> generations_;
+    std::vector<uint32_t> free_slots_;
+    std::vector<uint64_t> dirty_;
+    std::vector<Conn*> live_conns_;  // busy-polled transports, as of the last pass
+    std::deque<PendingSetup> setups_;  // sessions accepted but not yet set up
+    std::vector<MatchingBook> books_;  // by symbol_id
+    std::vector<TakerWalk> taker_walks_;  // by symbol_id
+    TimerWheel<Timer> timers_;
+    std::mt19937_64 rng_{42};
+    uint64_t taker_orders_ = 0;
+    int64_t taker_filled_ = 0;
+    int64_t last_taker_filled_ = 0;
+    size_t connected_ = 0;
+    uint64_t orders_ = 0;
+    uint64_t reports_ = 0;
+    uint64_t last_orders_ = 0;
+    uint64_t last_reports_ = 0;
 };
 
 int main(int argc, char* argv[]) {
@@ -135,7 +573,37 @@ int main(int argc, char* argv[]) {
     int fill_delay_us = 400;
     if (argc > 1) ack_delay_us = std::stoi(argv[1]);
     if (argc > 2) fill_delay_us = std::stoi(argv[2]);
-    SimExServer server(kSimPort, ack_delay_us, fill_delay_us);
-    server.run();
+    TransportKind transport = TransportKind::Epoll;
+    if (argc > 3 && !parse_transport(argv[3], transport)) {
+        std::cerr << "transport must be epoll, uring, uring-sqpoll, shm or shm-futex\n";
+        return 1;
+    }
+    int taker_us = 0;
+    int taker_qty = 1;
+    if (argc > 4) taker_us = std::stoi(argv[4]);
+    if (argc > 5) taker_qty = std::stoi(argv[5]);
+    if (taker_us < 0 || taker_qty <= 0) {
+        std::cerr << "taker_us must be >= 0 and taker_qty > 0\n";
+        return 1;
+    }
+    const SimExConfig cfg{int64_t{ack_delay_us} * 1000, int64_t{fill_delay_us} * 1000, int64_t{taker_us} * 1000,
+                          taker_qty};
+    switch (transport) {
+        case TransportKind::Epoll:
+            SimExServer<EpollConnection>(kSimPort, cfg, {}).run();
+            break;
+        case TransportKind::Uring:
+            SimExServer<UringConnection>(kSimPort, cfg, {}).run();
+            break;
+        case TransportKind::UringSqpoll:
+            SimExServer<UringConnection>(kSimPort, cfg, {.sqpoll = true}).run();
+            break;
+        case TransportKind::Shm:
+            SimExServer<ShmConnection>(kSimPort, cfg, {}).run();
+            break;
+        case TransportKind::ShmFutex:
+            SimExServer<ShmConnection>(kSimPort, cfg, {.futex = true}).run();
+            break;
+    }
     return 0;
 }